@@ -0,0 +1,83 @@
+#include <db/BTreeFile.hpp>
+#include <db/Database.hpp>
+#include <db/HeapFile.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <string>
+
+// Index build: a heap file of shuffled (or sorted) tuples is indexed by inserting its tuples one at a time, and by
+// bulk loading it. The build times, the sizes of the trees and the lookups of every key are compared.
+
+static double since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void build(const db::HeapFile &in, const std::string &name, bool bulk, double fill) {
+    std::remove(name.c_str());
+    db::Database &database = db::getDatabase();
+    database.add(std::make_unique<db::BTreeFile>(name, in.getTupleDesc(), 0));
+    auto &file = dynamic_cast<db::BTreeFile &>(database.get(name));
+
+    auto start = std::chrono::steady_clock::now();
+    if (bulk) {
+        file.bulkLoad(in, fill);
+    } else {
+        in.scan([&](const db::TupleView &t) { file.insertTuple(t.materialize()); });
+    }
+    database.getBufferPool().flushFile(name);
+    double build_ms = since(start);
+
+    start = std::chrono::steady_clock::now();
+    size_t found = 0;
+    in.scan([&](const db::TupleView &t) { found += file.find(t.get_int(0)) != file.end(); });
+    double find_ms = since(start);
+
+    std::printf("  %-22s build %9.1f ms   %7zu pages   %7zu writes   find all %8.1f ms (%zu found)\n",
+                bulk ? (fill == 1.0 ? "bulkLoad" : "bulkLoad (fill 0.7)") : "insertTuple", build_ms,
+                file.getNumPages(), file.getWrites().size(), find_ms, found);
+    database.remove(name);
+    std::remove(name.c_str());
+}
+
+static void bench(size_t tuples, bool sorted) {
+    // The pages of a removed file stay in the buffer pool, so every file gets a new name
+    const std::string prefix = sorted ? "bench_sorted" : "bench_shuffled";
+    const std::string in_name = prefix + ".db";
+    std::remove(in_name.c_str());
+    std::remove((in_name + ".fsm").c_str());
+    db::TupleDesc td({db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE}, {"id", "name", "price"});
+    db::Database &database = db::getDatabase();
+    database.add(std::make_unique<db::HeapFile>(in_name, td));
+    auto &in = dynamic_cast<db::HeapFile &>(database.get(in_name));
+
+    std::vector<int> keys(tuples);
+    std::iota(keys.begin(), keys.end(), 0);
+    if (!sorted) {
+        std::shuffle(keys.begin(), keys.end(), std::mt19937(42));
+    }
+    std::vector<db::Tuple> batch;
+    for (int k: keys) {
+        batch.push_back({{k, "label" + std::to_string(k % 100000), k * 0.5}});
+    }
+    in.insertBatch(batch);
+    batch.clear();
+
+    std::printf("%zu %s tuples (%zu heap pages)\n", tuples, sorted ? "sorted" : "shuffled", in.getNumPages());
+    build(in, prefix + "_insert.db", false, 1.0);
+    build(in, prefix + "_bulk.db", true, 1.0);
+    build(in, prefix + "_bulk70.db", true, 0.7);
+    database.remove(in_name);
+    std::remove(in_name.c_str());
+    std::remove((in_name + ".fsm").c_str());
+}
+
+int main(int argc, char **argv) {
+    size_t tuples = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000000;
+    db::getDatabase().getBufferPool().resize(1024);
+    bench(tuples, true);
+    bench(tuples, false);
+}
@@ -0,0 +1,103 @@
+#include <db/Database.hpp>
+#include <db/PageTable.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <unordered_map>
+
+// Counts heap allocations, to check that the hit path of BufferPool::getPage does not allocate
+static size_t allocations = 0;
+
+void *operator new(size_t size) {
+    allocations++;
+    if (void *p = std::malloc(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+template<typename F>
+static void measure(const char *name, size_t ops, F &&f) {
+    size_t before = allocations;
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+    std::printf("%-32s %8.1f ns/op %8.3f allocations/op\n", name, ns / ops,
+                static_cast<double>(allocations - before) / ops);
+}
+
+int main(int argc, char **argv) {
+    size_t numPages = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4096;
+    size_t ops = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 10000000;
+
+    const char *name = "bench.db";
+    std::remove(name);
+    db::Database &database = db::getDatabase();
+    database.add(std::make_unique<db::DbFile>(name, db::TupleDesc()));
+    size_t file = database.get(name).getId();
+    db::BufferPool &bufferPool = database.getBufferPool();
+    bufferPool.resize(numPages);
+
+    std::mt19937_64 rng(42);
+    std::vector<db::PageId> random(ops);
+    for (auto &pid: random) {
+        pid = {file, rng() % numPages};
+    }
+    for (size_t page = 0; page < numPages; page++) {
+        bufferPool.getPage({file, page});
+    }
+    std::printf("%zu resident pages, %zu operations\n", numPages, ops);
+
+    uint64_t sum = 0;
+    measure("getPage hit (sequential)", ops, [&] {
+        for (size_t i = 0; i < ops; i++) {
+            sum += bufferPool.getPage({file, i % numPages})[0];
+        }
+    });
+    measure("getPage hit (random)", ops, [&] {
+        for (const auto &pid: random) {
+            sum += bufferPool.getPage(pid)[0];
+        }
+    });
+    measure("pinPage/unpinPage hit (random)", ops, [&] {
+        for (const auto &pid: random) {
+            db::Page &page = bufferPool.pinPage(pid);
+            sum += page[0];
+            bufferPool.unpinPage(page);
+        }
+    });
+    size_t misses = std::min<size_t>(ops, 1000000);
+    measure("getPage miss (sequential)", misses, [&] {
+        for (size_t i = 0; i < misses; i++) {
+            sum += bufferPool.getPage({file, numPages + i})[0];
+        }
+    });
+
+    // The page table alone, against the node-based map it replaced
+    db::PageTable table;
+    std::unordered_map<const db::PageId, size_t> map;
+    for (size_t page = 0; page < numPages; page++) {
+        table.insert({file, page}, page);
+        map[{file, page}] = page;
+    }
+    measure("PageTable::find", ops, [&] {
+        for (const auto &pid: random) {
+            sum += *table.find(pid);
+        }
+    });
+    measure("std::unordered_map::find", ops, [&] {
+        for (const auto &pid: random) {
+            sum += map.find(pid)->second;
+        }
+    });
+
+    std::printf("checksum %llu\n", static_cast<unsigned long long>(sum));
+    std::remove(name);
+}
@@ -0,0 +1,92 @@
+#include <db/Checksum.hpp>
+#include <db/Database.hpp>
+#include <db/DbFile.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+// The cost of page checksums: the CRC32C of a page alone, then reading and writing the pages of a file (from the
+// kernel page cache, the worst case for the relative cost) with and without checksums. Pages read from the BufferPool
+// are not verified, so they are not measured.
+
+static constexpr size_t BATCH = 64;
+
+static double elapsed(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void io(bool checksums, size_t pages, size_t rounds) {
+    const char *name = "bench_checksum.db";
+    std::remove(name);
+    std::remove((std::string(name) + ".crc").c_str());
+    db::TupleDesc td({db::type_t::INT}, {"id"});
+    db::DbFileOptions options;
+    options.checksums = checksums;
+    db::DbFile file(name, td, options);
+
+    std::mt19937_64 rng(42);
+    std::vector<db::Page> buffers(BATCH);
+    for (db::Page &page: buffers) {
+        for (uint8_t &byte: page) {
+            byte = static_cast<uint8_t>(rng());
+        }
+    }
+    std::vector<std::pair<size_t, const db::Page *>> writes;
+    std::vector<std::pair<size_t, db::Page *>> reads;
+    auto write = [&] {
+        for (size_t first = 0; first < pages; first += BATCH) {
+            writes.clear();
+            for (size_t i = 0; i < BATCH; i++) {
+                writes.emplace_back(first + i, &buffers[i]);
+            }
+            file.writePages(writes);
+        }
+    };
+    // The file is written once before it is timed, so that the pages are overwritten instead of allocated
+    write();
+    auto start = std::chrono::steady_clock::now();
+    write();
+    double write_ns = elapsed(start) / static_cast<double>(pages);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < rounds; round++) {
+        for (size_t first = 0; first < pages; first += BATCH) {
+            reads.clear();
+            for (size_t i = 0; i < BATCH; i++) {
+                reads.emplace_back(first + i, &buffers[i]);
+            }
+            file.readPages(reads);
+        }
+    }
+    double read_ns = elapsed(start) / static_cast<double>(pages * rounds);
+    std::printf("%-13s %8.0f ns/page written %8.0f ns/page read\n", checksums ? "checksums" : "no checksums",
+                write_ns, read_ns);
+    std::remove(name);
+    std::remove((std::string(name) + ".crc").c_str());
+}
+
+int main(int argc, char **argv) {
+    size_t pages = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 16384;
+    size_t rounds = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 10;
+    pages = (pages + BATCH - 1) / BATCH * BATCH;
+
+    db::Page page;
+    std::mt19937_64 rng(42);
+    for (uint8_t &byte: page) {
+        byte = static_cast<uint8_t>(rng());
+    }
+    constexpr size_t CRCS = 1 << 18;
+    uint32_t crc = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < CRCS; i++) {
+        crc = db::crc32c(page.data(), page.size(), crc);
+    }
+    double crc_ns = elapsed(start) / CRCS;
+    std::printf("crc32c (%s): %.0f ns/page, %.1f GB/s (%08x)\n", db::crc32cAccelerated() ? "sse4.2" : "software",
+                crc_ns, page.size() / crc_ns, crc);
+
+    std::printf("%zu pages, %zu pages per batch\n", pages, BATCH);
+    io(false, pages, rounds);
+    io(true, pages, rounds);
+}
@@ -0,0 +1,61 @@
+#include <db/Database.hpp>
+#include <db/HeapFile.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+
+// Cold scans of a table with short strings in CHAR fields (mostly zero padding), stored raw or compressed. The table
+// is larger than the buffer pool, so every scan reads all the pages from the file (from the kernel page cache, which
+// favors the raw file: reading from a device, the compressed file also reads several times fewer bytes).
+
+static constexpr int SCANS = 5;
+
+static void scan(bool compressed, size_t tuples) {
+    const char *name = compressed ? "bench_compressed.db" : "bench_raw.db";
+    std::remove(name);
+    std::remove((std::string(name) + ".fsm").c_str());
+    db::TupleDesc td({db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE}, {"id", "name", "price"});
+    db::DbFileOptions options;
+    options.compressed = compressed;
+    db::Database &database = db::getDatabase();
+    database.add(std::make_unique<db::HeapFile>(name, td, options));
+    auto &file = dynamic_cast<db::HeapFile &>(database.get(name));
+
+    std::mt19937_64 rng(42);
+    std::vector<db::Tuple> batch;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < tuples; i++) {
+        batch.push_back({{static_cast<int>(i), "label" + std::to_string(rng() % 100000), (rng() % 10000) * 0.25}});
+        if (batch.size() == 100000 || i + 1 == tuples) {
+            file.insertBatch(batch);
+            batch.clear();
+        }
+    }
+    double load_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    size_t pages = file.getNumPages();
+    auto bytes = static_cast<double>(std::filesystem::file_size(name));
+
+    double sum = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < SCANS; i++) {
+        file.scan([&](const db::TupleView &t) { sum += t.get_double(2); });
+    }
+    double scan_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / SCANS;
+    double logical = static_cast<double>(pages * db::DEFAULT_PAGE_SIZE) / (1 << 20);
+    std::printf("%-10s %7zu pages %8.1f MB on disk (%4.1fx)  load %7.1f ms  scan %7.1f ms %7.0f MB/s (%.0f)\n",
+                compressed ? "compressed" : "raw", pages, bytes / (1 << 20), logical * (1 << 20) / bytes, load_ms,
+                scan_ms, logical / scan_ms * 1000, sum);
+    database.remove(name);
+    std::remove(name);
+    std::remove((std::string(name) + ".fsm").c_str());
+}
+
+int main(int argc, char **argv) {
+    size_t tuples = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    std::printf("%zu tuples, %d cold scans\n", tuples, SCANS);
+    db::getDatabase().getBufferPool().resize(1024);
+    scan(false, tuples);
+    scan(true, tuples);
+}
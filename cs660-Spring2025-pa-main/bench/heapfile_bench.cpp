@@ -0,0 +1,79 @@
+#include <db/Database.hpp>
+#include <db/HeapFile.hpp>
+#include <db/HeapPage.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+// Steady-state churn: after loading a file, inserts and deletes alternate at random with equal probability, so the
+// number of tuples stays about the same. With the free-space map, the file should stay about the same size too.
+
+static void churn(db::PageFormat format, size_t tuples, size_t ops) {
+    const char *name = format == db::PageFormat::FIXED ? "bench_fixed.db" : "bench_slotted.db";
+    std::remove(name);
+    std::remove((std::string(name) + ".fsm").c_str());
+    db::TupleDesc td({db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE}, {"id", "name", "price"});
+    db::DbFileOptions options;
+    options.format = format;
+    db::Database &database = db::getDatabase();
+    database.add(std::make_unique<db::HeapFile>(name, td, options));
+    db::DbFile &file = database.get(name);
+
+    std::mt19937_64 rng(42);
+    auto tuple = [&](int i) { return db::Tuple({i, "label" + std::to_string(rng() % 100000), i * 0.5}); };
+    for (size_t i = 0; i < tuples; i++) {
+        file.insertTuple(tuple(static_cast<int>(i)));
+    }
+    size_t loaded = file.getNumPages();
+
+    auto first = [&](size_t page) {
+        db::PageView view = file.viewPage(page);
+        if (format == db::PageFormat::FIXED) {
+            db::HeapPage hp(*view, td);
+            return hp.begin() == hp.end() ? SIZE_MAX : hp.begin();
+        }
+        db::SlottedPage sp(*view, td);
+        return sp.begin() == sp.end() ? SIZE_MAX : sp.begin();
+    };
+
+    size_t inserts = 0;
+    double insert_ns = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t op = 0; op < ops; op++) {
+        if (rng() % 2 == 0) {
+            db::Tuple t = tuple(static_cast<int>(op));
+            auto insert_start = std::chrono::steady_clock::now();
+            file.insertTuple(t);
+            insert_ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - insert_start).count();
+            inserts++;
+        } else {
+            // Delete the first tuple of a random non-empty page
+            for (int attempt = 0; attempt < 16; attempt++) {
+                size_t page = rng() % file.getNumPages();
+                size_t slot = first(page);
+                if (slot != SIZE_MAX) {
+                    file.deleteTuple({file, page, slot});
+                    break;
+                }
+            }
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("%-8s %8zu pages loaded %8zu pages after churn %10.0f ops/s %8.0f ns/insert\n",
+                format == db::PageFormat::FIXED ? "FIXED" : "SLOTTED", loaded, file.getNumPages(), ops / seconds,
+                insert_ns / static_cast<double>(inserts));
+    database.remove(name);
+    std::remove(name);
+    std::remove((std::string(name) + ".fsm").c_str());
+}
+
+int main(int argc, char **argv) {
+    size_t tuples = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+    size_t ops = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000000;
+    std::printf("%zu tuples, %zu operations (50%% inserts, 50%% deletes)\n", tuples, ops);
+    db::getDatabase().getBufferPool().resize(4096);
+    churn(db::PageFormat::FIXED, tuples, ops);
+    churn(db::PageFormat::SLOTTED, tuples, ops);
+}
@@ -0,0 +1,107 @@
+#include <db/BTreeFile.hpp>
+#include <db/Database.hpp>
+#include <db/HeapFile.hpp>
+#include <db/Query.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <string>
+
+// Secondary indexes: a heap file of shuffled tuples is filtered with predicates of decreasing selectivity, with a
+// full scan and with the secondary indexes of the file. The costs of building and maintaining the indexes are shown.
+
+static double since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static size_t run = 0;
+
+static void query(const db::HeapFile &in, const char *label, const std::vector<db::FilterPredicate> &preds) {
+    db::Database &database = db::getDatabase();
+    std::string out_name = "bench_index_out" + std::to_string(run++) + ".db";
+    std::remove(out_name.c_str());
+    database.add(std::make_unique<db::HeapFile>(out_name, in.getTupleDesc()));
+    auto &out = database.get(out_name);
+    auto start = std::chrono::steady_clock::now();
+    db::filter(in, out, preds);
+    double ms = since(start);
+    size_t rows = 0;
+    out.scan([&](const db::TupleView &) { rows++; });
+    std::printf("  %-28s %9.2f ms   %8zu rows\n", label, ms, rows);
+    database.remove(out_name);
+    std::remove(out_name.c_str());
+    std::remove((out_name + ".fsm").c_str());
+}
+
+static void queries(const db::HeapFile &in, int tuples) {
+    query(in, "id = k", {{"id", db::PredicateOp::EQ, tuples / 3}});
+    query(in, "id in 0.01%", {{"id", db::PredicateOp::GE, 1000}, {"id", db::PredicateOp::LT, 1000 + tuples / 10000}});
+    query(in, "id in 0.1%", {{"id", db::PredicateOp::GE, 1000}, {"id", db::PredicateOp::LT, 1000 + tuples / 1000}});
+    query(in, "id in 1%", {{"id", db::PredicateOp::GE, 1000}, {"id", db::PredicateOp::LT, 1000 + tuples / 100}});
+    query(in, "name = s (1 in 100000)", {{"name", db::PredicateOp::EQ, std::string("label777")}});
+    query(in, "price < p (10%)", {{"price", db::PredicateOp::LT, tuples * 0.05}});
+}
+
+int main(int argc, char **argv) {
+    int tuples = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    db::getDatabase().getBufferPool().resize(1024);
+    const std::string in_name = "bench_index.db";
+    const std::vector<std::string> index_names{"bench_index.id", "bench_index.name", "bench_index.price"};
+    std::remove(in_name.c_str());
+    std::remove((in_name + ".fsm").c_str());
+    for (const std::string &name: index_names) {
+        std::remove(name.c_str());
+    }
+    db::TupleDesc td({db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE}, {"id", "name", "price"});
+    db::Database &database = db::getDatabase();
+    database.add(std::make_unique<db::HeapFile>(in_name, td));
+    auto &in = dynamic_cast<db::HeapFile &>(database.get(in_name));
+
+    std::vector<int> keys(tuples);
+    std::iota(keys.begin(), keys.end(), 0);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(42));
+    std::vector<db::Tuple> batch;
+    for (int k: keys) {
+        batch.push_back({{k, "label" + std::to_string(k % 100000), k * 0.5}});
+    }
+    in.insertBatch(batch);
+    batch.clear();
+
+    std::printf("%d shuffled tuples (%zu heap pages)\n", tuples, in.getNumPages());
+    std::printf("scan\n");
+    queries(in, tuples);
+
+    auto start = std::chrono::steady_clock::now();
+    in.createIndex(index_names[0], {"id"});
+    in.createIndex(index_names[1], {"name"});
+    in.createIndex(index_names[2], {"price"});
+    std::printf("3 indexes built in %.1f ms\n", since(start));
+    queries(in, tuples);
+
+    // Every insert and delete now updates the three indexes
+    constexpr int updates = 10000;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < updates; i++) {
+        in.insertTuple({{tuples + i, "label" + std::to_string(i), i * 0.5}});
+    }
+    double insert_ms = since(start);
+    start = std::chrono::steady_clock::now();
+    int deleted = 0;
+    for (auto it = in.begin(); it != in.end() && deleted < updates; ++it) {
+        in.deleteTuple(it);
+        deleted++;
+    }
+    std::printf("%d inserts %.1f ms, %d deletes %.1f ms with 3 indexes\n", updates, insert_ms, deleted,
+                since(start));
+    for (const std::string &name: index_names) {
+        in.dropIndex(name);
+        database.remove(name);
+        std::remove(name.c_str());
+    }
+    database.remove(in_name);
+    std::remove(in_name.c_str());
+    std::remove((in_name + ".fsm").c_str());
+}
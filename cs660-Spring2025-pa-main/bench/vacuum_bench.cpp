@@ -0,0 +1,77 @@
+#include <db/Database.hpp>
+#include <db/HeapFile.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+// Heavy deletes: after loading a file, most tuples are deleted at random, which leaves the pages mostly empty. The file
+// is then compacted in steps of VACUUM_STEP pages, and full scans of the file are timed before and after.
+
+static constexpr size_t VACUUM_STEP = 64;
+
+static double scan(const db::DbFile &file, size_t &count) {
+    auto start = std::chrono::steady_clock::now();
+    count = 0;
+    for (auto it = file.begin(); it != file.end(); ++it) {
+        count++;
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void vacuum(db::PageFormat format, size_t tuples, double keep) {
+    const char *name = format == db::PageFormat::FIXED ? "bench_fixed.db" : "bench_slotted.db";
+    std::remove(name);
+    std::remove((std::string(name) + ".fsm").c_str());
+    db::TupleDesc td({db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE}, {"id", "name", "price"});
+    db::DbFileOptions options;
+    options.format = format;
+    db::Database &database = db::getDatabase();
+    database.add(std::make_unique<db::HeapFile>(name, td, options));
+    auto &file = dynamic_cast<db::HeapFile &>(database.get(name));
+
+    std::mt19937_64 rng(42);
+    std::vector<db::Tuple> batch;
+    for (size_t i = 0; i < tuples; i++) {
+        batch.push_back({{static_cast<int>(i), "label" + std::to_string(rng() % 100000), i * 0.5}});
+    }
+    file.insertBatch(batch);
+    std::uniform_real_distribution<double> uniform;
+    for (auto it = file.begin(); it != file.end(); ++it) {
+        if (uniform(rng) >= keep) {
+            file.deleteTuple(it);
+        }
+    }
+    size_t before = file.getNumPages();
+    size_t count_before;
+    size_t count_after;
+    double scan_before = scan(file, count_before);
+
+    size_t steps = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (file.vacuum(VACUUM_STEP) != 0) {
+        steps++;
+    }
+    double vacuum_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    double scan_after = scan(file, count_after);
+    if (count_before != count_after) {
+        std::printf("%zu tuples before vacuum, %zu after\n", count_before, count_after);
+        std::exit(1);
+    }
+
+    std::printf("%-8s %8zu -> %6zu pages (%zu reclaimed in %zu steps, %.1f ms)   scan %7.2f -> %6.2f ms (%.1fx)\n",
+                format == db::PageFormat::FIXED ? "FIXED" : "SLOTTED", before, file.getNumPages(),
+                before - file.getNumPages(), steps, vacuum_ms, scan_before, scan_after, scan_before / scan_after);
+    database.remove(name);
+    std::remove(name);
+    std::remove((std::string(name) + ".fsm").c_str());
+}
+
+int main(int argc, char **argv) {
+    size_t tuples = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 500000;
+    double keep = argc > 2 ? std::strtod(argv[2], nullptr) : 0.1;
+    std::printf("%zu tuples, %.0f%% kept\n", tuples, keep * 100);
+    db::getDatabase().getBufferPool().resize(4096);
+    vacuum(db::PageFormat::FIXED, tuples, keep);
+    vacuum(db::PageFormat::SLOTTED, tuples, keep);
+}
@@ -1,21 +1,74 @@
 #pragma once
 
 #include <db/DbFile.hpp>
+#include <db/KeyDesc.hpp>
+#include <vector>
 
 namespace db {
+    /// Number of bytes of tuples sorted in memory at once by BTreeFile::bulkLoad. Larger inputs are sorted in runs.
+    constexpr size_t BULK_RUN_BYTES = 64 << 20;
 
     class BTreeFile : public DbFile {
         static constexpr size_t root_id = 0;
-        size_t key_index;
+        KeyDesc key_desc;
+        /// Pages freed by merges in deleteTuple, reused by the splits of insertTuple while the file is open.
+        std::vector<size_t> free_pages;
+
+        /**
+         * @brief Get a free page, or a new page at the end of the file.
+         */
+        size_t allocatePage();
+
+        /**
+         * @brief Descend from the root to the leaf that may contain a key, and position an iterator in it.
+         * @param key the encoded key (see KeyDesc)
+         * @param upper whether to position the iterator after the tuples with the key instead of at the first one
+         * @return the iterator, moved to the next leaf if it is past the last tuple of the leaf
+         */
+        Iterator seek(const uint8_t *key, bool upper) const;
+
+        /**
+         * @brief Build the tree bottom-up from serialized tuples (see bulkLoad).
+         * @param scan calls its argument with every tuple, serialized with the TupleDesc of the file. It is called
+         * once.
+         */
+        void load(const std::function<void(const std::function<void(const uint8_t *)> &)> &scan, double fill);
 
     public:
 
+        /**
+         * @brief The tuples between two iterators, e.g. `for (const auto &t: file.range(lo, hi))`
+         */
+        struct Range {
+            Iterator first;
+            Iterator last;
+
+            Iterator begin() const { return first; }
+
+            Iterator end() const { return last; }
+        };
+
         /**
          * @brief Initialize a BTreeFile
          *
          * @param key_index the index of the key in the tuple
          */
-        BTreeFile(const std::string &name, const TupleDesc &td, size_t key_index);
+        BTreeFile(const std::string &name, const TupleDesc &td, size_t key_index, const DbFileOptions &options = {});
+
+        /**
+         * @brief Initialize a BTreeFile with a composite key
+         * @details The tuples are sorted by the first key field, then by the second one, and so on. Keys of any type
+         * are encoded so that they compare with `memcmp` (see KeyDesc).
+         * @param key_fields the indexes of the key fields in the tuple
+         * @throws std::invalid_argument if the key has no fields, a field is out of range or the key is too long
+         */
+        BTreeFile(const std::string &name, const TupleDesc &td, std::vector<size_t> key_fields,
+                  const DbFileOptions &options = {});
+
+        /**
+         * @brief The key of the tuples
+         */
+        const KeyDesc &getKeyDesc() const;
 
         /**
          * @brief Insert a tuple into the file
@@ -27,8 +80,112 @@ namespace db {
          */
         void insertTuple(const Tuple &t) override;
 
+        /**
+         * @brief Build the tree bottom-up from the tuples of another file.
+         * @details The tuples are packed into leaves from left to right, then each level of index pages is built from
+         * the first keys of the level below, up to the root. Pages are filled up to the fill factor and written in
+         * order, BATCH_PAGES at a time, bypassing the BufferPool (the root is written last, to page 0).
+         *
+         * The input is read in a single pass. Input that is already sorted by key (e.g. another BTreeFile) is streamed
+         * into the leaves. From the first tuple out of order, the input is sorted instead: runs of BULK_RUN_BYTES are
+         * sorted in memory and, if there is more than one, spilled to temporary files and merged. As with insertTuple,
+         * a tuple replaces the previous tuples with the same key.
+         * @param in the file to load the tuples from, with the same types of fields
+         * @param fill the fraction of each page to fill, in (0, 1]. Leaving room in the pages avoids splitting them
+         * when more tuples are inserted later.
+         * @throws std::logic_error if the file is memory-mapped or not empty
+         * @throws std::invalid_argument if the fill factor is out of range or the fields of `in` do not match
+         * @throws std::runtime_error if a temporary file cannot be created or written
+         */
+        void bulkLoad(const DbFile &in, double fill = 1.0);
+
+        /**
+         * @brief Build the tree bottom-up from serialized tuples (see bulkLoad).
+         * @param data the tuples, serialized back to back with the TupleDesc of the file
+         * @param count the number of tuples
+         * @param fill the fraction of each page to fill, in (0, 1]
+         * @throws std::logic_error if the file is memory-mapped or not empty
+         * @throws std::invalid_argument if the fill factor is out of range
+         * @throws std::runtime_error if a temporary file cannot be created or written
+         */
+        void bulkLoad(const uint8_t *data, size_t count, double fill = 1.0);
+
+        /**
+         * @brief Delete a tuple from the file.
+         * @details The tuple is removed from its leaf. A leaf left less than half full is merged with a sibling (or
+         * takes tuples from it, if they do not fit in one page), and the merges propagate up the index pages, so the
+         * tree stays balanced and its pages at least half full. The `next_leaf` links are updated by the merges.
+         * The freed pages are reused by later splits while the file is open.
+         * @param it The iterator to the tuple. All the iterators of the file are invalidated: to delete tuples while
+         * scanning, continue from lowerBound() of the key of the deleted tuple.
+         * @throws std::logic_error if the file is memory-mapped, or the iterator is not a tuple of the file
+         * @throws std::out_of_range if the iterator is end() or its slot is out of range. The iterator is checked
+         * before the file is changed.
+         */
         void deleteTuple(const Iterator &it) override;
 
+        /**
+         * @brief Find the tuple with a key.
+         * @details Descend from the root with a binary search in every index page and in the leaf, reading one page
+         * per level of the tree.
+         * @param key the values of the key fields
+         * @return the iterator to the tuple, or end() if there is no tuple with the key
+         * @throws std::invalid_argument if the values do not match the key fields
+         */
+        Iterator find(const std::vector<field_t> &key) const;
+
+        /**
+         * @brief Get the iterator to the first tuple with a key not less than `key`.
+         * @param key the values of the key fields, or of their first fields to seek to the first key with that prefix
+         * @return the iterator, or end() if all the keys are less than `key`
+         */
+        Iterator lowerBound(const std::vector<field_t> &key) const;
+
+        /**
+         * @brief Get the iterator to the first tuple with a key greater than `key`.
+         * @param key the values of the key fields, or of their first fields to seek past all the keys with that prefix
+         * @return the iterator, or end() if no key is greater than `key`
+         */
+        Iterator upperBound(const std::vector<field_t> &key) const;
+
+        /**
+         * @brief Get the tuples with keys in `[lo, hi]`, in key order.
+         * @details The range starts at lowerBound(lo) and stops at upperBound(hi), so the scan reads the leaves of the
+         * range (and the two descents) instead of the whole file. The bounds may be prefixes of a composite key.
+         * @return the range, empty if `lo > hi`
+         */
+        Range range(const std::vector<field_t> &lo, const std::vector<field_t> &hi) const;
+
+        /**
+         * @brief Call a function with the tuples of a range, in key order, a leaf at a time.
+         * @details Each leaf is pinned and latched once for all its tuples, instead of once per tuple and per step with
+         * an Iterator.
+         * @param range the tuples to visit (e.g. from range, or from lowerBound and upperBound)
+         * @param f the function to call with every tuple, which returns false to stop the scan. The views are only
+         * valid during the call. It must not modify the file.
+         */
+        void scanRange(const Range &range, const std::function<bool(const TupleView &)> &f) const;
+
+        /**
+         * @brief Find the tuple with an INT key (see find).
+         */
+        Iterator find(int key) const;
+
+        /**
+         * @brief Get the iterator to the first tuple with an INT key not less than `key` (see lowerBound).
+         */
+        Iterator lowerBound(int key) const;
+
+        /**
+         * @brief Get the iterator to the first tuple with an INT key greater than `key` (see upperBound).
+         */
+        Iterator upperBound(int key) const;
+
+        /**
+         * @brief Get the tuples with INT keys in `[lo, hi]` (see range).
+         */
+        Range range(int lo, int hi) const;
+
         /**
          * @brief Get a tuple from the database file.
          * @details Get a tuple from the database file by reading the tuple from the page.
@@ -37,6 +194,8 @@ namespace db {
          */
         Tuple getTuple(const Iterator &it) const override;
 
+        TupleView view(const Iterator &it) const override;
+
         /**
          * @brief Advance the iterator to the next tuple.
          * @details Advance the iterator to the next tuple by moving to the next slot of the page.
@@ -1,39 +1,174 @@
 #pragma once
 
+#include <db/PageTable.hpp>
+#include <db/ReplacementPolicy.hpp>
 #include <db/types.hpp>
-#include <list>
-#include <unordered_map>
-#include <unordered_set>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <thread>
 #include <vector>
 
 namespace db {
     constexpr size_t DEFAULT_NUM_PAGES = 50;
 
+    class PageGuard;
+
+    /// Number of independently latched partitions of the page table.
+    constexpr size_t NUM_PARTITIONS = 16;
+
+    /// Number of accesses to resident pages buffered by a partition before they are passed to the replacement policy.
+    constexpr size_t ACCESS_BATCH = 64;
+
+    /// The background flusher writes dirty pages until at most this fraction of the frames is dirty.
+    constexpr double DEFAULT_DIRTY_LOW_WATERMARK = 0.1;
+
+    /// The background flusher is woken up as soon as this fraction of the frames is dirty.
+    constexpr double DEFAULT_DIRTY_HIGH_WATERMARK = 0.3;
+
+    /// How often the background flusher checks the dirty pages when the high watermark is not reached.
+    constexpr std::chrono::milliseconds FLUSH_INTERVAL{10};
+
 /**
  * @brief Represents a buffer pool for database pages.
  * @details The BufferPool class is responsible for managing the database pages in memory.
  * It provides functions to get a page, mark a page as dirty, and check the status of pages.
  * The class also supports flushing pages to disk and discarding pages from the buffer pool.
  * @note A BufferPool owns the Page objects that are stored in it.
+ * @note All methods are thread-safe except the constructor, the destructor, BufferPool::resize and
+ * BufferPool::setReplacementPolicy. A page returned by BufferPool::getPage is not pinned, so concurrent callers must use
+ * BufferPool::pinPage and the page latch instead.
  */
     class BufferPool {
+        /// Bookkeeping of one frame. `pins` and `dirty` may be read without holding any latch.
+        struct Frame {
+            PageId pid;
+            std::atomic<size_t> pins{0};
+            std::atomic<bool> dirty{false};
+            /// When the page last went from clean to dirty, used to write back the oldest pages first.
+            std::atomic<size_t> dirty_since{0};
+            /// Readers of the page hold it shared, writers and the loading thread hold it exclusively.
+            std::shared_mutex latch;
+            /// The page is being read by the thread that installed it. It stays set if the read fails, until the
+            /// threads waiting for the page have unpinned the frame.
+            std::atomic<bool> loading{false};
+        };
+
+        /// An access to a resident page, not yet passed to the replacement policy.
+        struct Access {
+            std::chrono::steady_clock::time_point time;
+            size_t pos;
+            PageId pid;
+        };
+
+        /// A slice of the page table, selected by the hash of the page id.
+        struct Partition {
+            mutable std::mutex latch;
+            PageTable pid_to_pos;
+            /// The accesses to the pages of the partition since the last drainAccesses, in order.
+            std::vector<Access> accesses;
+        };
+
         // TODO pa0: add private members
-        std::array<Page, DEFAULT_NUM_PAGES> pages;
-        std::array<PageId, DEFAULT_NUM_PAGES> pos_to_pid;
-        std::unordered_map<const PageId, size_t> pid_to_pos;
-        std::unordered_set<size_t> dirty;
+        size_t numPages;
+        bool hugePages;
+        /// One contiguous, page-aligned allocation holding `numPages` frames.
+        Page *pages;
+        std::unique_ptr<Frame[]> frames;
+        std::array<Partition, NUM_PARTITIONS> partitions;
+
+        /// Protects `available` and `policy`. Must be acquired before any partition latch.
+        std::mutex latch;
         std::vector<size_t> available;
-        std::list<size_t> lru_list;
-        std::unordered_map<size_t, std::list<size_t>::iterator> pos_to_lru;
+        std::unique_ptr<ReplacementPolicy> policy;
+
+        std::atomic<size_t> numDirty{0};
+        std::atomic<size_t> dirtyClock{0};
+
+        /// Protects the flusher state below.
+        std::mutex flusher_latch;
+        std::condition_variable flusher_cv;
+        std::thread flusher;
+        bool stopping = false;
+        std::atomic<double> lowWatermark = DEFAULT_DIRTY_LOW_WATERMARK;
+        std::atomic<double> highWatermark = DEFAULT_DIRTY_HIGH_WATERMARK;
+
+        Partition &partition(const PageId &pid);
+
+        const Partition &partition(const PageId &pid) const;
+
+        size_t position(const Page &page) const;
+
+        /// Returns the position of a pinned frame holding the page, reading it from disk if needed.
+        size_t fetch(const PageId &pid);
+
+        /**
+         * Passes the buffered accesses of all the partitions to the policy, in the order of their times. Accesses to a
+         * frame that no longer holds the page are dropped. Requires `latch`.
+         * @details Hits only record their access in their partition, under the partition latch they already hold, so
+         * that they do not contend on `latch`. The accesses are drained when a partition has ACCESS_BATCH of them, and
+         * before a page is installed or a victim is chosen, so the policy sees every access in order before it evicts.
+         */
+        void drainAccesses();
+
+        /// Returns the position of an empty frame that is not tracked by the page table or the policy.
+        size_t allocateFrame();
+
+        /**
+         * Publishes an allocated frame as holding the page. Returns `pos` with the frame pinned and latched exclusively
+         * (the caller reads the page and releases the latch), or the pinned frame of another thread that installed the
+         * page first (`pos` is then returned to the free frames).
+         */
+        size_t install(const PageId &pid, size_t pos);
+
+        /**
+         * Waits until a pinned frame is loaded. Returns false, with the frame unpinned, if the read of its page failed.
+         */
+        bool waitLoaded(size_t pos);
+
+        /**
+         * Removes a frame whose page could not be read from the page table, and releases its latch and its pin. The
+         * frame returns to the free frames once the threads waiting for it have unpinned it (see waitLoaded).
+         */
+        void abandon(size_t pos);
+
+        /**
+         * Unpins a frame that is no longer in the page table, returning it to the free frames with its last pin.
+         * Requires `latch`.
+         */
+        void releaseAbandoned(size_t pos);
+
+        /// Writes the page of a pinned frame to disk if it is dirty.
+        void writeFrame(size_t pos);
+
+        /// Marks a frame dirty, waking up the flusher if the high watermark is reached.
+        void setDirty(Frame &frame);
+
+        /// Marks a frame clean. Returns whether it was dirty.
+        bool clearDirty(Frame &frame);
+
+        void runFlusher();
+
+        friend class PageGuard;
 
     public:
         /**
-         * @brief: Constructs a BufferPool object with the default number of pages.
+         * @brief: Constructs a BufferPool object with the specified number of pages.
+         * @param numPages: The number of frames in the buffer pool.
+         * @param hugePages: Whether to ask the kernel to back the frames with transparent huge pages.
+         * @param policy: The page replacement algorithm.
+         * @throws std::invalid_argument if numPages is zero.
+         * @throws std::runtime_error if the frames cannot be allocated.
          */
-        explicit BufferPool();
+        explicit BufferPool(size_t numPages = DEFAULT_NUM_PAGES, bool hugePages = false,
+                            ReplacementPolicyType policy = ReplacementPolicyType::LRU);
 
         /**
-         * @brief: Destructs a BufferPool object after flushing all dirty pages to disk.
+         * @brief: Destructs a BufferPool object after stopping the flusher and flushing all dirty pages to disk.
          */
         ~BufferPool();
 
@@ -45,14 +180,111 @@ namespace db {
 
         BufferPool &operator=(BufferPool &&) = delete;
 
+        /**
+         * @brief: Returns the number of frames in the buffer pool.
+         */
+        size_t capacity() const;
+
+        /**
+         * @brief: Changes the number of frames in the buffer pool.
+         * @details Resident pages are moved to a new allocation. When shrinking, the pages chosen by the replacement
+         * policy are evicted (and flushed if they are dirty) until the remaining pages fit.
+         * @param numPages: The new number of frames.
+         * @throws std::invalid_argument if numPages is zero.
+         * @throws std::logic_error if a page is pinned.
+         * @note The background flusher, if running, is paused during the resize.
+         * @note This method invalidates all references returned by BufferPool::getPage.
+         */
+        void resize(size_t numPages);
+
+        /**
+         * @brief: Replaces the page replacement algorithm.
+         * @details The resident pages are kept, but the access history gathered by the previous policy is lost.
+         * @param type: The new page replacement algorithm.
+         * @throws std::logic_error if a page is pinned.
+         */
+        void setReplacementPolicy(ReplacementPolicyType type);
+
+        /**
+         * @brief: Sets the dirty ratios that drive the background flusher.
+         * @param low: The flusher writes pages back until at most this fraction of the frames is dirty.
+         * @param high: The flusher is woken up immediately when this fraction of the frames is dirty.
+         * @throws std::invalid_argument unless 0 <= low <= high <= 1.
+         */
+        void setDirtyWatermarks(double low, double high);
+
+        /**
+         * @brief: Starts a background thread that writes dirty pages back to disk.
+         * @details The thread wakes up every FLUSH_INTERVAL, or as soon as the high watermark is reached, and writes the
+         * oldest dirty pages until the low watermark is reached. Eviction then mostly finds clean pages.
+         * @note The flusher is stopped by BufferPool::stopFlusher or by the destructor.
+         */
+        void startFlusher();
+
+        /**
+         * @brief: Stops the background flusher and waits for it to finish.
+         */
+        void stopFlusher();
+
+        /**
+         * @brief: Returns the number of dirty pages in the buffer pool.
+         */
+        size_t getNumDirty() const;
+
+        /**
+         * @brief: Writes back the dirty pages that have been dirty the longest.
+         * @details The dirty pages of each file are written with a single batch (see DbFile::writePages).
+         * @param count: The maximum number of pages to write.
+         * @return: The number of pages written.
+         */
+        size_t flushOldest(size_t count);
+
         /**
          * @brief: Returns the page with the specified page id.
          * @param pid: The page id of the page to return.
          * @return: The page with the specified page id.
-         * @note This method should make this page the most recently used page.
+         * @note This method records an access to the page with the replacement policy. A hit is buffered in its
+         * partition of the page table and passed to the policy in a batch, at the latest before the next page is read.
+         * @throws std::runtime_error if every page is pinned and none can be evicted, or if the page cannot be read (see
+         * DbFile::readPage). A page that cannot be read is not kept in the buffer pool.
          */
         Page &getPage(const PageId &pid);
 
+        /**
+         * @brief: Reads pages that are not in the buffer pool yet, without pinning them.
+         * @details The missing pages are read with a single batch (see DbFile::readPages). The pages are tracked by the
+         * replacement policy as if they had just been read by BufferPool::getPage.
+         * @param file: The id of the file (see Database::getId).
+         * @param first: The page number of the first page to read.
+         * @param count: The number of pages to read.
+         * @return: The number of pages read from disk.
+         * @throws std::runtime_error if a page cannot be read. None of the pages are then added to the buffer pool.
+         */
+        size_t prefetch(size_t file, size_t first, size_t count);
+
+        /**
+         * @brief: Returns the page with the specified page id and pins it in the buffer pool.
+         * @details A pinned page is never evicted or discarded. Each call must be matched by BufferPool::unpinPage.
+         * @param pid: The page id of the page to return.
+         * @return: The page with the specified page id.
+         * @throws std::runtime_error if every page is pinned and none can be evicted.
+         */
+        Page &pinPage(const PageId &pid);
+
+        /**
+         * @brief: Releases a pin acquired by BufferPool::pinPage.
+         * @param page: The pinned page.
+         */
+        void unpinPage(const Page &page);
+
+        /**
+         * @brief: Returns the reader/writer latch of a pinned page.
+         * @details Readers of the page contents should hold the latch shared and writers exclusively.
+         * @param page: The pinned page.
+         * @return: The latch of the page.
+         */
+        std::shared_mutex &pageLatch(const Page &page);
+
         /**
          * @brief: Marks the page with the specified page id as dirty.
          * @param pid: The page id of the page to mark as dirty.
@@ -76,8 +308,9 @@ namespace db {
         /**
          * @brief: Discards the page with the specified page id from the buffer pool.
          * @param pid: The page id of the page to discard.
+         * @throws std::logic_error if the page is pinned.
          * @note This method does NOT flush the page to disk.
-         * @note This method also updates the LRU and dirty pages to exclude tracking this page.
+         * @note This method also updates the replacement policy and dirty pages to exclude tracking this page.
          */
         void discardPage(const PageId &pid);
 
@@ -95,4 +328,83 @@ namespace db {
          */
         void flushFile(const std::string &file);
     };
+
+/**
+ * @brief Keeps a page pinned in the BufferPool for the lifetime of the guard.
+ * @details The page is pinned on construction and unpinned on destruction, so it cannot be evicted while the guard is
+ * alive. Use PageGuard::latch to synchronize access to the page contents with other threads.
+ */
+    class PageGuard {
+        BufferPool *bufferPool;
+        Page *page;
+
+    public:
+        /**
+         * @brief Pin a page.
+         * @param bufferPool The buffer pool holding the page.
+         * @param pid The page id of the page to pin.
+         * @throws std::runtime_error if every page is pinned and none can be evicted.
+         */
+        PageGuard(BufferPool &bufferPool, const PageId &pid);
+
+        /**
+         * @brief Unpin the page (if the guard has not been released or moved from).
+         */
+        ~PageGuard();
+
+        PageGuard(const PageGuard &) = delete;
+
+        PageGuard &operator=(const PageGuard &) = delete;
+
+        PageGuard(PageGuard &&other) noexcept;
+
+        PageGuard &operator=(PageGuard &&other) noexcept;
+
+        Page &operator*() const { return *page; }
+
+        Page *operator->() const { return page; }
+
+        /**
+         * @brief Mark the page as dirty so that it is written back before it is evicted.
+         */
+        void markDirty();
+
+        /**
+         * @brief Return the reader/writer latch of the page.
+         */
+        std::shared_mutex &latch() const;
+
+        /**
+         * @brief Unpin the page before the guard is destroyed.
+         */
+        void release();
+    };
+
+/**
+ * @brief A read-only view of a page.
+ * @details The page is either read in place (e.g. in a memory-mapped file), or pinned in the BufferPool and latched in
+ * shared mode for the lifetime of the view.
+ */
+    class PageView {
+        std::optional<PageGuard> guard;
+        std::shared_lock<std::shared_mutex> lock;
+        const Page *page;
+
+    public:
+        /**
+         * @brief View a page that is not managed by the buffer pool.
+         */
+        explicit PageView(const Page &page);
+
+        /**
+         * @brief Pin a page and latch it in shared mode.
+         * @param bufferPool The buffer pool holding the page.
+         * @param pid The page id of the page.
+         */
+        PageView(BufferPool &bufferPool, const PageId &pid);
+
+        const Page &operator*() const { return *page; }
+
+        const Page *operator->() const { return page; }
+    };
 } // namespace db
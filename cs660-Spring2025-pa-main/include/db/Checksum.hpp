@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace db {
+
+/**
+ * @brief Compute the CRC32C (Castagnoli) checksum of a buffer.
+ * @details The CRC32 instruction of SSE 4.2 is used when the CPU supports it (checked once), and a table-driven
+ * implementation otherwise. Both give the same result.
+ * @param data The buffer.
+ * @param length The length of the buffer, in bytes.
+ * @param crc The checksum of the preceding bytes, to checksum a buffer in parts.
+ * @return The checksum of the preceding bytes and the buffer.
+ */
+    uint32_t crc32c(const uint8_t *data, size_t length, uint32_t crc = 0);
+
+/**
+ * @brief Whether crc32c uses the CRC32 instruction of the CPU.
+ */
+    bool crc32cAccelerated();
+} // namespace db
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <db/IoEngine.hpp>
+#include <db/types.hpp>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace db {
+
+/**
+ * @brief The maximum size of `length` bytes compressed with lz4Compress.
+ */
+    constexpr size_t lz4Bound(size_t length) { return length + length / 255 + 16; }
+
+/**
+ * @brief Compress a buffer in the LZ4 block format.
+ * @details A greedy compressor with a single hash table of 4-byte sequences. Runs of zeros (e.g. the padding of CHAR
+ * fields) are encoded as overlapping matches.
+ * @param src The buffer to compress.
+ * @param length The length of the buffer, at most 64 KiB (the LZ4 window).
+ * @param dst The compressed block, at least lz4Bound(length) bytes.
+ * @return The length of the compressed block.
+ */
+    size_t lz4Compress(const uint8_t *src, size_t length, uint8_t *dst);
+
+/**
+ * @brief Decompress a block compressed in the LZ4 block format.
+ * @param src The compressed block.
+ * @param length The length of the compressed block.
+ * @param dst The decompressed buffer.
+ * @param raw The length of the decompressed buffer.
+ * @throws std::runtime_error if the block is corrupt or does not decompress to exactly `raw` bytes.
+ */
+    void lz4Decompress(const uint8_t *src, size_t length, uint8_t *dst, size_t raw);
+
+/**
+ * @brief The pages of a compressed file (DbFileOptions::compressed).
+ * @details Pages are stored in groups of GROUP_PAGES consecutive pages, each compressed into one block with
+ * lz4Compress (or stored as is if it does not compress). Blocks are appended to the file: writing a page rewrites its
+ * whole group at the end of the file, so compression suits data that is written once (e.g. with
+ * HeapFile::insertBatch) and then mostly read. The space of the superseded blocks is not reclaimed.
+ *
+ * Each block starts with a header (magic, group, number of pages, compressed length). When the file is closed, an
+ * index of the latest block of every group is appended, followed by a trailer that locates it. A file without a valid
+ * index (e.g. after a crash) is opened by scanning the block headers.
+ *
+ * The last decompressed group is cached, so that reading the pages of a group one at a time decompresses it once.
+ */
+    class CompressedPages {
+        struct Block {
+            uint64_t offset = 0;
+            uint32_t pages = 0;
+            uint32_t length = 0;
+        };
+
+        int fd;
+        IoEngine &io;
+        std::mutex latch;
+        /// The latest block of every group. A group without pages has not been written.
+        std::vector<Block> blocks;
+        /// Where the next block is appended, and whether the file has bytes after it (an index) to truncate first.
+        uint64_t append = 0;
+        bool trim = false;
+        /// Whether blocks were appended since the index was written.
+        bool modified = false;
+        size_t cached_group = SIZE_MAX;
+        std::vector<uint8_t> cached;
+
+        /**
+         * Loads the index from the trailer at the end of the file. Returns false if there is no valid index.
+         */
+        bool loadIndex(uint64_t size);
+
+        /**
+         * Rebuilds the index by scanning the block headers, up to the first invalid or incomplete block.
+         */
+        void scanBlocks(uint64_t size);
+
+        /**
+         * Decompresses groups into `cached` (the last one) or the buffers, reading their blocks with a single batch.
+         * Pages that were not written read as zeros.
+         */
+        void load(const std::vector<size_t> &groups, std::vector<std::vector<uint8_t>> &buffers);
+
+        /**
+         * Appends a block for each group with a single batch, and updates the index.
+         */
+        void store(const std::vector<std::pair<size_t, const uint8_t *>> &groups, const std::vector<uint32_t> &pages);
+
+    public:
+        static constexpr size_t GROUP_PAGES = 16;
+        static constexpr size_t GROUP_SIZE = GROUP_PAGES * DEFAULT_PAGE_SIZE;
+
+        /**
+         * @brief Open the compressed pages of a file.
+         * @param fd The file descriptor, opened for reading (and writing, to write pages).
+         * @param io The I/O backend of the file.
+         */
+        CompressedPages(int fd, IoEngine &io);
+
+        /**
+         * @brief Write the index, if blocks were appended. Errors are ignored: the index is rebuilt on the next open.
+         */
+        ~CompressedPages();
+
+        CompressedPages(const CompressedPages &) = delete;
+
+        CompressedPages &operator=(const CompressedPages &) = delete;
+
+        /**
+         * @brief The number of pages: the end of the last page written.
+         */
+        size_t size();
+
+        /**
+         * @brief Read pages. Pages that were not written read as zeros.
+         * @throws std::runtime_error if a read fails or a block is corrupt.
+         */
+        void read(const std::vector<std::pair<size_t, uint8_t *>> &pages);
+
+        /**
+         * @brief Write pages: the groups of the pages are rewritten, with a single batch.
+         * @throws std::runtime_error if a read or a write fails.
+         */
+        void write(const std::vector<std::pair<size_t, uint8_t *>> &pages);
+
+        /**
+         * @brief Remove the pages from `pages` on.
+         */
+        void truncate(size_t pages);
+    };
+} // namespace db
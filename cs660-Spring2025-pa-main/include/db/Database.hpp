@@ -3,6 +3,8 @@
 #include <db/BufferPool.hpp>
 #include <db/DbFile.hpp>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
 
 /**
  * @brief A database is a collection of files and a BufferPool.
@@ -12,13 +14,21 @@
  * @note A Database owns the DbFile objects that are added to it.
  */
 namespace db {
+    /// Maximum number of distinct file names.
+    constexpr size_t MAX_FILES = 1 << 16;
+
     class Database {
         // TODO pa0: add private members
-        std::unordered_map<std::string, std::unique_ptr<DbFile>> files;
+        /// Protects `ids`: names may be interned by concurrent threads.
+        mutable std::mutex ids_latch;
+        /// The interned file names. A name keeps its id when its file is removed.
+        std::unordered_map<std::string, size_t> ids;
+        /// The files indexed by id. Allocated up front so that lookups never race with interning a new name.
+        std::unique_ptr<std::unique_ptr<DbFile>[]> files;
 
         BufferPool bufferPool;
 
-        Database() = default;
+        Database();
 
     public:
         friend Database &getDatabase();
@@ -62,6 +72,29 @@ namespace db {
          * @throws std::logic_error if the name does not exist.
          */
         DbFile &get(const std::string &name) const;
+
+        /**
+         * @brief Returns the DbFile of the specified id.
+         * @param id The id of the file (see Database::getId).
+         * @return The DbFile object.
+         * @throws std::logic_error if no file with this id is in the database.
+         */
+        DbFile &get(size_t id) const;
+
+        /**
+         * @brief Whether a file with this name is in the database.
+         */
+        bool contains(const std::string &name) const;
+
+        /**
+         * @brief Returns the internal id of a file name.
+         * @details Names are interned into dense ids the first time they are seen, whether or not the file has been
+         * added yet. The id of a name never changes.
+         * @param name The name of the file.
+         * @return The id of the file.
+         * @throws std::runtime_error if more than MAX_FILES names are interned.
+         */
+        size_t getId(const std::string &name);
     };
 
 /**
@@ -1,11 +1,50 @@
 #pragma once
 
+#include <db/BufferPool.hpp>
+#include <db/Compression.hpp>
+#include <db/IoEngine.hpp>
 #include <db/Iterator.hpp>
+#include <db/TupleView.hpp>
 #include <db/types.hpp>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 namespace db {
 
+/**
+ * @brief How the tuples of a HeapFile are laid out in its pages.
+ */
+    enum class PageFormat {
+        /// Fixed-size slots with CHAR_SIZE bytes per CHAR field (see HeapPage).
+        FIXED,
+        /// Variable-length records with a slot directory; long strings go to overflow pages (see SlottedPage).
+        SLOTTED,
+        /// The slots of PageFormat::FIXED, with the values of each field stored together (see PaxPage).
+        PAX,
+    };
+
+/**
+ * @brief How a DbFile lays out and accesses its pages on disk.
+ */
+    struct DbFileOptions {
+        /// The I/O backend that reads and writes the pages.
+        IoEngineType io = IoEngineType::SYNC;
+        /// Open the file with `O_DIRECT`, bypassing the kernel page cache. Ignored if the file system does not support it.
+        bool direct = false;
+        /// Open the file read-only and map it into memory: pages are read in place instead of through the BufferPool.
+        bool mmap = false;
+        /// The layout of the pages of a HeapFile. Other files ignore it.
+        PageFormat format = PageFormat::FIXED;
+        /// Keep a CRC32C checksum of every page in `<name>.crc`, stamped when the page is written and verified when it
+        /// is read from the file. Pages served from the BufferPool or from a mapping are not verified again.
+        bool checksums = false;
+        /// Store the pages compressed, in groups (see CompressedPages). Incompatible with `mmap`; `direct` is ignored.
+        bool compressed = false;
+    };
+
 /**
  * @brief Represents a database file.
  * @details It provides functions to read and write pages to the file, as well as to insert and delete tuples.
@@ -13,27 +52,74 @@ namespace db {
  * @note A `DbFile` object owns the `TupleDesc` object that describes the schema of the tuples in the file.
  */
     class DbFile {
+        /// Protects `reads` and `writes`: pages of the same file may be read and written concurrently.
+        mutable std::mutex io_latch;
         mutable std::vector<size_t> reads;
         mutable std::vector<size_t> writes;
 
         // TODO pa1: add private members
         int fd;
+        bool direct;
+        std::unique_ptr<IoEngine> io;
+
+        /// Whether the file is mapped read-only (DbFileOptions::mmap).
+        bool mapped;
+        /// Serializes remapping. Earlier mappings stay valid until the file is closed, since pages may still be in use.
+        mutable std::mutex map_latch;
+        mutable std::vector<std::pair<void *, size_t>> mappings;
+        mutable std::atomic<const uint8_t *> map_base{nullptr};
+        mutable std::atomic<size_t> map_pages{0};
+
+        /// The checksum file (DbFileOptions::checksums) and its contents: the CRC32C of every page, or 0 if unknown.
+        int crc_fd = -1;
+        mutable std::mutex crc_latch;
+        mutable std::vector<uint32_t> crcs;
+
+        /// The pages of a compressed file (DbFileOptions::compressed).
+        std::unique_ptr<CompressedPages> compressed;
+
+        /**
+         * Maps the whole file again if it grew since it was last mapped, and updates `numPages`.
+         */
+        void remap() const;
+
+        /**
+         * Reads or writes pages with a single batch. With `O_DIRECT`, pages that are not aligned to DEFAULT_PAGE_SIZE
+         * go through an aligned bounce buffer. The pages of a compressed file go through CompressedPages.
+         */
+        void transfer(const std::vector<std::pair<size_t, uint8_t *>> &pages, bool write) const;
+
+        /**
+         * Records the checksums of pages that were written, in memory and in the checksum file.
+         */
+        void stamp(const std::vector<std::pair<size_t, uint8_t *>> &pages) const;
+
+        /**
+         * Compares the checksums of pages that were read with the recorded ones. Throws std::runtime_error on a mismatch.
+         */
+        void verify(const std::vector<std::pair<size_t, uint8_t *>> &pages) const;
 
     protected:
         const std::string name;
+        /// The id of the file name (see Database::getId), used in the PageId of the pages of the file.
+        const size_t file_id;
         const TupleDesc td;
-        size_t numPages;
+        /// Mutable because a mapped file picks up pages appended by other writers when it is remapped.
+        mutable size_t numPages;
 
     public:
         /**
          * @brief Construct a new Db File object with the specified file name and tuple descriptor
          * @param name of the file to be opened or created.
          * @param td tuple description of tuples in the file.
-         * @throws std::runtime_error if the file cannot be opened or if the `fstat` system call fails.
+         * @param options how the pages are read and written.
+         * @throws std::runtime_error if the file (or its checksum file) cannot be opened or if the `fstat` system call
+         * fails.
+         * @throws std::invalid_argument if the file is both compressed and mapped.
          * @note This method calculates the number of pages in the file by dividing the file size (in bytes)
          * by the `DEFAULT_PAGE_SIZE`.
          */
-        explicit DbFile(const std::string &name, const TupleDesc &td);
+        explicit DbFile(const std::string &name, const TupleDesc &td, const DbFileOptions &options = {});
 
         /**
          * @brief closes the file descriptor.
@@ -42,31 +128,137 @@ namespace db {
 
         const std::string &getName() const;
 
+        size_t getId() const;
+
         const std::vector<size_t> &getReads() const;
 
         const std::vector<size_t> &getWrites() const;
 
+        /**
+         * @brief The I/O backend in use (IO_URING falls back to SYNC if the kernel does not support it).
+         */
+        IoEngineType getIoEngine() const;
+
+        /**
+         * @brief Whether the file was opened with `O_DIRECT`.
+         */
+        bool isDirect() const;
+
+        /**
+         * @brief Whether the file is mapped read-only into memory.
+         */
+        bool isMapped() const;
+
+        /**
+         * @brief Whether the pages are checksummed (DbFileOptions::checksums).
+         */
+        bool hasChecksums() const;
+
+        /**
+         * @brief Whether the pages are stored compressed (DbFileOptions::compressed).
+         */
+        bool isCompressed() const;
+
+        /**
+         * @brief Return a read-only view of a page.
+         * @details Pages of a mapped file are read in place, without copying them. Other pages are pinned in the
+         * BufferPool and latched in shared mode while the view exists.
+         * @param id The page number. Pages past the end of the file read as zeros.
+         */
+        PageView viewPage(size_t id) const;
+
+        /**
+         * @brief Hint that the file is about to be scanned sequentially.
+         * @details A mapped file is remapped if it grew, and the kernel is advised to read ahead aggressively
+         * (`MADV_SEQUENTIAL`). Nothing is done for other files.
+         */
+        void adviseSequential() const;
+
+        /**
+         * @brief Hint that pages will be read soon.
+         * @details The kernel is advised to read the pages of a mapped file (`MADV_WILLNEED`). The pages of other files
+         * are read into the BufferPool (see BufferPool::prefetch).
+         * @param first The page number of the first page.
+         * @param count The number of pages.
+         */
+        void adviseWillNeed(size_t first, size_t count) const;
+
         /**
          * @brief Read a page from the file.
          * @param page The page to read into.
          * @param id The page number of the page to be read. It determines the offset within the file.
+         * @note Pages past the end of the file read as zeros.
+         * @throws std::runtime_error if the read fails, or if the page does not match its checksum (e.g. it was only
+         * partially written).
          */
         void readPage(Page &page, size_t id) const;
 
+        /**
+         * @brief Read a batch of pages from the file.
+         * @details The reads are submitted together: adjacent pages are merged into a single system call by the SYNC
+         * backend, and all pages are in flight at once with the IO_URING backend.
+         * @param pages The page numbers and the pages to read into.
+         * @throws std::runtime_error if a read fails, or if a page does not match its checksum.
+         */
+        void readPages(const std::vector<std::pair<size_t, Page *>> &pages) const;
+
         /**
          * @brief Write a page to the file.
          * @param page The page to write.
          * @param id The page number of the page to which the data will be written.
          * It determines the offset in the file.
+         * @throws std::runtime_error if the write fails.
          */
         void writePage(const Page &page, size_t id) const;
 
+        /**
+         * @brief Write a batch of pages to the file.
+         * @details The writes are submitted together, like DbFile::readPages.
+         * @param pages The page numbers and the pages to write.
+         * @throws std::runtime_error if a write fails.
+         */
+        void writePages(const std::vector<std::pair<size_t, const Page *>> &pages) const;
+
+        /**
+         * @brief Remove the pages at the end of the file.
+         * @details The removed pages are discarded from the BufferPool without being written.
+         * @param pages The number of pages to keep. At least one page is kept in `numPages`. The checksums of the removed
+         * pages are removed too.
+         * @throws std::logic_error if the file is memory-mapped or a removed page is pinned.
+         * @throws std::runtime_error if the `ftruncate` system call fails.
+         */
+        void truncate(size_t pages);
+
         virtual void insertTuple(const Tuple &t);
 
         virtual void deleteTuple(const Iterator &it);
 
         virtual Tuple getTuple(const Iterator &it) const;
 
+        /**
+         * @brief Get a zero-copy view of a tuple.
+         * @details Unlike DbFile::getTuple, no Tuple is built: the fields are read from the page on demand.
+         * @param it The iterator that identifies the tuple.
+         * @return A view that keeps the page of the tuple pinned.
+         */
+        virtual TupleView view(const Iterator &it) const;
+
+        /**
+         * @brief Call a function with every tuple of the file, in the order of an iteration.
+         * @details The views are only valid during the call. The default implementation iterates over the file.
+         * @param f The function to call. It must not modify the file.
+         */
+        virtual void scan(const std::function<void(const TupleView &)> &f) const;
+
+        /**
+         * @brief Call a function with every tuple of the file, reading only some of its fields.
+         * @details Only the listed fields of the views may be read, so that a file storing its tuples by column does
+         * not read the others. The default implementation calls scan(f).
+         * @param fields The indexes of the fields read by `f`.
+         * @param f The function to call. It must not modify the file.
+         */
+        virtual void scan(const std::vector<size_t> &fields, const std::function<void(const TupleView &)> &f) const;
+
         virtual void next(Iterator &it) const;
 
         virtual Iterator begin() const;
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace db {
+
+/**
+ * @brief Tracks the approximate free space of every page of a file, to choose a page for an insert.
+ * @details The free space of a page is a single byte, in units chosen by the file (e.g. free slots or 16-byte blocks).
+ * The bytes are the leaves of an implicit binary tree in which every node holds the maximum of its children, so the
+ * first page with enough space is found, and a page is updated, in O(log n) with no allocation.
+ *
+ * The map is a hint: a page may have more or less space than recorded. Callers update a page after they modify it.
+ * It is persisted in a sidecar file, one byte per page (see FreeSpaceMap::load and FreeSpaceMap::save).
+ */
+    class FreeSpaceMap {
+        std::vector<uint8_t> tree;
+        /// The number of leaves of the tree (a power of 2), and the number of pages.
+        size_t leaves = 1;
+        size_t pages = 0;
+
+    public:
+        static constexpr size_t npos = SIZE_MAX;
+
+        /**
+         * @brief Create a map of `pages` pages with no free space.
+         */
+        explicit FreeSpaceMap(size_t pages = 0);
+
+        size_t size() const { return pages; }
+
+        uint8_t get(size_t page) const;
+
+        /**
+         * @brief Record the free space of a page. The map grows if the page is past its end.
+         */
+        void set(size_t page, uint8_t free);
+
+        /**
+         * @brief Forget the pages from `pages` on, e.g. after the file is truncated.
+         */
+        void truncate(size_t pages);
+
+        /**
+         * @brief Find the first page with at least `free` units of free space.
+         * @return The page number, or FreeSpaceMap::npos if no page has enough space.
+         */
+        size_t find(uint8_t free) const;
+
+        /**
+         * @brief Read the map from a sidecar file.
+         * @return False (and the map is unchanged) if the file does not exist or does not have one byte per page of
+         * a `pages`-page file, e.g. because it is stale.
+         */
+        bool load(const std::string &path, size_t pages);
+
+        /**
+         * @brief Write the map to a sidecar file.
+         * @throws std::runtime_error if the file cannot be written.
+         */
+        void save(const std::string &path) const;
+    };
+} // namespace db
@@ -1,22 +1,247 @@
 #pragma once
 
 #include <db/DbFile.hpp>
+#include <db/FreeSpaceMap.hpp>
+#include <db/SlottedPage.hpp>
+#include <atomic>
+#include <mutex>
+#include <span>
 
 namespace db {
+    /// Number of consecutive pages a scan must visit before pages are read ahead.
+    constexpr size_t READAHEAD_TRIGGER = 2;
+
+    /// Maximum number of pages read ahead of a sequential scan (at most a quarter of the buffer pool).
+    constexpr size_t READAHEAD_PAGES = 32;
+
+    /// Number of pages written at once by HeapFile::insertBatch.
+    constexpr size_t BATCH_PAGES = 64;
+
+    class BTreeFile;
+
+/**
+ * @brief A secondary index of a HeapFile (see HeapFile::createIndex).
+ */
+    struct SecondaryIndex {
+        /// The indexes of the key fields in the tuples of the heap file, from the most significant.
+        std::vector<size_t> fields;
+        /// One tuple per tuple of the heap file: its key fields, followed by its page and slot as INT fields. All the
+        /// fields are part of the key, so tuples with the same key have distinct entries, in the order of the file.
+        BTreeFile *file;
+    };
+
     class HeapFile : public DbFile {
+        const PageFormat format;
+        /// All the slots of the last page before this one are occupied (PageFormat::FIXED only, see HeapPage::insertTuple).
+        std::atomic<size_t> free_hint{0};
+
+        /// The free space of the pages: free slots (PageFormat::FIXED) or 16-byte units (PageFormat::SLOTTED).
+        mutable std::mutex fsm_latch;
+        FreeSpaceMap fsm;
+        /// Whether the free space of every page is recorded in `fsm`, and not only of the pages modified since the file
+        /// was opened without its map.
+        bool fsm_complete = true;
+
+        /**
+         * @brief Get the free space of a page, in the units of the FreeSpaceMap.
+         */
+        uint8_t freeSpace(const Page &page) const;
+
+        void updateFreeSpace(size_t page, uint8_t free);
+
+        /**
+         * @brief Insert a tuple into a page, if it has enough space.
+         * @param overflows The references to the strings of the tuple stored in overflow pages (PageFormat::SLOTTED).
+         * @param slot The slot of the tuple, if it was inserted.
+         * @return True if the tuple was inserted.
+         */
+        bool insertInto(size_t page, const Tuple &t, const std::vector<std::pair<size_t, SlottedPage::Overflow>> &overflows,
+                        size_t &slot);
+
+        /**
+         * @brief Insert a tuple into the first page before `limit` with enough free space according to the FreeSpaceMap.
+         * @param page The page of the tuple, if it was inserted.
+         * @param slot The slot of the tuple, if it was inserted.
+         * @return False if no page before `limit` has enough space.
+         */
+        bool insertFree(const Tuple &t, const std::vector<std::pair<size_t, SlottedPage::Overflow>> &overflows,
+                        size_t limit, size_t &page, size_t &slot);
+
+        /**
+         * @brief Called when a scan enters a page. Once the scan is sequential, the following pages are read ahead in
+         * batches, before the scan needs them (see DbFile::adviseWillNeed).
+         * @details The state is kept by each scan (or Iterator), so that concurrent scans do not reset each other.
+         * @param page The page entered by the scan, after the previous one.
+         * @param length The number of consecutive pages entered by the scan before this one.
+         * @param end The first page not read ahead yet by the scan.
+         */
+        void readAhead(size_t page, size_t &length, size_t &end) const;
+
+        /**
+         * @brief Store a string in a chain of new overflow pages (PageFormat::SLOTTED only).
+         */
+        SlottedPage::Overflow writeOverflow(const std::string &s);
+
+        /**
+         * @brief Read a string stored in overflow pages.
+         */
+        std::string readOverflow(const SlottedPage::Overflow &overflow) const;
+
+        /**
+         * @brief Zero the overflow pages of a string, so that they become empty pages.
+         */
+        void freeOverflow(const SlottedPage::Overflow &overflow);
+
+        /**
+         * @brief Read the tuple in a slot of a slotted page, with its strings stored in overflow pages.
+         */
+        Tuple resolve(const SlottedPage &page, size_t slot) const;
+
+        /**
+         * @brief Get the page number of the first page filled by a batch insert: the last page if it is empty (it is
+         * then discarded from the BufferPool), or the page after it.
+         */
+        size_t batchStart();
+
+        /**
+         * @brief Write pages filled by a batch insert directly to the file, and record their free space.
+         * @param pages The pages to write.
+         * @param count The number of pages to write, from the start of `pages`.
+         * @param first The page number of the first page.
+         */
+        void writeBatch(const std::vector<Page> &pages, size_t count, size_t first);
+
+        /// Protects `indexes` and serializes their updates: a BTreeFile is not latched.
+        mutable std::mutex index_latch;
+        std::vector<SecondaryIndex> indexes;
+
+        /**
+         * @brief Whether the file has indexes to update.
+         */
+        bool indexed() const;
+
+        /**
+         * @brief Build the entry of a tuple in an index.
+         */
+        static Tuple indexEntry(const SecondaryIndex &index, const Tuple &t, size_t page, size_t slot);
+
+        /**
+         * @brief Add the entries of a tuple to the indexes, or remove them.
+         * @details Either all the indexes are updated or none is: the entries added before a failed insertion are
+         * removed, and the entries to remove are all found before any is removed.
+         * @throws std::logic_error if an entry to remove is not in its index.
+         */
+        void updateIndexes(const Tuple &t, size_t page, size_t slot, bool insert);
+
+        /**
+         * @brief Call a function with every tuple of the pages in `[first, last)`, with its page and slot.
+         */
+        void forEachTuple(size_t first, size_t last, const std::function<void(const Tuple &, size_t, size_t)> &f) const;
+
     public:
-        HeapFile(const std::string &name, const TupleDesc &td);
+        /**
+         * @brief Open a heap file.
+         * @param options how the pages are laid out (DbFileOptions::format) and accessed. The format is not recorded in
+         * the file: a file must always be opened with the format it was created with.
+         */
+        HeapFile(const std::string &name, const TupleDesc &td, const DbFileOptions &options = {});
+
+        /**
+         * @brief Save the FreeSpaceMap of the file next to it, in `<name>.fsm`.
+         */
+        ~HeapFile() override;
+
+        PageFormat getFormat() const;
+
+        /**
+         * @brief Create a secondary index of the file.
+         * @details The index is a BTreeFile that maps the key fields of every tuple to its position (page and slot),
+         * so that the tuples with a key, or with keys in a range, are found without scanning the file (see
+         * db::filter). It is built from the tuples of the file with BTreeFile::bulkLoad and added to the Database,
+         * which owns it. From then on, it is updated by insertTuple, insertBatch, deleteTuple and vacuum.
+         *
+         * Like the format of the file, its indexes are not recorded in the file: an index is only maintained while
+         * the file is open, and must be created again (from an empty index file) when the file is reopened.
+         * @param name The name of the index file. It must not exist or be empty.
+         * @param fields The names of the key fields, from the most significant.
+         * @param options How the pages of the index are accessed.
+         * @return The index. It must stay in the Database while it is an index of the file (see dropIndex).
+         * @throws std::logic_error if the file or the index file is memory-mapped, or the index file is not empty or
+         * is already in the Database.
+         * @throws std::out_of_range if a field does not exist.
+         * @throws std::invalid_argument if the key has no fields or is too long (see KeyDesc).
+         */
+        BTreeFile &createIndex(const std::string &name, const std::vector<std::string> &fields,
+                               const DbFileOptions &options = {});
+
+        /**
+         * @brief Stop maintaining an index. The index file stays in the Database, and can then be removed from it.
+         * @param name The name of the index file.
+         * @throws std::invalid_argument if it is not an index of the file.
+         */
+        void dropIndex(const std::string &name);
+
+        /**
+         * @brief The secondary indexes of the file, in the order they were created.
+         */
+        std::vector<SecondaryIndex> getIndexes() const;
 
         /**
          * @brief Insert a tuple to the database file.
-         * @details Insert a tuple to the first available slot of the last page. If the last page is full, create a new page.
+         * @details Insert a tuple to the first page with enough free space according to the FreeSpaceMap, in its first
+         * available slot. If no page has enough space, create a new page.
+         * With PageFormat::SLOTTED, the longest strings of a large tuple are first written to new overflow pages
+         * (see SlottedPage::outOfLine). The tuple is then added to the indexes of the file.
          * @param t The tuple to be inserted.
          */
         void insertTuple(const Tuple &t) override;
 
+        /**
+         * @brief Insert many tuples at once.
+         * @details The tuples fill new pages at the end of the file, which are written BATCH_PAGES at a time with
+         * DbFile::writePages instead of going through the BufferPool, and `numPages` is updated once. The free space of
+         * the pages already in the file is not used.
+         * With PageFormat::SLOTTED, a tuple with strings too long for a record is inserted with HeapFile::insertTuple.
+         * The new pages are added to the indexes of the file once they are written.
+         * @param tuples The tuples to be inserted.
+         * @throws std::runtime_error if a tuple is not compatible with the TupleDesc.
+         * @throws std::logic_error if the file is memory-mapped.
+         */
+        void insertBatch(std::span<const Tuple> tuples);
+
+        /**
+         * @brief Insert many serialized tuples at once.
+         * @details Like HeapFile::insertBatch, but with PageFormat::FIXED the tuples are copied into the pages a page
+         * at a time, without being deserialized.
+         * @param data The tuples, serialized back to back with TupleDesc::serialize.
+         * @param count The number of tuples.
+         * @throws std::logic_error if the file is memory-mapped.
+         */
+        void insertBatch(const uint8_t *data, size_t count);
+
+        /**
+         * @brief Move the tuples at the end of the file to free space in earlier pages, and truncate the file.
+         * @details The tuples of the last page are inserted into the first pages with enough free space according to
+         * the FreeSpaceMap, and deleted from the last page. Once it is empty, the page is removed from the file and the
+         * next page is compacted, until `pages` pages are removed or the tuples of the last page do not fit in the
+         * earlier pages. The removed pages are then truncated from the file (see DbFile::truncate).
+         *
+         * A large file is compacted incrementally by calling this method until it returns 0, so that queries can run
+         * between the steps. If the file was opened without its map, the first call reads every page to rebuild it.
+         * @param pages The maximum number of pages to remove.
+         * @return The number of pages removed. 0 if the file cannot be compacted further.
+         * @throws std::logic_error if the file is memory-mapped.
+         * @note Moved tuples get new positions, which are updated in the indexes of the file: iterators to them are
+         * invalidated, and a scan running during a step may miss them, since they are removed from their page before
+         * they are inserted in another one (a scan never sees a tuple twice). With PageFormat::SLOTTED, compaction
+         * stops at an overflow page, since its chain is not relocated.
+         */
+        size_t vacuum(size_t pages = SIZE_MAX);
+
         /**
          * @brief Delete a tuple from the database file.
-         * @details Delete a tuple from the database file by marking the slot unused.
+         * @details Delete a tuple from the database file by marking the slot unused. Its overflow pages, if any, are
+         * zeroed and become empty pages. The tuple is first removed from the indexes of the file.
          * @param it The iterator that identifies the tuple to be deleted.
          */
         void deleteTuple(const Iterator &it) override;
@@ -29,11 +254,29 @@ namespace db {
          */
         Tuple getTuple(const Iterator &it) const override;
 
+        TupleView view(const Iterator &it) const override;
+
+        /**
+         * @brief Call a function with every tuple of the file, a page at a time.
+         * @details Each page is pinned and latched once to copy its tuples (instead of once per tuple with an
+         * Iterator), and pages are read ahead like during an iteration. No latch is held while `f` runs, so it may scan
+         * this file again or insert into other files. With PageFormat::PAX, every minipage is copied: scan the
+         * fields that are read instead.
+         */
+        void scan(const std::function<void(const TupleView &)> &f) const override;
+
+        /**
+         * @details Like scan(f), but with PageFormat::PAX only the occupied rows of the minipages of `fields` are
+         * copied, so the other columns are not brought into the cache. The other formats copy the whole page.
+         */
+        void scan(const std::vector<size_t> &fields, const std::function<void(const TupleView &)> &f) const override;
+
         /**
          * @brief Advance the iterator to the next tuple.
          * @details Advance the iterator to the next tuple by moving to the next slot of the page.
          * @param it The iterator to be advanced.
          * @note The next tuple may be on a subsequent page (pages might be empty).
+         * @note Pages are read ahead when the iterator moves through consecutive pages.
          */
         void next(Iterator &it) const override;
 
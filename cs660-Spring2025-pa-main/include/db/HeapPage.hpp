@@ -4,11 +4,36 @@
 
 namespace db {
     class HeapPage {
+    protected:
         const TupleDesc &td;
         size_t capacity;
         uint8_t *header;
         uint8_t *data;
 
+        /**
+         * Loads the bits of the header for slots [64 * i, 64 * i + 64), slot 64 * i being the most significant bit.
+         * The padding bits after the last slot are loaded as they are.
+         */
+        uint64_t word(size_t i) const;
+
+        /**
+         * Returns the first occupied (or free) slot at or after `slot`, or `capacity` if there is none.
+         * The header is scanned one 64-bit word at a time.
+         */
+        size_t find(size_t slot, bool occupied) const;
+
+        /**
+         * Marks the first free slot at or after `hint` as occupied, and updates the hint like HeapPage::insertTuple.
+         * Returns the slot, or `capacity` if the page is full.
+         */
+        size_t allocate(size_t &hint);
+
+        /**
+         * Marks the first `count` slots of an empty page as occupied (at most `capacity`), and returns their number.
+         * Throws std::logic_error if the page is not empty.
+         */
+        size_t occupy(size_t count);
+
     public:
         /**
          * @brief Wrap a page with a heap page.
@@ -20,6 +45,12 @@ namespace db {
          */
         HeapPage(Page &page, const TupleDesc &td);
 
+        /**
+         * @brief Wrap a read-only page (e.g. a page of a memory-mapped file).
+         * @note Only the const member functions may be used.
+         */
+        HeapPage(const Page &page, const TupleDesc &td);
+
         /**
          * @brief Get the first occupied slot of the page.
          * @return The first occupied slot of the page.
@@ -40,6 +71,31 @@ namespace db {
          */
         bool insertTuple(const Tuple &t);
 
+        /**
+         * @brief Insert a tuple to the page, starting the search for a free slot at a hint.
+         * @param t The tuple to be inserted.
+         * @param hint All the slots before the hint must be occupied. It is updated to the slot after the inserted tuple
+         * (or to the capacity if the page is full), so that repeated inserts take O(1) amortized time.
+         * @return True if the tuple is inserted successfully, false otherwise if the page is full.
+         */
+        bool insertTuple(const Tuple &t, size_t &hint);
+
+        /**
+         * @brief Fill an empty page with serialized tuples.
+         * @details The tuples are copied to the first slots with a single copy, since they have the same layout as
+         * the slots.
+         * @param data The tuples, serialized back to back with TupleDesc::serialize.
+         * @param count The number of tuples available.
+         * @return The number of tuples copied: the smaller of `count` and the capacity of the page.
+         * @throws std::logic_error if the page is not empty.
+         */
+        size_t fill(const uint8_t *data, size_t count);
+
+        /**
+         * @brief Count the free slots of the page.
+         */
+        size_t freeSlots() const;
+
         /**
          * @brief Delete a tuple from the page.
          * @details Delete a tuple from the page by marking the slot unused.
@@ -63,6 +119,14 @@ namespace db {
          */
         Tuple getTuple(size_t slot) const;
 
+        /**
+         * @brief Get the serialized bytes of the tuple at the specified slot.
+         * @param slot The slot of the tuple.
+         * @return A pointer to the tuple inside the page.
+         * @throws std::runtime_error if the slot is empty.
+         */
+        const uint8_t *tupleData(size_t slot) const;
+
         /**
          * @brief Advance the slot to the next occupied slot.
          * @details Advance the slot to the next occupied slot by scanning the header.
@@ -15,8 +15,14 @@ namespace db {
     struct IndexPage {
         uint16_t capacity;
 
+        /// The length of a key: sizeof(int) for int keys, KeyDesc::length for encoded keys.
+        size_t key_size;
+
         IndexPageHeader *header;
+        /// The keys, as ints (pages of int keys only).
         int *keys;
+        /// The keys, as `key_size` bytes each.
+        uint8_t *key_data;
         size_t *children;
 
         /**
@@ -27,12 +33,33 @@ namespace db {
          * The capacity of the page is calculated based on the remaining size of the page.
          *
          * @param page the page contents
-         * @param key_index the index of the key in the tuple
+         * @param key_size the length of a key: the int keys of the int API, or the encoded keys (see KeyDesc) of the
+         * byte API, which compare with `memcmp`
+         */
+        explicit IndexPage(Page &page, size_t key_size = sizeof(int));
+
+        /**
+         * @brief Initialize a read-only index page (e.g. a page of a memory-mapped file)
+         * @note Only the const member functions may be used.
+         */
+        explicit IndexPage(const Page &page, size_t key_size = sizeof(int));
+
+        /**
+         * @brief The key at a position
+         */
+        const uint8_t *key(size_t pos) const { return key_data + pos * key_size; }
+
+        /**
+         * @brief The position of the child that may contain an encoded key
+         * @details A key equal to a separator belongs to the child on its right (the separator is the first key of
+         * that child when it is split), so the child is found with a binary search for the first greater key.
+         * @param key the key to look up
+         * @return the position of the child, in [0, `header->size`]
          */
-        explicit IndexPage(Page &page);
+        size_t search(const uint8_t *key) const;
 
         /**
-         * @brief Insert a new key with a corresponding child page number
+         * @brief Insert a new key with a corresponding child page number (pages of int keys)
          * @param key the key to insert
          * @param child the child page number
          * @return true if the page is full and needs to be split
@@ -40,12 +67,54 @@ namespace db {
         bool insert(int key, size_t child);
 
         /**
-         * @brief Split the index page
+         * @brief Insert a new encoded key with a corresponding child page number
+         * @param key the key to insert
+         * @param child the child page number
+         * @return true if the page is full and needs to be split
+         */
+        bool insert(const uint8_t *key, size_t child);
+
+        /**
+         * @brief Remove a key and the child on its right
+         * @param pos the position of the key
+         */
+        void erase(size_t pos);
+
+        /**
+         * @brief Move the separator and all the keys and children of the next sibling to the end of this page
+         * @param right the next sibling, which must fit in this page
+         * @param separator the key between the two pages in their parent
+         */
+        void merge(IndexPage &right, const uint8_t *separator);
+
+        /**
+         * @brief Move keys and children between this page and its next sibling, through the separator in their parent,
+         * so that they hold the same number of keys (+/- 1)
+         * @param right the next sibling
+         * @param separator the key between the two pages in their parent
+         * @param new_separator the new separator, `key_size` bytes
+         */
+        void redistribute(IndexPage &right, const uint8_t *separator, uint8_t *new_separator);
+
+        /**
+         * @brief Split the index page (pages of int keys)
          * @details The page is split into two pages. The old page contains the first half of the tuples, and the new page contains the second half.
          * @param new_page a new empty page
          * @return the split key (this key is moved to the parent page)
          */
         int split(IndexPage &new_page);
+
+        /**
+         * @brief Split the index page
+         * @details The page is split into two pages. The old page contains the first half of the keys, and the new
+         * page contains the second half.
+         * @param new_page a new empty page
+         * @param separator the split key (this key is moved to the parent page), `key_size` bytes
+         */
+        void split(IndexPage &new_page, uint8_t *separator);
+
+    private:
+        void insertAt(size_t pos, const uint8_t *key, size_t child);
     };
 
 } // namespace db
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <sys/types.h>
+#include <vector>
+
+namespace db {
+
+/**
+ * @brief The I/O backends a DbFile can use.
+ * @details
+ *   SYNC issues blocking `preadv`/`pwritev` calls, one per run of adjacent requests.
+ *   IO_URING submits a whole batch to an io_uring submission queue and waits for all completions, so the device sees
+ *   the batch at once instead of one request at a time. It falls back to SYNC if the kernel does not support io_uring.
+ */
+    enum class IoEngineType {
+        SYNC, IO_URING
+    };
+
+/**
+ * @brief A single read or write of a contiguous buffer at a file offset.
+ */
+    struct IoRequest {
+        int fd;
+        uint8_t *buf;
+        size_t length;
+        off_t offset;
+        bool write;
+    };
+
+/**
+ * @brief Executes batches of read and write requests.
+ * @details A batch completes when every request has transferred all its bytes. Short transfers are resumed. A read
+ * that reaches the end of the file fills the rest of its buffer with zeros.
+ */
+    class IoEngine {
+    public:
+        virtual ~IoEngine() = default;
+
+        /**
+         * @brief The backend that executes the requests (after any fallback).
+         */
+        virtual IoEngineType type() const = 0;
+
+        /**
+         * @brief Execute a batch of requests and wait for all of them.
+         * @param requests The requests. The buffers must stay valid until the method returns.
+         * @throws std::runtime_error if a request fails. No request of the batch is still in flight by then.
+         */
+        virtual void submit(const std::vector<IoRequest> &requests) = 0;
+    };
+
+    class SyncIoEngine : public IoEngine {
+    public:
+        IoEngineType type() const override;
+
+        void submit(const std::vector<IoRequest> &requests) override;
+    };
+
+    class UringIoEngine : public IoEngine {
+    public:
+        /// The number of requests in flight per thread
+        static constexpr unsigned QUEUE_DEPTH = 64;
+
+        /**
+         * @brief Whether io_uring is usable by the calling thread.
+         */
+        static bool supported();
+
+        IoEngineType type() const override;
+
+        void submit(const std::vector<IoRequest> &requests) override;
+    };
+
+/**
+ * @brief Create an I/O engine.
+ * @param type The requested backend.
+ * @return The engine. An IO_URING request returns a SYNC engine if io_uring is not supported.
+ */
+    std::unique_ptr<IoEngine> makeIoEngine(IoEngineType type);
+} // namespace db
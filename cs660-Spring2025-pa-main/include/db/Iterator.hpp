@@ -5,10 +5,16 @@
 namespace db {
     class DbFile;
 
+    class TupleView;
+
     struct Iterator {
         const DbFile &file;
         size_t page;
         size_t slot;
+        /// The read-ahead state of a scan with this iterator (see HeapFile): the number of consecutive pages entered
+        /// by the scan, and the first page not read ahead yet.
+        size_t scan_length = 0;
+        size_t readahead_end = 0;
 
     public:
         Iterator(const DbFile &file, const size_t &page, size_t slot);
@@ -21,6 +27,11 @@ namespace db {
 
         Tuple operator*() const;
 
+        /**
+         * @brief View the current tuple without copying it (see DbFile::view).
+         */
+        TupleView view() const;
+
         Iterator &operator++();
 
         bool operator==(const Iterator &other) const { return page == other.page && slot == other.slot; }
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <db/Tuple.hpp>
+
+namespace db {
+    /// Maximum length of an encoded key (e.g. four CHAR fields), so that an IndexPage holds enough keys.
+    constexpr size_t MAX_KEY_SIZE = 4 * CHAR_SIZE;
+
+/**
+ * @brief Describes the key of a BTreeFile: one or more fields of a tuple, compared in order.
+ * @details Keys are encoded into fixed-length byte strings that compare with `memcmp` in the same order as the fields:
+ * - an INT is stored big-endian with its sign bit flipped, so that negative numbers come first;
+ * - a DOUBLE is stored big-endian with its sign bit flipped if it is positive, and all its bits flipped if it is
+ *   negative (-0.0 is encoded as 0.0);
+ * - a CHAR is stored as serialized, padded with NULs, so that a string comes before the strings it is a prefix of.
+ *
+ * The key of a composite key is the concatenation of the encoded fields. Comparing two keys, in the leaves as in the
+ * index pages, is then a single `memcmp` whatever the types of the fields.
+ */
+    class KeyDesc {
+        std::vector<size_t> key_fields;
+        std::vector<type_t> types;
+        /// The offsets of the fields in a serialized tuple.
+        std::vector<size_t> offsets;
+        size_t len = 0;
+
+    public:
+        /**
+         * @brief Describe a key
+         * @param td the tuple descriptor of the tuples
+         * @param fields the indexes of the key fields in a tuple, from the most significant
+         * @throws std::invalid_argument if there are no fields, a field is out of range or the key is longer than
+         * MAX_KEY_SIZE
+         */
+        KeyDesc(const TupleDesc &td, std::vector<size_t> fields);
+
+        /**
+         * @brief The length of an encoded key
+         */
+        size_t length() const { return len; }
+
+        /**
+         * @brief The indexes of the key fields in a tuple
+         */
+        const std::vector<size_t> &fields() const { return key_fields; }
+
+        /**
+         * @brief Encode the key of a serialized tuple
+         * @param key the encoded key, length() bytes
+         * @param tuple the serialized tuple
+         */
+        void encode(uint8_t *key, const uint8_t *tuple) const;
+
+        /**
+         * @brief Encode the key of a tuple
+         * @param key the encoded key, length() bytes
+         * @param t the tuple
+         */
+        void encode(uint8_t *key, const Tuple &t) const;
+
+        /**
+         * @brief Encode the values of the key fields, or of their first fields
+         * @details A prefix of a composite key is encoded as the prefix of the keys that start with it, and the
+         * remaining bytes are filled with `pad`: 0x00 gives the smallest key with the prefix and 0xff the largest.
+         * @param key the encoded key, length() bytes
+         * @param values the values of the first key fields
+         * @param pad the byte of the fields that are not given
+         * @throws std::invalid_argument if there are too many values or a value does not match the type of its field
+         */
+        void encode(uint8_t *key, const std::vector<field_t> &values, uint8_t pad = 0) const;
+    };
+} // namespace db
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <db/KeyDesc.hpp>
 #include <db/Tuple.hpp>
+#include <optional>
 
 namespace db {
 
@@ -15,7 +17,7 @@ namespace db {
     struct LeafPage {
         const TupleDesc &td;
 
-        /// The index of the key in a tuple (the key field should be of type int)
+        /// The index of the key in a tuple (the first field of a composite key)
         const size_t key_index;
 
         uint16_t capacity;
@@ -23,6 +25,12 @@ namespace db {
         LeafPageHeader *header;
         uint8_t *data;
 
+    private:
+        /// The key of a page initialized with a key index.
+        std::optional<KeyDesc> owned_key;
+        const KeyDesc *key_desc;
+
+    public:
         /**
          * @brief Initialize a leaf page
          *
@@ -35,6 +43,28 @@ namespace db {
          */
         LeafPage(Page &page, const TupleDesc &td, size_t key_index);
 
+        /**
+         * @brief Initialize a read-only leaf page (e.g. a page of a memory-mapped file)
+         * @note Only the const member functions may be used.
+         */
+        LeafPage(const Page &page, const TupleDesc &td, size_t key_index);
+
+        /**
+         * @brief Initialize a leaf page whose tuples are sorted by a (possibly composite) key
+         * @param page the page contents
+         * @param td the tuple descriptor
+         * @param key the key, which must outlive the page
+         */
+        LeafPage(Page &page, const TupleDesc &td, const KeyDesc &key);
+
+        /**
+         * @brief Initialize a read-only leaf page whose tuples are sorted by a key
+         * @note Only the const member functions may be used.
+         */
+        LeafPage(const Page &page, const TupleDesc &td, const KeyDesc &key);
+
+        LeafPage(const LeafPage &) = delete;
+
         /**
          * @brief Insert a tuple into the page
          * @details The tuple is inserted in sorted order based on the key. If the key already exists, the previous tuple is replaced.
@@ -42,13 +72,50 @@ namespace db {
          */
         bool insertTuple(const Tuple &t);
 
+        /**
+         * @brief The slot of the first tuple with a key not less than an encoded key (`header->size` if there is none)
+         */
+        size_t lowerBound(const uint8_t *key) const;
+
+        /**
+         * @brief The slot of the first tuple with a key greater than an encoded key (`header->size` if there is none)
+         */
+        size_t upperBound(const uint8_t *key) const;
+
+        /**
+         * @brief Encode the key of a tuple (see KeyDesc)
+         * @param slot the slot of the tuple
+         * @param key the encoded key, KeyDesc::length bytes
+         * @throws std::out_of_range if the slot is out of range
+         */
+        void key(size_t slot, uint8_t *key) const;
+
+        /**
+         * @brief Remove a tuple, shifting the following tuples down
+         * @throws std::out_of_range if the slot is out of range
+         */
+        void erase(size_t slot);
+
+        /**
+         * @brief Move all the tuples of the next leaf to the end of this one, and unlink the next leaf
+         * @param right the next leaf, which must fit in this page
+         */
+        void merge(LeafPage &right);
+
+        /**
+         * @brief Move tuples between this page and the next leaf so that they hold the same number of tuples (+/- 1)
+         * @details The new split key is the first key of the next leaf.
+         * @param right the next leaf
+         */
+        void redistribute(LeafPage &right);
+
         /**
          * @brief Split the leaf page
-         * @details The page is split into two pages. The old page contains the first half of the tuples, and the new page contains the second half.
+         * @details The page is split into two pages. The old page contains the first half of the tuples, and the new
+         * page contains the second half. The split key is the first key of the new page.
          * @param new_page a new empty page
-         * @return the split key (the first key of the new page)
          */
-        int split(LeafPage &new_page);
+        void split(LeafPage &new_page);
 
         /**
          * @brief Get a tuple from the database file.
@@ -57,6 +124,13 @@ namespace db {
          * @return The tuple read from the page.
          */
         Tuple getTuple(size_t slot) const;
+
+        /**
+         * @brief Get the serialized bytes of a tuple
+         * @return a pointer to the tuple inside the page
+         * @throws std::out_of_range if the slot is out of range
+         */
+        const uint8_t *tupleData(size_t slot) const;
     };
 
 } // namespace db
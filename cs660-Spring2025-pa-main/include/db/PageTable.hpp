@@ -0,0 +1,76 @@
+#pragma once
+
+#include <db/types.hpp>
+#include <memory>
+
+namespace db {
+
+/**
+ * @brief Maps page ids to frame positions with an open-addressing hash table.
+ * @details Entries are stored inline in a single array and probed linearly, so a lookup touches one or two cache lines
+ * and never allocates. Erased entries are removed by shifting the following entries back, so no tombstones accumulate.
+ * The table doubles when it is half full.
+ */
+    class PageTable {
+        struct Slot {
+            PageId pid;
+            size_t pos;
+        };
+
+        static constexpr size_t EMPTY = SIZE_MAX;
+
+        std::unique_ptr<Slot[]> slots;
+        /// The number of slots is `1 << bits`
+        size_t bits;
+        size_t count = 0;
+
+        size_t home(const PageId &pid) const;
+
+        size_t mask() const { return (size_t{1} << bits) - 1; }
+
+        /// Returns the slot holding `pid`, or the empty slot where it would be inserted.
+        size_t probe(const PageId &pid) const;
+
+        void grow();
+
+    public:
+        explicit PageTable(size_t capacity = 16);
+
+        /**
+         * @brief Return the frame position of a page, or nullptr if the page is not in the table.
+         */
+        const size_t *find(const PageId &pid) const;
+
+        /**
+         * @brief Return the frame position of a page.
+         * @throws std::out_of_range if the page is not in the table.
+         */
+        size_t at(const PageId &pid) const;
+
+        bool contains(const PageId &pid) const { return find(pid) != nullptr; }
+
+        /**
+         * @brief Insert a page, or update its frame position if it is already in the table.
+         */
+        void insert(const PageId &pid, size_t pos);
+
+        /**
+         * @brief Remove a page if it is in the table.
+         */
+        void erase(const PageId &pid);
+
+        size_t size() const { return count; }
+
+        /**
+         * @brief Call `f(pid, pos)` for every page in the table.
+         */
+        template<typename F>
+        void forEach(F &&f) const {
+            for (size_t i = 0; i <= mask(); i++) {
+                if (slots[i].pos != EMPTY) {
+                    f(slots[i].pid, slots[i].pos);
+                }
+            }
+        }
+    };
+} // namespace db
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <db/HeapPage.hpp>
+
+namespace db {
+
+/**
+ * @brief A heap page that stores its tuples column by column (PAX, Partition Attributes Across).
+ * @details The page has the same header and the same number of slots as a HeapPage, but the data area is split into
+ * one minipage per field: the values of field `i` are stored back to back, in slot order, starting at `capacity *
+ * TupleDesc::offset(i)` bytes into the data area. A scan that reads a few fields of every tuple only brings the
+ * minipages of those fields into the cache.
+ *
+ * The members inherited from HeapPage that only read or write the header (HeapPage::begin, HeapPage::next,
+ * HeapPage::deleteTuple, HeapPage::freeSlots, ...) apply unchanged, so a PaxPage can be handled as a HeapPage for
+ * anything but the values of its tuples.
+ */
+    class PaxPage : public HeapPage {
+    public:
+        PaxPage(Page &page, const TupleDesc &td);
+
+        /**
+         * @brief Wrap a read-only page (e.g. a page of a memory-mapped file).
+         * @note Only the const member functions may be used.
+         */
+        PaxPage(const Page &page, const TupleDesc &td);
+
+        /**
+         * @brief Insert a tuple to the page, scattering its fields to the minipages.
+         * @return True if the tuple is inserted successfully, false otherwise if the page is full.
+         */
+        bool insertTuple(const Tuple &t);
+
+        /**
+         * @brief Insert a tuple to the page, starting the search for a free slot at a hint (see HeapPage::insertTuple).
+         */
+        bool insertTuple(const Tuple &t, size_t &hint);
+
+        /**
+         * @brief Fill an empty page with serialized tuples, transposing them into the minipages.
+         * @param data The tuples, serialized back to back with TupleDesc::serialize.
+         * @param count The number of tuples available.
+         * @return The number of tuples copied: the smaller of `count` and the capacity of the page.
+         * @throws std::logic_error if the page is not empty.
+         */
+        size_t fill(const uint8_t *data, size_t count);
+
+        /**
+         * @brief Get the tuple at the specified slot, gathering its fields from the minipages.
+         * @throws std::runtime_error if the slot is empty.
+         */
+        Tuple getTuple(size_t slot) const;
+
+        /**
+         * @brief Get the minipage of a field: the value of the field for slot `s` starts at
+         * `column(field) + s * td.field_length(field)`.
+         * @param field The index of the field.
+         */
+        const uint8_t *column(size_t field) const;
+
+        /// The tuples of a PaxPage are not contiguous.
+        const uint8_t *tupleData(size_t slot) const = delete;
+    };
+} // namespace db
@@ -5,6 +5,8 @@
 #include <vector>
 
 namespace db {
+    /// db::filter uses an index of a HeapFile if at most this many tuples per page of the file are in its range.
+    constexpr double INDEX_MATCHES_PER_PAGE = 1.0;
 
 /**
  * @brief The operation of a predicate.
@@ -84,6 +86,9 @@ namespace db {
  * @details A filter operation selects rows that satisfy a set of predicates.
  *   The predicates are combined with a logical AND.
  *   The output table is stored in the out table.
+ *   If the input is a HeapFile with a secondary index on the field of a predicate (other than NE), and the range
+ *   of the index matches few tuples (see INDEX_MATCHES_PER_PAGE), only the tuples in the range are read, in the
+ *   order of the file. Otherwise the whole file is scanned.
  * @param in The input table.
  * @param out The output table.
  * @param pred The predicates to filter rows.
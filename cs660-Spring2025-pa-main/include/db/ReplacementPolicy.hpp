@@ -0,0 +1,189 @@
+#pragma once
+
+#include <db/types.hpp>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <set>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace db {
+
+/**
+ * @brief The page replacement algorithms supported by the BufferPool.
+ * @details
+ *   LRU evicts the least recently used page.
+ *   CLOCK approximates LRU with a reference bit per frame and a sweeping hand.
+ *   TWO_Q admits new pages to a FIFO queue and only promotes them to the main LRU queue when they are re-referenced,
+ *   so a sequential scan cannot flush frequently used pages.
+ *   LRU_K evicts the page whose K-th most recent access is the oldest (pages with fewer than K accesses go first).
+ */
+    enum class ReplacementPolicyType {
+        LRU, CLOCK, TWO_Q, LRU_K
+    };
+
+/**
+ * @brief Decides which frame of the BufferPool to evict.
+ * @details Frames are identified by their position in the BufferPool. The BufferPool notifies the policy when a page is
+ * loaded into a frame, when a resident page is accessed, and when a frame is emptied.
+ */
+    class ReplacementPolicy {
+    public:
+        virtual ~ReplacementPolicy() = default;
+
+        /**
+         * @brief A page was loaded into a frame.
+         * @param pos The position of the frame.
+         * @param pid The page id of the loaded page.
+         */
+        virtual void insert(size_t pos, const PageId &pid) = 0;
+
+        /**
+         * @brief The page in a frame was accessed.
+         * @param pos The position of the frame.
+         */
+        virtual void access(size_t pos) = 0;
+
+        /**
+         * @brief A frame was emptied and should no longer be tracked.
+         * @param pos The position of the frame.
+         */
+        virtual void erase(size_t pos) = 0;
+
+        /**
+         * @brief The page in a frame was evicted to make room for another page, and the frame should no longer be
+         * tracked.
+         * @details Unlike ReplacementPolicy::erase, which is also called when a page is discarded or moved to another
+         * frame, this lets a policy keep a history of the evicted pages. By default, the frame is erased.
+         * @param pos The position of the frame.
+         */
+        virtual void evict(size_t pos) { erase(pos); }
+
+        /**
+         * @brief Choose the frame to evict.
+         * @param evictable Whether a frame may be evicted (e.g. it is not pinned).
+         * @return The position of the frame to evict.
+         * @throws std::runtime_error if no tracked frame is evictable.
+         * @note The frame remains tracked until ReplacementPolicy::evict or ReplacementPolicy::erase is called.
+         */
+        virtual size_t victim(const std::function<bool(size_t)> &evictable) = 0;
+
+        /**
+         * @brief The number of frames in the BufferPool changed.
+         * @param numPages The new number of frames. All tracked frames are smaller than this number.
+         */
+        virtual void resize(size_t numPages) = 0;
+    };
+
+    class LruPolicy : public ReplacementPolicy {
+        /// Intrusive doubly linked list over the frames, most recently used first. Index `numPages` is the sentinel.
+        std::vector<size_t> prev;
+        std::vector<size_t> next;
+
+        size_t sentinel() const { return prev.size() - 1; }
+
+        void link(size_t pos);
+
+        void unlink(size_t pos);
+
+    public:
+        explicit LruPolicy(size_t numPages);
+
+        void insert(size_t pos, const PageId &pid) override;
+
+        void access(size_t pos) override;
+
+        void erase(size_t pos) override;
+
+        size_t victim(const std::function<bool(size_t)> &evictable) override;
+
+        void resize(size_t numPages) override;
+    };
+
+    class ClockPolicy : public ReplacementPolicy {
+        std::vector<bool> resident;
+        std::vector<bool> referenced;
+        size_t hand = 0;
+
+    public:
+        explicit ClockPolicy(size_t numPages);
+
+        void insert(size_t pos, const PageId &pid) override;
+
+        void access(size_t pos) override;
+
+        void erase(size_t pos) override;
+
+        size_t victim(const std::function<bool(size_t)> &evictable) override;
+
+        void resize(size_t numPages) override;
+    };
+
+    class TwoQPolicy : public ReplacementPolicy {
+        /// Maximum size of the FIFO queue of pages referenced once (A1in)
+        size_t kin;
+        /// Maximum number of remembered pages recently evicted from A1in (A1out)
+        size_t kout;
+
+        std::list<size_t> a1in;
+        std::list<size_t> am;
+        std::unordered_map<size_t, std::pair<bool, std::list<size_t>::iterator>> pos_to_queue;
+        std::unordered_map<size_t, PageId> pos_to_pid;
+
+        std::deque<PageId> a1out;
+        std::unordered_map<const PageId, size_t> a1out_count;
+
+        void remember(const PageId &pid);
+
+    public:
+        explicit TwoQPolicy(size_t numPages);
+
+        void insert(size_t pos, const PageId &pid) override;
+
+        void access(size_t pos) override;
+
+        void erase(size_t pos) override;
+
+        void evict(size_t pos) override;
+
+        size_t victim(const std::function<bool(size_t)> &evictable) override;
+
+        void resize(size_t numPages) override;
+    };
+
+    class LruKPolicy : public ReplacementPolicy {
+        size_t k;
+        size_t clock = 0;
+
+        /// The most recent access times of each frame, newest last (at most k entries)
+        std::unordered_map<size_t, std::deque<size_t>> history;
+        /// Frames ordered by eviction priority: (has k accesses, k-th most recent or most recent access, pos)
+        std::set<std::tuple<bool, size_t, size_t>> order;
+
+        std::tuple<bool, size_t, size_t> key(size_t pos) const;
+
+    public:
+        explicit LruKPolicy(size_t k = 2);
+
+        void insert(size_t pos, const PageId &pid) override;
+
+        void access(size_t pos) override;
+
+        void erase(size_t pos) override;
+
+        size_t victim(const std::function<bool(size_t)> &evictable) override;
+
+        void resize(size_t numPages) override;
+    };
+
+/**
+ * @brief Create a replacement policy.
+ * @param type The replacement algorithm.
+ * @param numPages The number of frames in the BufferPool.
+ * @return The replacement policy.
+ */
+    std::unique_ptr<ReplacementPolicy> makeReplacementPolicy(ReplacementPolicyType type, size_t numPages);
+} // namespace db
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <db/DbFile.hpp>
+#include <string_view>
+
+namespace db {
+
+/**
+ * @brief A heap page with a slot directory and variable-length records.
+ * @details The page starts with an 8-byte header (page kind, number of slots, start of the record area) followed by the
+ * slot directory, which grows forward. Each slot holds the offset and length of its record; an offset of 0 marks an
+ * empty slot. Records are packed backwards from the end of the page.
+ *
+ * A record is the fixed part of the tuple (see TupleDesc::var_offset), in which every CHAR field is a reference to its
+ * characters, stored right after the fixed part. Strings are not padded nor truncated to CHAR_SIZE. A string too long
+ * to be kept in the record is stored in a chain of overflow pages of the same file, and the record holds an
+ * Overflow instead (see HeapFile::insertTuple).
+ *
+ * A zeroed page is an empty slotted page.
+ */
+    class SlottedPage {
+        const TupleDesc &td;
+        uint8_t *page;
+
+        size_t count() const;
+
+        size_t upper() const;
+
+        size_t recordOffset(size_t slot) const;
+
+        size_t recordLength(size_t slot) const;
+
+        /**
+         * Moves the records to the end of the page, so that all the free space is between the directory and the records.
+         */
+        void compact();
+
+    public:
+        /// The location of a string stored in overflow pages.
+        struct Overflow {
+            /// The page number of the first overflow page of the chain.
+            uint32_t page;
+            /// The length of the string.
+            uint32_t length;
+        };
+
+        static constexpr size_t HEADER_SIZE = 8;
+        static constexpr size_t SLOT_SIZE = 2 * sizeof(uint16_t);
+        /// The length of a CHAR reference to an Overflow.
+        static constexpr uint16_t OVERFLOW_LENGTH = UINT16_MAX;
+        /// Records are kept below this size by moving their longest strings to overflow pages.
+        static constexpr size_t MAX_RECORD_SIZE = DEFAULT_PAGE_SIZE / 4;
+        /// The number of bytes of a string stored in each overflow page.
+        static constexpr size_t OVERFLOW_CAPACITY = DEFAULT_PAGE_SIZE - HEADER_SIZE;
+
+        /**
+         * @brief Wrap a page with a slotted page.
+         * @param page The page to be wrapped.
+         * @param td The tuple descriptor of the page.
+         */
+        SlottedPage(Page &page, const TupleDesc &td);
+
+        /**
+         * @brief Wrap a read-only page (e.g. a page of a memory-mapped file).
+         * @note Only the const member functions may be used.
+         */
+        SlottedPage(const Page &page, const TupleDesc &td);
+
+        /**
+         * @brief Choose the CHAR fields of a tuple to store in overflow pages.
+         * @details The longest strings are moved out of the record until it is at most MAX_RECORD_SIZE bytes.
+         * @return The indexes of the fields, in increasing order.
+         */
+        static std::vector<size_t> outOfLine(const TupleDesc &td, const Tuple &t);
+
+        /**
+         * @brief Get the size of the record of a tuple.
+         * @param overflows The CHAR fields of the tuple stored in overflow pages, by increasing field index.
+         */
+        static size_t recordSize(const TupleDesc &td, const Tuple &t,
+                                 const std::vector<std::pair<size_t, Overflow>> &overflows = {});
+
+        /**
+         * @brief Get the number of free bytes of the page, including the space of deleted records.
+         * @details A record of `n` bytes fits if `n + SLOT_SIZE` bytes are free. An overflow page has no free space.
+         */
+        size_t freeSpace() const;
+
+        /**
+         * @brief Whether the page is an overflow page. An overflow page has no slots.
+         */
+        bool isOverflow() const;
+
+        /**
+         * @brief Get the first occupied slot of the page.
+         */
+        size_t begin() const;
+
+        /**
+         * @brief Get the end of the page: the number of slots in the directory.
+         */
+        size_t end() const;
+
+        /**
+         * @brief Insert a tuple to the page.
+         * @details The first empty slot of the directory is reused, if any. The page is compacted if the free space is
+         * fragmented.
+         * @param t The tuple to be inserted.
+         * @param overflows The CHAR fields of the tuple stored in overflow pages, by increasing field index.
+         * @return True if the tuple is inserted successfully, false if there is not enough free space.
+         * @throws std::length_error if the record would not fit in an empty page.
+         */
+        bool insertTuple(const Tuple &t, const std::vector<std::pair<size_t, Overflow>> &overflows = {});
+
+        /**
+         * @brief Insert a tuple to the page, like SlottedPage::insertTuple.
+         * @param slot The slot of the inserted tuple, if it is inserted.
+         */
+        bool insertTuple(const Tuple &t, const std::vector<std::pair<size_t, Overflow>> &overflows, size_t &slot);
+
+        /**
+         * @brief Delete a tuple from the page.
+         * @details The slot is marked empty. The overflow pages of the tuple are not freed (see HeapFile::deleteTuple).
+         * @throws std::runtime_error if the slot is out of range or empty.
+         */
+        void deleteTuple(size_t slot);
+
+        /**
+         * @brief Check if the slot is empty.
+         */
+        bool empty(size_t slot) const;
+
+        /**
+         * @brief Get the tuple at the specified slot.
+         * @note Fields stored in overflow pages are returned as empty strings (see SlottedPage::overflows).
+         * @throws std::runtime_error if the slot is empty.
+         */
+        Tuple getTuple(size_t slot) const;
+
+        /**
+         * @brief Get the record of the tuple at the specified slot.
+         * @throws std::runtime_error if the slot is empty.
+         */
+        const uint8_t *tupleData(size_t slot) const;
+
+        /**
+         * @brief Get the CHAR fields of the tuple at the specified slot that are stored in overflow pages.
+         * @throws std::runtime_error if the slot is empty.
+         */
+        std::vector<std::pair<size_t, Overflow>> overflows(size_t slot) const;
+
+        /**
+         * @brief Advance the slot to the next occupied slot.
+         */
+        void next(size_t &slot) const;
+
+        /**
+         * @brief Make the page an overflow page.
+         * @param chunk The part of the string stored in this page, at most OVERFLOW_CAPACITY bytes.
+         * @param next The page number of the next page of the chain, or 0 if this is the last one.
+         */
+        void makeOverflow(std::string_view chunk, size_t next);
+
+        /**
+         * @brief Read the part of a string stored in an overflow page.
+         * @param next Set to the page number of the next page of the chain, or 0 if this is the last one.
+         * @throws std::runtime_error if the page is not an overflow page.
+         */
+        std::string_view readOverflow(size_t &next) const;
+    };
+} // namespace db
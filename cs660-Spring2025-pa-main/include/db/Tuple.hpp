@@ -13,6 +13,8 @@ namespace db {
     public:
         Tuple(const std::vector<field_t> &fields);
 
+        Tuple(std::vector<field_t> &&fields);
+
         type_t field_type(size_t i) const;
 
         size_t size() const;
@@ -28,6 +30,22 @@ namespace db {
         std::vector<size_t> offsets;
         std::unordered_map<std::string, size_t> name_to_index;
 
+        /// The layout is computed once at construction: the serialized length and whether the numeric fields are aligned.
+        size_t len = 0;
+        bool is_aligned = true;
+
+        /// The offsets and the length of the fixed part of a variable-length record, where CHAR fields are references.
+        std::vector<size_t> var_offsets;
+        size_t var_len = 0;
+
+        /// Serialization routines: specialized at compile time for common schemas, generic otherwise (see Tuple.cpp).
+        void (*serializer)(const TupleDesc &, uint8_t *, const Tuple &) = &TupleDesc::serializeAny;
+        Tuple (*deserializer)(const TupleDesc &, const uint8_t *) = &TupleDesc::deserializeAny;
+
+        static void serializeAny(const TupleDesc &td, uint8_t *data, const Tuple &t);
+
+        static Tuple deserializeAny(const TupleDesc &td, const uint8_t *data);
+
     public:
         TupleDesc() = default;
 
@@ -58,6 +76,39 @@ namespace db {
          */
         size_t offset_of(const size_t &index) const;
 
+        /**
+         * @brief Get offset of the field, without bounds checking
+         * @param index the index of the field (must be smaller than TupleDesc::size)
+         */
+        size_t offset(size_t index) const { return offsets[index]; }
+
+        /**
+         * @brief Get the type of the field, without bounds checking
+         * @param index the index of the field (must be smaller than TupleDesc::size)
+         */
+        type_t type(size_t index) const { return types[index]; }
+
+        /**
+         * @brief Get the serialized size of the field, without bounds checking
+         * @param index the index of the field (must be smaller than TupleDesc::size)
+         */
+        size_t field_length(size_t index) const {
+            return (index + 1 < offsets.size() ? offsets[index + 1] : len) - offsets[index];
+        }
+
+        /**
+         * @brief Get offset of the field in a variable-length record, without bounds checking
+         * @details In a variable-length record, a CHAR field takes CHAR_REF_SIZE bytes that locate its characters after
+         * the fixed part of the record (see SlottedPage).
+         * @param index the index of the field (must be smaller than TupleDesc::size)
+         */
+        size_t var_offset(size_t index) const { return var_offsets[index]; }
+
+        /**
+         * @brief Get the length of the fixed part of a variable-length record
+         */
+        size_t var_length() const { return var_len; }
+
         /**
          * @brief Get the index of the field
          * @details The index of the field is the position of the field in the Tuple
@@ -76,7 +127,13 @@ namespace db {
          * @brief Get the length of the TupleDesc
          * @return the number of bytes needed to serialize a Tuple with this TupleDesc
          */
-        size_t length() const;
+        size_t length() const { return len; }
+
+        /**
+         * @brief Whether every INT and DOUBLE field is at an offset that is a multiple of its size
+         * @details Fields of a tuple serialized at an aligned address can then be loaded directly.
+         */
+        bool aligned() const { return is_aligned; }
 
         /**
          * @brief Serialize a Tuple
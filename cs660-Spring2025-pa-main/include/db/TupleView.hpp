@@ -0,0 +1,96 @@
+#pragma once
+
+#include <db/BufferPool.hpp>
+#include <db/Tuple.hpp>
+#include <optional>
+#include <string_view>
+
+namespace db {
+
+/**
+ * @brief A read-only view of a serialized tuple inside a page.
+ * @details The fields are decoded on demand from the page bytes, without building a Tuple: only the bytes of the fields
+ * that are read are touched, which with a PaxPage means only the minipages of those fields. The view keeps the page
+ * pinned (and latched in shared mode) for its lifetime, so it should not outlive the scan step that produced it.
+ * Use TupleView::materialize to obtain an owning Tuple, e.g. to insert it into another file.
+ */
+    class TupleView {
+        std::optional<PageView> page;
+        const TupleDesc *td;
+        const uint8_t *data = nullptr;
+        /// Whether `data` is a variable-length record (see SlottedPage).
+        bool var = false;
+        /// The capacity of the page if `data` is the data area of a PaxPage, and the slot of the tuple.
+        size_t rows = 0;
+        size_t slot = 0;
+        /// The tuple, when it could not be viewed in place.
+        std::optional<Tuple> owned;
+
+        const uint8_t *field(size_t i) const {
+            if (rows != 0) {
+                return data + rows * td->offset(i) + slot * td->field_length(i);
+            }
+            return data + (var ? td->var_offset(i) : td->offset(i));
+        }
+
+    public:
+        /**
+         * @brief View a tuple.
+         * @param page The page holding the tuple.
+         * @param td The tuple descriptor of the tuple.
+         * @param data The first byte of the serialized tuple, inside the page.
+         * @param var Whether the tuple is a variable-length record of a SlottedPage.
+         */
+        TupleView(PageView page, const TupleDesc &td, const uint8_t *data, bool var = false);
+
+        /**
+         * @brief View a tuple of a PaxPage, whose fields are stored in one minipage per field.
+         * @param page The page holding the tuple.
+         * @param td The tuple descriptor of the tuple.
+         * @param columns The first byte of the minipages (see PaxPage::column).
+         * @param rows The number of slots of the page.
+         * @param slot The slot of the tuple.
+         */
+        TupleView(PageView page, const TupleDesc &td, const uint8_t *columns, size_t rows, size_t slot);
+
+        /**
+         * @brief View a tuple that is not stored contiguously in a page (e.g. it has strings in overflow pages).
+         * @param t The tuple, owned by the view.
+         * @param td The tuple descriptor of the tuple.
+         */
+        TupleView(Tuple t, const TupleDesc &td);
+
+        size_t size() const;
+
+        type_t field_type(size_t i) const;
+
+        /**
+         * @brief Read an INT field.
+         * @throws std::logic_error if the field is not an INT.
+         */
+        int get_int(size_t i) const;
+
+        /**
+         * @brief Read a DOUBLE field.
+         * @throws std::logic_error if the field is not a DOUBLE.
+         */
+        double get_double(size_t i) const;
+
+        /**
+         * @brief Read a CHAR field without copying it.
+         * @return The characters up to the first NUL (at most CHAR_SIZE), pointing into the page.
+         * @throws std::logic_error if the field is not a CHAR.
+         */
+        std::string_view get_string_view(size_t i) const;
+
+        /**
+         * @brief Read a field of any type. A CHAR field is copied into a std::string.
+         */
+        field_t get_field(size_t i) const;
+
+        /**
+         * @brief Copy all the fields into an owning Tuple.
+         */
+        Tuple materialize() const;
+    };
+} // namespace db
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <array>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <variant>
 #include <cstdint>
@@ -10,6 +12,8 @@ namespace db {
     constexpr size_t INT_SIZE = sizeof(int);
     constexpr size_t DOUBLE_SIZE = sizeof(double);
     constexpr size_t CHAR_SIZE = 64;
+    /// Size of a CHAR field in a variable-length record: a 16-bit offset and a 16-bit length (see SlottedPage).
+    constexpr size_t CHAR_REF_SIZE = 2 * sizeof(uint16_t);
 
     enum class type_t {
         INT, CHAR, DOUBLE
@@ -17,14 +21,38 @@ namespace db {
 
     using field_t = std::variant<int, double, std::string>;
 
+/**
+ * @brief Identifies a page: the id of its file (see Database::getId) and its page number within the file.
+ * @details A PageId is a trivially copyable 64-bit value, so it is cheap to copy, compare and hash.
+ */
     struct PageId {
-        std::string file;
-        size_t page;
+        uint32_t file = 0;
+        uint32_t page = 0;
 
     public:
+        PageId() = default;
+
+        /**
+         * @throws std::out_of_range if the file id or the page number does not fit in 32 bits.
+         */
+        constexpr PageId(size_t file, size_t page)
+                : file(static_cast<uint32_t>(file)), page(static_cast<uint32_t>(page)) {
+            if (file > UINT32_MAX || page > UINT32_MAX) {
+                throw std::out_of_range("Page id out of range");
+            }
+        }
+
+        /**
+         * @brief Identify a page of a file by name.
+         * @details The name is interned with Database::getId. Prefer the file id on hot paths.
+         */
+        PageId(const std::string &file, size_t page);
+
         bool operator==(const PageId &) const = default;
     };
 
+    static_assert(sizeof(PageId) == sizeof(uint64_t) && std::is_trivially_copyable_v<PageId>);
+
     constexpr size_t DEFAULT_PAGE_SIZE = 4096;
 
     using Page = std::array<uint8_t, DEFAULT_PAGE_SIZE>;
@@ -33,6 +61,13 @@ namespace db {
 template<>
 struct std::hash<const db::PageId> {
     std::size_t operator()(const db::PageId &r) const {
-        return std::hash<std::string>()(r.file) ^ std::hash<size_t>()(r.page);
+        // The finalizer of MurmurHash3: every bit of the file id and the page number affects every bit of the hash
+        uint64_t h = static_cast<uint64_t>(r.file) << 32 | r.page;
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
     }
 };
@@ -1,35 +1,52 @@
+#include <cstdio>
 #include <cstring>
 #include <db/BTreeFile.hpp>
 #include <db/Database.hpp>
+#include <db/HeapFile.hpp>
 #include <db/IndexPage.hpp>
 #include <db/LeafPage.hpp>
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <queue>
 #include <stdexcept>
+#include <tuple>
 
 using namespace db;
 
-BTreeFile::BTreeFile(const std::string &name, const TupleDesc &td, size_t key_index)
-        : DbFile(name, td), key_index(key_index) {}
+BTreeFile::BTreeFile(const std::string &name, const TupleDesc &td, size_t key_index, const DbFileOptions &options)
+        : BTreeFile(name, td, std::vector<size_t>{key_index}, options) {}
+
+BTreeFile::BTreeFile(const std::string &name, const TupleDesc &td, std::vector<size_t> key_fields,
+                     const DbFileOptions &options)
+        : DbFile(name, td, options), key_desc(td, std::move(key_fields)) {}
+
+const KeyDesc &BTreeFile::getKeyDesc() const { return key_desc; }
 
 void BTreeFile::insertTuple(const Tuple &t) {
     // TODO pa2
+    if (isMapped()) {
+        throw std::logic_error("Cannot insert into a memory-mapped file");
+    }
+    const size_t key_size = key_desc.length();
+    uint8_t key[MAX_KEY_SIZE];
+    key_desc.encode(key, t);
     std::vector<size_t> path;
     BufferPool &bufferPool = getDatabase().getBufferPool();
-    PageId pid{name, root_id};
+    PageId pid{file_id, root_id};
 
-    Page &root_page = bufferPool.getPage(pid);
-    IndexPage root(root_page);
+    PageGuard root_page(bufferPool, pid);
+    IndexPage root(*root_page, key_size);
     if (root.header->size == 0 && root.children[0] != 1) {
-        bufferPool.markDirty({name, root_id});
+        root_page.markDirty();
         pid.page = numPages++;
         root.children[0] = pid.page;
     } else {
         while (true) {
-            Page &page = bufferPool.getPage(pid);
-            IndexPage node(page);
-            auto pos = std::lower_bound(node.keys, node.keys + node.header->size,
-                                        std::get<int>(t.get_field(key_index)));
-            auto slot = pos - node.keys;
-            pid.page = node.children[slot];
+            PageGuard page(bufferPool, pid);
+            IndexPage node(*page, key_size);
+            pid.page = node.children[node.search(key)];
             if (!node.header->index_children) {
                 break;
             }
@@ -37,18 +54,20 @@ void BTreeFile::insertTuple(const Tuple &t) {
         }
     }
 
-    Page &page = bufferPool.getPage(pid);
-    bufferPool.markDirty(pid);
-    LeafPage leaf(page, td, key_index);
+    PageGuard page(bufferPool, pid);
+    page.markDirty();
+    LeafPage leaf(*page, td, key_desc);
     if (!leaf.insertTuple(t)) {
         return;
     }
 
-    pid.page = numPages++;
-    Page &new_leaf_page = bufferPool.getPage(pid);
-    bufferPool.markDirty(pid);
-    LeafPage new_leaf(new_leaf_page, td, key_index);
-    int new_key = leaf.split(new_leaf);
+    pid.page = allocatePage();
+    PageGuard new_leaf_page(bufferPool, pid);
+    new_leaf_page.markDirty();
+    LeafPage new_leaf(*new_leaf_page, td, key_desc);
+    leaf.split(new_leaf);
+    uint8_t new_key[MAX_KEY_SIZE];
+    new_leaf.key(0, new_key);
     leaf.header->next_leaf = pid.page;
     size_t new_child = pid.page;
 
@@ -56,65 +75,570 @@ void BTreeFile::insertTuple(const Tuple &t) {
         size_t parent_id = path.back();
         path.pop_back();
         pid.page = parent_id;
-        Page &parent_page = bufferPool.getPage(pid);
-        bufferPool.markDirty(pid);
-        IndexPage parent(parent_page);
+        PageGuard parent_page(bufferPool, pid);
+        parent_page.markDirty();
+        IndexPage parent(*parent_page, key_size);
         if (!parent.insert(new_key, new_child)) {
             return;
         }
 
-        pid.page = numPages++;
-        Page &new_internal_page = bufferPool.getPage(pid);
-        bufferPool.markDirty(pid);
-        IndexPage new_internal(new_internal_page);
-        new_key = parent.split(new_internal);
+        pid.page = allocatePage();
+        PageGuard new_internal_page(bufferPool, pid);
+        new_internal_page.markDirty();
+        IndexPage new_internal(*new_internal_page, key_size);
+        parent.split(new_internal, new_key);
         new_child = pid.page;
     }
 
-    bufferPool.markDirty({name, root_id});
+    root_page.markDirty();
     if (!root.insert(new_key, new_child)) {
         return;
     }
-    pid.page = numPages++;
-    Page &new_child1 = bufferPool.getPage(pid);
-    bufferPool.markDirty(pid);
+    pid.page = allocatePage();
+    PageGuard new_child1(bufferPool, pid);
+    new_child1.markDirty();
     size_t child1 = pid.page;
-    new_child1 = root_page;
-    IndexPage child1_page(new_child1);
+    *new_child1 = *root_page;
+    IndexPage child1_page(*new_child1, key_size);
 
-    pid.page = numPages++;
-    Page &new_child2 = bufferPool.getPage(pid);
-    bufferPool.markDirty(pid);
+    pid.page = allocatePage();
+    PageGuard new_child2(bufferPool, pid);
+    new_child2.markDirty();
     size_t child2 = pid.page;
-    IndexPage child2_page(new_child2);
+    IndexPage child2_page(*new_child2, key_size);
 
-    int key = child1_page.split(child2_page);
+    child1_page.split(child2_page, root.key_data);
     root.header->size = 1;
     root.header->index_children = true;
-    root.keys[0] = key;
     root.children[0] = child1;
     root.children[1] = child2;
 }
 
+/**
+ * A sorted run of serialized tuples spilled to a temporary file by BTreeFile::bulkLoad, read back in chunks.
+ */
+struct SortedRun {
+    static constexpr size_t CHUNK_BYTES = 1 << 20;
+
+    std::unique_ptr<FILE, int (*)(FILE *)> file{std::tmpfile(), &std::fclose};
+    size_t remaining = 0;
+    std::vector<uint8_t> chunk;
+    size_t pos = 0;
+
+    SortedRun() {
+        if (!file) {
+            throw std::runtime_error("Cannot create a temporary file");
+        }
+    }
+
+    void write(const uint8_t *data, size_t length) {
+        if (std::fwrite(data, 1, length, file.get()) != length) {
+            throw std::runtime_error("Cannot write a temporary file");
+        }
+    }
+
+    /**
+     * Returns the next tuple, or nullptr after the last one.
+     */
+    const uint8_t *next(size_t length) {
+        if (pos == chunk.size()) {
+            size_t count = std::min(remaining, std::max<size_t>(CHUNK_BYTES / length, 1));
+            if (count == 0) {
+                return nullptr;
+            }
+            chunk.resize(count * length);
+            if (std::fread(chunk.data(), length, count, file.get()) != count) {
+                throw std::runtime_error("Cannot read a temporary file");
+            }
+            remaining -= count;
+            pos = 0;
+        }
+        pos += length;
+        return chunk.data() + pos - length;
+    }
+};
+
+void BTreeFile::bulkLoad(const DbFile &in, double fill) {
+    const TupleDesc &in_td = in.getTupleDesc();
+    if (in_td.size() != td.size()) {
+        throw std::invalid_argument("Fields do not match");
+    }
+    for (size_t i = 0; i < td.size(); i++) {
+        if (in_td.field_type(i) != td.field_type(i)) {
+            throw std::invalid_argument("Fields do not match");
+        }
+    }
+    std::vector<uint8_t> tuple(td.length());
+    auto scan = [&](const std::function<void(const uint8_t *)> &f) {
+        in.scan([&](const TupleView &t) {
+            td.serialize(tuple.data(), t.materialize());
+            f(tuple.data());
+        });
+    };
+    load(scan, fill);
+}
+
+void BTreeFile::bulkLoad(const uint8_t *data, size_t count, double fill) {
+    const size_t width = td.length();
+    load([&](const std::function<void(const uint8_t *)> &f) {
+        for (size_t i = 0; i < count; i++) {
+            f(data + i * width);
+        }
+    }, fill);
+}
+
+void BTreeFile::load(const std::function<void(const std::function<void(const uint8_t *)> &)> &scan, double fill) {
+    if (isMapped()) {
+        throw std::logic_error("Cannot insert into a memory-mapped file");
+    }
+    if (numPages > 1) {
+        throw std::logic_error("Cannot bulk load a file that is not empty");
+    }
+    if (!(fill > 0 && fill <= 1)) {
+        throw std::invalid_argument("Fill factor out of range");
+    }
+
+    BufferPool &bufferPool = getDatabase().getBufferPool();
+    const size_t width = td.length();
+    const size_t key_size = key_desc.length();
+
+    // A full page must be split, so a page holds at most capacity - 1 entries
+    Page scratch{};
+    const size_t leaf_tuples = std::max<size_t>(1, (LeafPage(scratch, td, key_desc).capacity - 1) * fill);
+    const size_t index_children = std::max<size_t>(2, (IndexPage(scratch, key_size).capacity - 1) * fill + 1);
+
+    // pages[i] is page first + i. Pages are written once they are complete, except the root.
+    std::vector<Page> pages(BATCH_PAGES);
+    size_t first = root_id + 1;
+    size_t filled = 0;
+    auto flush = [&] {
+        std::vector<std::pair<size_t, const Page *>> batch;
+        for (size_t i = 0; i < filled; i++) {
+            // Pages past the end of the file may have been read as zeros into the buffer pool
+            if (bufferPool.contains({file_id, first + i})) {
+                bufferPool.discardPage({file_id, first + i});
+            }
+            batch.emplace_back(first + i, &pages[i]);
+        }
+        writePages(batch);
+        first += filled;
+        filled = 0;
+    };
+    auto allocate = [&]() -> Page & {
+        if (filled == BATCH_PAGES) {
+            flush();
+        }
+        pages[filled].fill(0);
+        return pages[filled++];
+    };
+
+    // The first key and the page of every node of the level being built
+    std::vector<uint8_t> level_keys;
+    std::vector<size_t> level_pages;
+    LeafPage *leaf = nullptr;
+    std::optional<LeafPage> open;
+    uint8_t last_key[MAX_KEY_SIZE];
+    auto append = [&](const uint8_t *tuple, const uint8_t *key) {
+        if (leaf != nullptr && std::memcmp(key, last_key, key_size) == 0) {
+            // A tuple replaces the previous one with the same key
+            std::memcpy(leaf->data + (leaf->header->size - 1) * width, tuple, width);
+            return;
+        }
+        if (leaf == nullptr || leaf->header->size == leaf_tuples) {
+            if (leaf != nullptr) {
+                leaf->header->next_leaf = first + filled;
+            }
+            level_keys.insert(level_keys.end(), key, key + key_size);
+            level_pages.push_back(first + filled);
+            leaf = &open.emplace(allocate(), td, key_desc);
+        }
+        std::memcpy(leaf->data + leaf->header->size++ * width, tuple, width);
+        std::memcpy(last_key, key, key_size);
+    };
+
+    // Runs are sorted by key and then by position, so that the last tuple with a key is appended last
+    std::vector<uint8_t> run;
+    std::vector<uint8_t> run_keys;
+    std::vector<size_t> order;
+    std::vector<SortedRun> runs;
+    auto sortRun = [&] {
+        order.resize(run.size() / width);
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            int c = std::memcmp(run_keys.data() + a * key_size, run_keys.data() + b * key_size, key_size);
+            return c < 0 || (c == 0 && a < b);
+        });
+    };
+    auto spill = [&] {
+        sortRun();
+        SortedRun &r = runs.emplace_back();
+        for (size_t i: order) {
+            r.write(run.data() + i * width, width);
+        }
+        r.remaining = order.size();
+        std::rewind(r.file.get());
+        run.clear();
+        run_keys.clear();
+    };
+    auto add = [&](const uint8_t *tuple) {
+        run.insert(run.end(), tuple, tuple + width);
+        run_keys.resize(run_keys.size() + key_size);
+        key_desc.encode(run_keys.data() + run_keys.size() - key_size, run.data() + run.size() - width);
+        if (run.size() >= BULK_RUN_BYTES) {
+            spill();
+        }
+    };
+    // The tuples appended so far are added back to the runs, from the leaves written and those not yet written
+    auto unload = [&] {
+        Page page;
+        for (size_t id = root_id + 1; id < first + filled; id++) {
+            if (id < first) {
+                readPage(page, id);
+            }
+            const LeafPage l(id < first ? page : pages[id - first], td, key_desc);
+            for (size_t i = 0; i < l.header->size; i++) {
+                add(l.data + i * width);
+            }
+        }
+        first = root_id + 1;
+        filled = 0;
+        level_keys.clear();
+        level_pages.clear();
+        leaf = nullptr;
+        open.reset();
+    };
+
+    // Tuples are appended while they are sorted by key (e.g. from another BTreeFile), so that sorted input is
+    // streamed. At the first smaller key, they are sorted with the rest of the input, in the same pass.
+    bool sorting = false;
+    uint8_t key[MAX_KEY_SIZE];
+    scan([&](const uint8_t *tuple) {
+        if (!sorting) {
+            key_desc.encode(key, tuple);
+            if (leaf == nullptr || std::memcmp(key, last_key, key_size) >= 0) {
+                append(tuple, key);
+                return;
+            }
+            unload();
+            sorting = true;
+        }
+        add(tuple);
+    });
+    if (sorting && runs.empty()) {
+        sortRun();
+        for (size_t i: order) {
+            append(run.data() + i * width, run_keys.data() + i * key_size);
+        }
+    } else if (sorting) {
+        if (!run.empty()) {
+            spill();
+        }
+        // Merge the runs, taking equal keys from the earlier runs first
+        std::vector<const uint8_t *> head_tuples(runs.size());
+        std::vector<uint8_t> head_keys(runs.size() * key_size);
+        auto greater = [&](size_t a, size_t b) {
+            int c = std::memcmp(head_keys.data() + a * key_size, head_keys.data() + b * key_size, key_size);
+            return c > 0 || (c == 0 && a > b);
+        };
+        std::priority_queue<size_t, std::vector<size_t>, decltype(greater)> heads(greater);
+        auto advance = [&](size_t i) {
+            if ((head_tuples[i] = runs[i].next(width))) {
+                key_desc.encode(head_keys.data() + i * key_size, head_tuples[i]);
+                heads.push(i);
+            }
+        };
+        for (size_t i = 0; i < runs.size(); i++) {
+            advance(i);
+        }
+        while (!heads.empty()) {
+            size_t i = heads.top();
+            heads.pop();
+            append(head_tuples[i], head_keys.data() + i * key_size);
+            advance(i);
+        }
+    }
+    if (leaf == nullptr) {
+        return;
+    }
+
+    // Build the index pages level by level, until the children fit in the root
+    bool index_level = false;
+    auto fillNode = [&](IndexPage &node, size_t begin, size_t end) {
+        node.header->size = end - begin - 1;
+        node.header->index_children = index_level;
+        std::memcpy(node.key_data, level_keys.data() + (begin + 1) * key_size, (end - begin - 1) * key_size);
+        std::copy(level_pages.begin() + begin, level_pages.begin() + end, node.children);
+    };
+    while (level_pages.size() > index_children) {
+        std::vector<uint8_t> parent_keys;
+        std::vector<size_t> parent_pages;
+        size_t count = level_pages.size();
+        size_t nodes = (count + index_children - 1) / index_children;
+        for (size_t n = 0, begin = 0; n < nodes; n++) {
+            // Spread the children evenly, so that the last node is not almost empty
+            size_t end = count * (n + 1) / nodes;
+            parent_keys.insert(parent_keys.end(), level_keys.data() + begin * key_size,
+                               level_keys.data() + (begin + 1) * key_size);
+            parent_pages.push_back(first + filled);
+            IndexPage node(allocate(), key_size);
+            fillNode(node, begin, end);
+            begin = end;
+        }
+        level_keys = std::move(parent_keys);
+        level_pages = std::move(parent_pages);
+        index_level = true;
+    }
+    flush();
+
+    Page root_page{};
+    IndexPage root(root_page, key_size);
+    fillNode(root, 0, level_pages.size());
+    if (bufferPool.contains({file_id, root_id})) {
+        bufferPool.discardPage({file_id, root_id});
+    }
+    writePage(root_page, root_id);
+    numPages = first;
+}
+
+size_t BTreeFile::allocatePage() {
+    if (free_pages.empty()) {
+        return numPages++;
+    }
+    size_t id = free_pages.back();
+    free_pages.pop_back();
+    return id;
+}
+
 void BTreeFile::deleteTuple(const Iterator &it) {
-    // Do not implement
+    if (isMapped()) {
+        throw std::logic_error("Cannot delete from a memory-mapped file");
+    }
+    if (it.page == root_id) {
+        throw std::out_of_range("Cannot delete the end of the file");
+    }
+    BufferPool &bufferPool = getDatabase().getBufferPool();
+    PageId pid{file_id, it.page};
+    const size_t key_size = key_desc.length();
+    Page scratch{};
+    const size_t max_tuples = LeafPage(scratch, td, key_desc).capacity - 1;
+    const size_t max_keys = IndexPage(scratch, key_size).capacity - 1;
+
+    // The iterator is checked before the tree is changed: a stale iterator may point to an index page, a freed page
+    // or past the tuples of a leaf
+    if (it.page >= numPages || std::find(free_pages.begin(), free_pages.end(), it.page) != free_pages.end()) {
+        throw std::logic_error("Iterator does not point to a tuple of the file");
+    }
+    uint8_t key[MAX_KEY_SIZE];
+    {
+        PageGuard page(bufferPool, pid);
+        const LeafPage leaf(*page, td, key_desc);
+        if (it.slot >= leaf.header->size) {
+            throw std::out_of_range("Slot out of range");
+        }
+        leaf.key(it.slot, key);
+    }
+
+    // The index pages from the root to the leaf, and the position of the child to follow in each
+    std::vector<std::pair<size_t, size_t>> path;
+    pid.page = root_id;
+    while (true) {
+        PageGuard page(bufferPool, pid);
+        const IndexPage node(*page, key_size);
+        size_t pos = node.search(key);
+        path.emplace_back(pid.page, pos);
+        pid.page = node.children[pos];
+        if (!node.header->index_children) {
+            break;
+        }
+    }
+    if (pid.page != it.page) {
+        throw std::logic_error("Iterator does not point to a tuple of the file");
+    }
+
+    bool underflow;
+    {
+        PageGuard page(bufferPool, pid);
+        LeafPage leaf(*page, td, key_desc);
+        page.markDirty();
+        leaf.erase(it.slot);
+        underflow = leaf.header->size < max_tuples / 2;
+    }
+    if (!underflow) {
+        return;
+    }
+
+    // Merge the underflowing page with a sibling, or take entries from the sibling if they do not fit in one page. A
+    // merge removes a key from the parent, which may underflow in turn.
+    for (size_t level = path.size(); underflow && level-- > 0;) {
+        auto [parent_id, pos] = path[level];
+        PageGuard parent_page(bufferPool, {file_id, parent_id});
+        IndexPage parent(*parent_page, key_size);
+        if (parent.header->size == 0) {
+            // The only leaf of the tree
+            break;
+        }
+        size_t left = pos == 0 ? 0 : pos - 1;
+        PageGuard left_page(bufferPool, {file_id, parent.children[left]});
+        PageGuard right_page(bufferPool, {file_id, parent.children[left + 1]});
+        parent_page.markDirty();
+        left_page.markDirty();
+        right_page.markDirty();
+        bool merged;
+        if (level + 1 == path.size()) {
+            LeafPage l(*left_page, td, key_desc);
+            LeafPage r(*right_page, td, key_desc);
+            merged = l.header->size + r.header->size <= max_tuples;
+            if (merged) {
+                l.merge(r);
+            } else {
+                l.redistribute(r);
+                r.key(0, parent.key_data + left * key_size);
+            }
+        } else {
+            IndexPage l(*left_page, key_size);
+            IndexPage r(*right_page, key_size);
+            merged = static_cast<size_t>(l.header->size + r.header->size + 1) <= max_keys;
+            if (merged) {
+                l.merge(r, parent.key(left));
+            } else {
+                l.redistribute(r, parent.key(left), parent.key_data + left * key_size);
+            }
+        }
+        if (merged) {
+            free_pages.push_back(parent.children[left + 1]);
+            parent.erase(left);
+        }
+        underflow = merged && level != 0 && parent.header->size < max_keys / 2;
+    }
+
+    // The root stays on page 0: when it is left with a single index child, the child is moved into it
+    PageGuard root_page(bufferPool, {file_id, root_id});
+    IndexPage root(*root_page, key_size);
+    if (root.header->size == 0 && root.header->index_children) {
+        size_t child = root.children[0];
+        {
+            PageGuard child_page(bufferPool, {file_id, child});
+            root_page.markDirty();
+            *root_page = *child_page;
+        }
+        free_pages.push_back(child);
+    }
+}
+
+Iterator BTreeFile::seek(const uint8_t *key, bool upper) const {
+    size_t id = root_id;
+    while (true) {
+        PageView page = viewPage(id);
+        const IndexPage node(*page, key_desc.length());
+        id = node.children[node.search(key)];
+        if (!node.header->index_children) {
+            break;
+        }
+    }
+    if (id == root_id) {
+        // The tree is empty
+        return end();
+    }
+    PageView page = viewPage(id);
+    const LeafPage leaf(*page, td, key_desc);
+    size_t slot = upper ? leaf.upperBound(key) : leaf.lowerBound(key);
+    if (slot < leaf.header->size) {
+        return {*this, id, slot};
+    }
+    // The tuple is the first one of the next leaf, as next() would reach it
+    return {*this, leaf.header->next_leaf, 0};
+}
+
+Iterator BTreeFile::find(const std::vector<field_t> &key) const {
+    if (key.size() != key_desc.fields().size()) {
+        throw std::invalid_argument("A value is needed for every key field");
+    }
+    uint8_t encoded[MAX_KEY_SIZE];
+    uint8_t found[MAX_KEY_SIZE];
+    key_desc.encode(encoded, key);
+    Iterator it = seek(encoded, false);
+    if (it == end()) {
+        return it;
+    }
+    PageView page = viewPage(it.page);
+    LeafPage(*page, td, key_desc).key(it.slot, found);
+    if (std::memcmp(encoded, found, key_desc.length()) != 0) {
+        return end();
+    }
+    return it;
+}
+
+Iterator BTreeFile::lowerBound(const std::vector<field_t> &key) const {
+    uint8_t encoded[MAX_KEY_SIZE];
+    key_desc.encode(encoded, key, 0x00);
+    return seek(encoded, false);
+}
+
+Iterator BTreeFile::upperBound(const std::vector<field_t> &key) const {
+    uint8_t encoded[MAX_KEY_SIZE];
+    key_desc.encode(encoded, key, 0xff);
+    return seek(encoded, true);
+}
+
+BTreeFile::Range BTreeFile::range(const std::vector<field_t> &lo, const std::vector<field_t> &hi) const {
+    uint8_t lo_key[MAX_KEY_SIZE];
+    uint8_t hi_key[MAX_KEY_SIZE];
+    key_desc.encode(lo_key, lo, 0x00);
+    key_desc.encode(hi_key, hi, 0xff);
+    if (std::memcmp(lo_key, hi_key, key_desc.length()) > 0) {
+        return {end(), end()};
+    }
+    return {seek(lo_key, false), seek(hi_key, true)};
+}
+
+void BTreeFile::scanRange(const Range &range, const std::function<bool(const TupleView &)> &f) const {
+    size_t page = range.first.page;
+    size_t slot = range.first.slot;
+    while (page != root_id) {
+        PageView p = viewPage(page);
+        const LeafPage leaf(*p, td, key_desc);
+        size_t end = page == range.last.page ? range.last.slot : leaf.header->size;
+        for (; slot < end; slot++) {
+            // The views borrow the leaf, which stays pinned and latched until the next one
+            if (!f(TupleView(PageView(*p), td, leaf.tupleData(slot)))) {
+                return;
+            }
+        }
+        if (page == range.last.page) {
+            return;
+        }
+        page = leaf.header->next_leaf;
+        slot = 0;
+    }
+}
+
+Iterator BTreeFile::find(int key) const { return find(std::vector<field_t>{key}); }
+
+Iterator BTreeFile::lowerBound(int key) const { return lowerBound(std::vector<field_t>{key}); }
+
+Iterator BTreeFile::upperBound(int key) const { return upperBound(std::vector<field_t>{key}); }
+
+BTreeFile::Range BTreeFile::range(int lo, int hi) const {
+    return range(std::vector<field_t>{lo}, std::vector<field_t>{hi});
 }
 
 Tuple BTreeFile::getTuple(const Iterator &it) const {
     // TODO pa2
-    BufferPool &bufferPool = getDatabase().getBufferPool();
-    PageId pid{name, it.page};
-    Page &page = bufferPool.getPage(pid);
-    LeafPage leaf(page, td, key_index);
+    PageView page = viewPage(it.page);
+    const LeafPage leaf(*page, td, key_desc);
     return leaf.getTuple(it.slot);
 }
 
+TupleView BTreeFile::view(const Iterator &it) const {
+    PageView page = viewPage(it.page);
+    const uint8_t *data = LeafPage(*page, td, key_desc).tupleData(it.slot);
+    return {std::move(page), td, data};
+}
+
 void BTreeFile::next(Iterator &it) const {
     // TODO pa2
-    BufferPool &bufferPool = getDatabase().getBufferPool();
-    PageId pid{name, it.page};
-    Page &page = bufferPool.getPage(pid);
-    LeafPage leaf(page, td, key_index);
+    PageView page = viewPage(it.page);
+    const LeafPage leaf(*page, td, key_desc);
     if (it.slot + 1 < leaf.header->size) {
         it.slot++;
     } else {
@@ -125,17 +649,20 @@ void BTreeFile::next(Iterator &it) const {
 
 Iterator BTreeFile::begin() const {
     // TODO pa2
-    BufferPool &bufferPool = getDatabase().getBufferPool();
-    PageId pid{name, root_id};
+    size_t id = root_id;
     while (true) {
-        Page &page = bufferPool.getPage(pid);
-        IndexPage node(page);
-        pid.page = node.children[0];
+        PageView page = viewPage(id);
+        const IndexPage node(*page, key_desc.length());
+        id = node.children[0];
         if (!node.header->index_children) {
             break;
         }
     }
-    return {*this, pid.page, 0};
+    if (id != root_id && LeafPage(*viewPage(id), td, key_desc).header->size == 0) {
+        // The only leaf is empty after deletes
+        return end();
+    }
+    return {*this, id, 0};
 }
 
 Iterator BTreeFile::end() const {
@@ -1,106 +1,644 @@
 #include <db/BufferPool.hpp>
 #include <db/Database.hpp>
+#include <algorithm>
+#include <cstring>
+#include <map>
 #include <numeric>
+#include <stdexcept>
+#include <sys/mman.h>
 
 using namespace db;
 
-BufferPool::BufferPool() : available(DEFAULT_NUM_PAGES) {
+namespace {
+    constexpr size_t HUGE_PAGE_SIZE = 2 << 20;
+
+    size_t mappingSize(size_t numPages, bool hugePages) {
+        size_t size = numPages * DEFAULT_PAGE_SIZE;
+        if (hugePages) {
+            size = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+        }
+        return size;
+    }
+
+    Page *allocateFrames(size_t numPages, bool hugePages) {
+        size_t size = mappingSize(numPages, hugePages);
+        void *addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (addr == MAP_FAILED) {
+            throw std::runtime_error("mmap");
+        }
+#ifdef MADV_HUGEPAGE
+        if (hugePages) {
+            // Only a hint: fall back to regular pages if THP is unavailable
+            madvise(addr, size, MADV_HUGEPAGE);
+        }
+#endif
+        return static_cast<Page *>(addr);
+    }
+
+    void freeFrames(Page *pages, size_t numPages, bool hugePages) {
+        munmap(pages, mappingSize(numPages, hugePages));
+    }
+} // namespace
+
+BufferPool::BufferPool(size_t numPages, bool hugePages, ReplacementPolicyType policy)
+        : numPages(numPages), hugePages(hugePages), frames(std::make_unique<Frame[]>(numPages)),
+          available(numPages), policy(makeReplacementPolicy(policy, numPages)) {
     // TODO pa0
+    if (numPages == 0) {
+        throw std::invalid_argument("Buffer pool must have at least one page");
+    }
+    pages = allocateFrames(numPages, hugePages);
     std::iota(available.rbegin(), available.rend(), 0);
 }
 
 BufferPool::~BufferPool() {
     // TODO pa0
-    for (const size_t &pos: dirty) {
-        const Page &page = pages[pos];
-        const PageId &pid = pos_to_pid[pos];
-        getDatabase().get(pid.file).writePage(page, pid.page);
+    stopFlusher();
+    for (size_t pos = 0; pos < numPages; pos++) {
+        if (frames[pos].dirty) {
+            const PageId &pid = frames[pos].pid;
+            getDatabase().get(pid.file).writePage(pages[pos], pid.page);
+        }
     }
+    freeFrames(pages, numPages, hugePages);
 }
 
-Page &BufferPool::getPage(const PageId &pid) {
-    // TODO pa0
-    // If already in buffer pool, make it the most recent page and return it
-    if (contains(pid)) {
-        size_t pos = pid_to_pos.at(pid);
-        lru_list.splice(lru_list.begin(), lru_list, pos_to_lru[pos]);
-        pos_to_lru[pos] = lru_list.begin();
-        return pages[pos];
-    }
+BufferPool::Partition &BufferPool::partition(const PageId &pid) {
+    return partitions[std::hash<const PageId>()(pid) % NUM_PARTITIONS];
+}
+
+const BufferPool::Partition &BufferPool::partition(const PageId &pid) const {
+    return partitions[std::hash<const PageId>()(pid) % NUM_PARTITIONS];
+}
+
+size_t BufferPool::position(const Page &page) const {
+    return &page - pages;
+}
+
+size_t BufferPool::capacity() const { return numPages; }
 
-    // If there are no available pages, evict the least recently used page. If the page is dirty, flush it to disk
-    if (available.empty()) {
-        size_t pos = lru_list.back();
-        const PageId &old_pid = pos_to_pid.at(pos);
-        if (isDirty(old_pid)) {
-            flushPage(old_pid);
+void BufferPool::resize(size_t newNumPages) {
+    if (newNumPages == 0) {
+        throw std::invalid_argument("Buffer pool must have at least one page");
+    }
+    for (size_t pos = 0; pos < numPages; pos++) {
+        if (frames[pos].pins != 0) {
+            throw std::logic_error("Cannot resize the buffer pool while a page is pinned");
         }
+    }
+    bool flushing = flusher.joinable();
+    stopFlusher();
+    {
+        // The buffered accesses refer to the positions of the frames before they move
+        std::lock_guard lock(latch);
+        drainAccesses();
+    }
+
+    // Evict the pages that will not fit in the new pool
+    while (numPages - available.size() > newNumPages) {
+        const PageId old_pid = frames[policy->victim([](size_t) { return true; })].pid;
+        flushPage(old_pid);
         discardPage(old_pid);
     }
+    Page *newPages = allocateFrames(newNumPages, hugePages);
+    auto newFrames = std::make_unique<Frame[]>(newNumPages);
+
+    // Frames below the new size keep their position, the others move to the free frames below the new size
+    std::vector<bool> used(numPages, true);
+    for (const size_t &pos: available) {
+        used[pos] = false;
+    }
+    std::vector<size_t> free;
+    for (size_t pos = newNumPages; pos-- > 0;) {
+        if (pos >= numPages || !used[pos]) {
+            free.push_back(pos);
+        }
+    }
+    std::vector<std::pair<size_t, size_t>> moved;
+    for (size_t pos = newNumPages; pos < numPages; pos++) {
+        if (used[pos]) {
+            policy->erase(pos);
+            moved.emplace_back(pos, free.back());
+            free.pop_back();
+        }
+    }
+    policy->resize(newNumPages);
+
+    for (size_t pos = 0; pos < std::min(numPages, newNumPages); pos++) {
+        if (used[pos]) {
+            std::memcpy(newPages[pos].data(), pages[pos].data(), DEFAULT_PAGE_SIZE);
+            newFrames[pos].pid = std::move(frames[pos].pid);
+            newFrames[pos].dirty = frames[pos].dirty.load();
+            newFrames[pos].dirty_since = frames[pos].dirty_since.load();
+        }
+    }
+    for (const auto &[from, to]: moved) {
+        std::memcpy(newPages[to].data(), pages[from].data(), DEFAULT_PAGE_SIZE);
+        newFrames[to].pid = std::move(frames[from].pid);
+        newFrames[to].dirty = frames[from].dirty.load();
+        newFrames[to].dirty_since = frames[from].dirty_since.load();
+        partition(newFrames[to].pid).pid_to_pos.insert(newFrames[to].pid, to);
+        policy->insert(to, newFrames[to].pid);
+    }
+
+    freeFrames(pages, numPages, hugePages);
+    pages = newPages;
+    frames = std::move(newFrames);
+    numPages = newNumPages;
+    available = std::move(free);
+    if (flushing) {
+        startFlusher();
+    }
+}
+
+void BufferPool::setReplacementPolicy(ReplacementPolicyType type) {
+    std::lock_guard lock(latch);
+    auto newPolicy = makeReplacementPolicy(type, numPages);
+    for (const Partition &part: partitions) {
+        std::lock_guard part_lock(part.latch);
+        part.pid_to_pos.forEach([&](const PageId &pid, size_t pos) {
+            if (frames[pos].pins != 0) {
+                throw std::logic_error("Cannot replace the policy while a page is pinned");
+            }
+            newPolicy->insert(pos, pid);
+        });
+    }
+    policy = std::move(newPolicy);
+}
+
+void BufferPool::drainAccesses() {
+    std::vector<Access> accesses;
+    for (Partition &part: partitions) {
+        std::lock_guard part_lock(part.latch);
+        for (const Access &access: part.accesses) {
+            // The page table and the policy track the same frames, and both change under `latch`
+            const size_t *found = part.pid_to_pos.find(access.pid);
+            if (found != nullptr && *found == access.pos) {
+                accesses.push_back(access);
+            }
+        }
+        part.accesses.clear();
+    }
+    std::stable_sort(accesses.begin(), accesses.end(), [](const Access &a, const Access &b) {
+        return a.time < b.time;
+    });
+    for (const Access &access: accesses) {
+        policy->access(access.pos);
+    }
+}
+
+size_t BufferPool::allocateFrame() {
+    while (true) {
+        std::unique_lock lock(latch);
+        if (!available.empty()) {
+            size_t pos = available.back();
+            available.pop_back();
+            return pos;
+        }
+
+        // Evict the page chosen by the replacement policy, skipping pinned pages
+        drainAccesses();
+        size_t pos = policy->victim([this](size_t pos) { return frames[pos].pins == 0; });
+        Frame &frame = frames[pos];
+        Partition &part = partition(frame.pid);
+        std::unique_lock part_lock(part.latch);
+        // Pins are only acquired while holding the partition latch, so this check is stable
+        if (frame.pins != 0) {
+            continue;
+        }
+        if (frame.dirty) {
+            // Flush without holding any latch, then try again: the page may have been used in the meantime
+            frame.pins++;
+            part_lock.unlock();
+            lock.unlock();
+            writeFrame(pos);
+            frame.pins--;
+            continue;
+        }
+        part.pid_to_pos.erase(frame.pid);
+        policy->evict(pos);
+        frame.pid = {};
+        return pos;
+    }
+}
+
+size_t BufferPool::fetch(const PageId &pid) {
+    Partition &part = partition(pid);
+    while (true) {
+        {
+            std::unique_lock part_lock(part.latch);
+            if (const size_t *found = part.pid_to_pos.find(pid)) {
+                size_t pos = *found;
+                frames[pos].pins++;
+                part.accesses.push_back({std::chrono::steady_clock::now(), pos, pid});
+                bool full = part.accesses.size() >= ACCESS_BATCH;
+                part_lock.unlock();
+                if (full) {
+                    std::lock_guard lock(latch);
+                    drainAccesses();
+                }
+                if (!waitLoaded(pos)) {
+                    continue;
+                }
+                return pos;
+            }
+        }
+
+        size_t pos = allocateFrame();
+        size_t installed = install(pid, pos);
+        if (installed != pos) {
+            if (!waitLoaded(installed)) {
+                continue;
+            }
+            return installed;
+        }
+        try {
+            getDatabase().get(pid.file).readPage(pages[pos], pid.page);
+        } catch (...) {
+            abandon(pos);
+            throw;
+        }
+        frames[pos].loading = false;
+        frames[pos].latch.unlock();
+        return pos;
+    }
+}
+
+bool BufferPool::waitLoaded(size_t pos) {
+    Frame &frame = frames[pos];
+    if (!frame.loading) {
+        return true;
+    }
+    {
+        // The loading thread holds the latch exclusively until the page is read
+        std::shared_lock page_lock(frame.latch);
+        if (!frame.loading) {
+            return true;
+        }
+    }
+    std::lock_guard lock(latch);
+    releaseAbandoned(pos);
+    return false;
+}
+
+void BufferPool::abandon(size_t pos) {
+    Frame &frame = frames[pos];
+    std::lock_guard lock(latch);
+    {
+        Partition &part = partition(frame.pid);
+        std::lock_guard part_lock(part.latch);
+        part.pid_to_pos.erase(frame.pid);
+        policy->erase(pos);
+    }
+    // Waiting threads see that the frame is still loading once they get the latch, and give it up
+    frame.latch.unlock();
+    releaseAbandoned(pos);
+}
+
+void BufferPool::releaseAbandoned(size_t pos) {
+    Frame &frame = frames[pos];
+    if (--frame.pins == 0) {
+        frame.pid = {};
+        frame.loading = false;
+        available.push_back(pos);
+    }
+}
+
+size_t BufferPool::install(const PageId &pid, size_t pos) {
+    Frame &frame = frames[pos];
+    frame.pid = pid;
+    frame.pins = 1;
+    // Hold the page latch until the page is read so that concurrent readers of the same page wait for it
+    frame.latch.lock();
+    std::lock_guard lock(latch);
+    // Earlier hits must reach the policy before this page does
+    drainAccesses();
+    Partition &part = partition(pid);
+    std::lock_guard part_lock(part.latch);
+    if (const size_t *found = part.pid_to_pos.find(pid)) {
+        // Another thread read the page in the meantime
+        size_t other = *found;
+        frames[other].pins++;
+        frame.pins = 0;
+        frame.pid = {};
+        frame.latch.unlock();
+        available.push_back(pos);
+        policy->access(other);
+        return other;
+    }
+    frame.loading = true;
+    part.pid_to_pos.insert(pid, pos);
+    policy->insert(pos, pid);
+    return pos;
+}
+
+size_t BufferPool::prefetch(size_t file, size_t first, size_t count) {
+    const DbFile &dbFile = getDatabase().get(file);
+
+    // Claim a frame for every page that is not resident yet. Claimed frames are not visible to other threads until
+    // they are installed, so they can be read without holding their latches.
+    std::vector<std::pair<size_t, size_t>> loading;
+    for (size_t page = first; page < first + count; page++) {
+        if (contains({file, page})) {
+            continue;
+        }
+        try {
+            loading.emplace_back(page, allocateFrame());
+        } catch (const std::runtime_error &) {
+            // Every frame is pinned: read what we have claimed so far
+            break;
+        }
+    }
+
+    // Read all the pages with a single batch
+    std::vector<std::pair<size_t, Page *>> batch;
+    for (const auto &[page, pos]: loading) {
+        batch.emplace_back(page, &pages[pos]);
+    }
+    try {
+        dbFile.readPages(batch);
+    } catch (...) {
+        std::lock_guard lock(latch);
+        for (const auto &[page, pos]: loading) {
+            available.push_back(pos);
+        }
+        throw;
+    }
+
+    // Publish the pages one at a time so that no two page latches are held together
+    size_t loaded = 0;
+    for (const auto &[page, pos]: loading) {
+        size_t installed = install({file, page}, pos);
+        if (installed == pos) {
+            frames[pos].loading = false;
+            frames[pos].latch.unlock();
+            loaded++;
+            frames[pos].pins--;
+        } else if (waitLoaded(installed)) {
+            frames[installed].pins--;
+        }
+    }
+    return loaded;
+}
+
+void BufferPool::writeFrame(size_t pos) {
+    Frame &frame = frames[pos];
+    std::shared_lock page_lock(frame.latch);
+    if (clearDirty(frame)) {
+        getDatabase().get(frame.pid.file).writePage(pages[pos], frame.pid.page);
+    }
+}
+
+void BufferPool::setDirty(Frame &frame) {
+    if (frame.dirty.exchange(true)) {
+        return;
+    }
+    frame.dirty_since = dirtyClock++;
+    if (++numDirty > highWatermark * numPages) {
+        flusher_cv.notify_one();
+    }
+}
+
+bool BufferPool::clearDirty(Frame &frame) {
+    if (!frame.dirty.exchange(false)) {
+        return false;
+    }
+    numDirty--;
+    return true;
+}
+
+size_t BufferPool::getNumDirty() const { return numDirty; }
+
+void BufferPool::setDirtyWatermarks(double low, double high) {
+    if (low < 0 || low > high || high > 1) {
+        throw std::invalid_argument("Watermarks must satisfy 0 <= low <= high <= 1");
+    }
+    std::lock_guard lock(flusher_latch);
+    lowWatermark = low;
+    highWatermark = high;
+    flusher_cv.notify_one();
+}
+
+void BufferPool::startFlusher() {
+    std::lock_guard lock(flusher_latch);
+    if (flusher.joinable()) {
+        return;
+    }
+    stopping = false;
+    flusher = std::thread(&BufferPool::runFlusher, this);
+}
+
+void BufferPool::stopFlusher() {
+    {
+        std::lock_guard lock(flusher_latch);
+        if (!flusher.joinable()) {
+            return;
+        }
+        stopping = true;
+    }
+    flusher_cv.notify_one();
+    flusher.join();
+}
+
+void BufferPool::runFlusher() {
+    std::unique_lock lock(flusher_latch);
+    while (!stopping) {
+        flusher_cv.wait_for(lock, FLUSH_INTERVAL, [this] {
+            return stopping || numDirty > highWatermark * numPages;
+        });
+        auto target = static_cast<size_t>(lowWatermark * numPages);
+        if (stopping || numDirty <= target) {
+            continue;
+        }
+        lock.unlock();
+        flushOldest(numDirty - target);
+        lock.lock();
+    }
+}
+
+size_t BufferPool::flushOldest(size_t count) {
+    // Pick the pages that have been dirty the longest
+    std::vector<std::tuple<size_t, PageId, size_t>> candidates;
+    for (const Partition &part: partitions) {
+        std::lock_guard part_lock(part.latch);
+        part.pid_to_pos.forEach([&](const PageId &pid, size_t pos) {
+            if (frames[pos].dirty) {
+                candidates.emplace_back(frames[pos].dirty_since.load(), pid, pos);
+            }
+        });
+    }
+    count = std::min(count, candidates.size());
+    auto by_age = [](const auto &a, const auto &b) { return std::get<0>(a) < std::get<0>(b); };
+    std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(), by_age);
+    candidates.resize(count);
 
-    // Read the page from disk to one of the available slots, make it the most recent page
-    size_t pos = available.back();
-    available.pop_back();
+    // Pin them (unless they were evicted in the meantime) and sort them by page number within each file
+    std::map<size_t, std::vector<std::pair<size_t, size_t>>> by_file;
+    for (const auto &[since, pid, pos]: candidates) {
+        Partition &part = partition(pid);
+        std::lock_guard part_lock(part.latch);
+        const size_t *found = part.pid_to_pos.find(pid);
+        if (found != nullptr && *found == pos) {
+            frames[pos].pins++;
+            by_file[pid.file].emplace_back(pid.page, pos);
+        }
+    }
 
-    Page &page = pages[pos];
-    getDatabase().get(pid.file).readPage(page, pid.page);
-    pid_to_pos[pid] = pos;
-    pos_to_pid[pos] = pid;
+    // Write the pages of each file with a single batch
+    size_t written = 0;
+    for (auto &[file, file_pages]: by_file) {
+        std::sort(file_pages.begin(), file_pages.end());
+        std::vector<std::shared_lock<std::shared_mutex>> locks;
+        std::vector<std::pair<size_t, const Page *>> batch;
+        for (const auto &[page, pos]: file_pages) {
+            locks.emplace_back(frames[pos].latch);
+            clearDirty(frames[pos]);
+            batch.emplace_back(page, &pages[pos]);
+        }
+        getDatabase().get(file).writePages(batch);
+        written += batch.size();
+        locks.clear();
+        for (const auto &[page, pos]: file_pages) {
+            frames[pos].pins--;
+        }
+    }
+    return written;
+}
 
-    lru_list.push_front(pos);
-    pos_to_lru[pos] = lru_list.begin();
+Page &BufferPool::getPage(const PageId &pid) {
+    // TODO pa0
+    size_t pos = fetch(pid);
+    frames[pos].pins--;
+    return pages[pos];
+}
 
-    return page;
+Page &BufferPool::pinPage(const PageId &pid) {
+    size_t pos = fetch(pid);
+    // Wait until the page has been read by the thread that loaded it
+    std::shared_lock page_lock(frames[pos].latch);
+    return pages[pos];
+}
+
+void BufferPool::unpinPage(const Page &page) {
+    size_t pos = position(page);
+    if (frames[pos].pins.fetch_sub(1) == 0) {
+        frames[pos].pins++;
+        throw std::logic_error("Page is not pinned");
+    }
+}
+
+std::shared_mutex &BufferPool::pageLatch(const Page &page) {
+    return frames[position(page)].latch;
 }
 
 void BufferPool::markDirty(const PageId &pid) {
     // TODO pa0
-    size_t pos = pid_to_pos.at(pid);
-    dirty.insert(pos);
+    const Partition &part = partition(pid);
+    std::lock_guard part_lock(part.latch);
+    setDirty(frames[part.pid_to_pos.at(pid)]);
 }
 
 bool BufferPool::isDirty(const PageId &pid) const {
     // TODO pa0
-    size_t pos = pid_to_pos.at(pid);
-    return dirty.contains(pos);
+    const Partition &part = partition(pid);
+    std::lock_guard part_lock(part.latch);
+    return frames[part.pid_to_pos.at(pid)].dirty;
 }
 
 bool BufferPool::contains(const PageId &pid) const {
     // TODO pa0
-    return pid_to_pos.contains(pid);
+    const Partition &part = partition(pid);
+    std::lock_guard part_lock(part.latch);
+    return part.pid_to_pos.contains(pid);
 }
 
 void BufferPool::discardPage(const PageId &pid) {
     // TODO pa0
-    size_t pos = pid_to_pos.at(pid);
-    pid_to_pos.erase(pid);
-    pos_to_pid[pos] = {};
-
-    lru_list.erase(pos_to_lru[pos]);
-    pos_to_lru.erase(pos);
-    dirty.erase(pos);
+    std::lock_guard lock(latch);
+    Partition &part = partition(pid);
+    std::lock_guard part_lock(part.latch);
+    size_t pos = part.pid_to_pos.at(pid);
+    Frame &frame = frames[pos];
+    if (frame.pins != 0) {
+        throw std::logic_error("Cannot discard a pinned page");
+    }
+    part.pid_to_pos.erase(pid);
+    frame.pid = {};
+    clearDirty(frame);
+    policy->erase(pos);
     available.push_back(pos);
 }
 
 void BufferPool::flushPage(const PageId &pid) {
     // TODO pa0
-    size_t pos = pid_to_pos.at(pid);
-    if (dirty.erase(pos) == 0)
+    Partition &part = partition(pid);
+    std::unique_lock part_lock(part.latch);
+    size_t pos = part.pid_to_pos.at(pid);
+    if (!frames[pos].dirty) {
         return;
-    const Page &page = pages[pos];
-    getDatabase().get(pid.file).writePage(page, pid.page);
+    }
+    frames[pos].pins++;
+    part_lock.unlock();
+    writeFrame(pos);
+    frames[pos].pins--;
 }
 
 void BufferPool::flushFile(const std::string &file) {
     // TODO pa0
-    std::vector<size_t> to_flush;
-    for (const size_t &pos: dirty) {
-        const PageId &pid = pos_to_pid[pos];
-        if (pid.file == file) {
-            to_flush.emplace_back(pid.page);
-        }
+    size_t id = getDatabase().getId(file);
+    std::vector<PageId> to_flush;
+    for (const Partition &part: partitions) {
+        std::lock_guard part_lock(part.latch);
+        part.pid_to_pos.forEach([&](const PageId &pid, size_t pos) {
+            if (pid.file == id && frames[pos].dirty) {
+                to_flush.push_back(pid);
+            }
+        });
+    }
+    for (const PageId &pid: to_flush) {
+        flushPage(pid);
     }
-    for (const auto &page: to_flush) {
-        flushPage({file, page});
+}
+
+PageGuard::PageGuard(BufferPool &bufferPool, const PageId &pid)
+        : bufferPool(&bufferPool), page(&bufferPool.pinPage(pid)) {}
+
+PageGuard::~PageGuard() {
+    release();
+}
+
+PageGuard::PageGuard(PageGuard &&other) noexcept: bufferPool(other.bufferPool), page(other.page) {
+    other.page = nullptr;
+}
+
+PageGuard &PageGuard::operator=(PageGuard &&other) noexcept {
+    if (this != &other) {
+        release();
+        bufferPool = other.bufferPool;
+        page = other.page;
+        other.page = nullptr;
     }
+    return *this;
+}
+
+void PageGuard::markDirty() {
+    bufferPool->setDirty(bufferPool->frames[bufferPool->position(*page)]);
+}
+
+std::shared_mutex &PageGuard::latch() const {
+    return bufferPool->pageLatch(*page);
+}
+
+void PageGuard::release() {
+    if (page != nullptr) {
+        bufferPool->unpinPage(*page);
+        page = nullptr;
+    }
+}
+
+PageView::PageView(const Page &page) : page(&page) {}
+
+PageView::PageView(BufferPool &bufferPool, const PageId &pid) : guard(std::in_place, bufferPool, pid) {
+    lock = std::shared_lock(guard->latch());
+    page = &**guard;
 }
@@ -0,0 +1,424 @@
+#include <db/Checksum.hpp>
+#include <db/Compression.hpp>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace db;
+
+namespace {
+    constexpr size_t MIN_MATCH = 4;
+    /// The last match must start at least MATCH_LIMIT bytes before the end, and the last LAST_LITERALS bytes are literals.
+    constexpr size_t MATCH_LIMIT = 12;
+    constexpr size_t LAST_LITERALS = 5;
+    constexpr size_t MAX_OFFSET = 65535;
+    constexpr int HASH_BITS = 13;
+
+    uint32_t load32(const uint8_t *p) {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    uint32_t hash(uint32_t sequence) { return (sequence * 2654435761u) >> (32 - HASH_BITS); }
+
+    /// Writes a length that does not fit in a 4-bit field of the token: 255 while it does not fit in a byte.
+    uint8_t *writeLength(uint8_t *out, size_t length) {
+        for (; length >= 255; length -= 255) {
+            *out++ = 255;
+        }
+        *out++ = static_cast<uint8_t>(length);
+        return out;
+    }
+
+    size_t readLength(const uint8_t *src, size_t length, size_t &i) {
+        size_t value = 0;
+        uint8_t byte;
+        do {
+            if (i >= length) {
+                throw std::runtime_error("Corrupt compressed block");
+            }
+            byte = src[i++];
+            value += byte;
+        } while (byte == 255);
+        return value;
+    }
+
+    /// A block header, followed by `length` bytes: the pages of the group, compressed unless `length` is their size.
+    struct BlockHeader {
+        uint32_t magic;
+        uint32_t group;
+        uint32_t pages;
+        uint32_t length;
+    };
+
+    /// The last bytes of a file with an index: the index holds the offset, pages and length of the block of each group.
+    struct Trailer {
+        uint64_t offset;
+        uint64_t groups;
+        uint32_t crc;
+        uint32_t magic;
+    };
+
+    constexpr uint32_t BLOCK_MAGIC = 0x4b4c4250;  // "PBLK"
+    constexpr uint32_t INDEX_MAGIC = 0x58444950;  // "PIDX"
+    constexpr size_t INDEX_ENTRY_SIZE = 16;
+} // namespace
+
+size_t db::lz4Compress(const uint8_t *src, size_t length, uint8_t *dst) {
+    uint8_t *out = dst;
+    size_t anchor = 0;
+    auto emit = [&](size_t literals, size_t offset, size_t match) {
+        uint8_t *token = out++;
+        *token = static_cast<uint8_t>(std::min<size_t>(literals, 15) << 4);
+        if (literals >= 15) {
+            out = writeLength(out, literals - 15);
+        }
+        if (literals != 0) {
+            std::memcpy(out, src + anchor, literals);
+            out += literals;
+        }
+        if (match == 0) {
+            return;
+        }
+        *out++ = static_cast<uint8_t>(offset);
+        *out++ = static_cast<uint8_t>(offset >> 8);
+        *token |= static_cast<uint8_t>(std::min<size_t>(match - MIN_MATCH, 15));
+        if (match - MIN_MATCH >= 15) {
+            out = writeLength(out, match - MIN_MATCH - 15);
+        }
+    };
+
+    if (length >= MATCH_LIMIT + 1) {
+        std::array<uint32_t, size_t{1} << HASH_BITS> table{};
+        size_t pos = 0;
+        size_t misses = 0;
+        while (pos + MATCH_LIMIT <= length) {
+            uint32_t sequence = load32(src + pos);
+            uint32_t &entry = table[hash(sequence)];
+            size_t candidate = entry;
+            entry = static_cast<uint32_t>(pos);
+            if (candidate >= pos || pos - candidate > MAX_OFFSET || load32(src + candidate) != sequence) {
+                // Skip faster through data that does not compress
+                pos += 1 + (misses++ >> 6);
+                continue;
+            }
+            misses = 0;
+            size_t match = MIN_MATCH;
+            size_t limit = length - LAST_LITERALS - pos;
+            while (match < limit && src[candidate + match] == src[pos + match]) {
+                match++;
+            }
+            while (pos > anchor && candidate > 0 && src[pos - 1] == src[candidate - 1]) {
+                pos--;
+                candidate--;
+                match++;
+            }
+            emit(pos - anchor, pos - candidate, match);
+            pos += match;
+            anchor = pos;
+        }
+    }
+    emit(length - anchor, 0, 0);
+    return out - dst;
+}
+
+void db::lz4Decompress(const uint8_t *src, size_t length, uint8_t *dst, size_t raw) {
+    size_t i = 0;
+    size_t o = 0;
+    while (true) {
+        if (i >= length) {
+            throw std::runtime_error("Corrupt compressed block");
+        }
+        uint8_t token = src[i++];
+        size_t literals = token >> 4;
+        if (literals == 15) {
+            literals += readLength(src, length, i);
+        }
+        if (literals > length - i || literals > raw - o) {
+            throw std::runtime_error("Corrupt compressed block");
+        }
+        if (literals != 0) {
+            std::memcpy(dst + o, src + i, literals);
+            i += literals;
+            o += literals;
+        }
+        if (i == length) {
+            break;
+        }
+        if (length - i < 2) {
+            throw std::runtime_error("Corrupt compressed block");
+        }
+        size_t offset = src[i] | src[i + 1] << 8;
+        i += 2;
+        size_t match = token & 15;
+        if (match == 15) {
+            match += readLength(src, length, i);
+        }
+        match += MIN_MATCH;
+        if (offset == 0 || offset > o || match > raw - o) {
+            throw std::runtime_error("Corrupt compressed block");
+        }
+        if (offset == 1) {
+            std::memset(dst + o, dst[o - 1], match);
+            o += match;
+            continue;
+        }
+        // An overlapping match repeats the last `offset` bytes: copy them a period at a time
+        for (size_t copied = 0; copied < match;) {
+            size_t step = std::min(match - copied, offset);
+            std::memcpy(dst + o, dst + o - offset, step);
+            o += step;
+            copied += step;
+        }
+    }
+    if (o != raw) {
+        throw std::runtime_error("Corrupt compressed block");
+    }
+}
+
+CompressedPages::CompressedPages(int fd, IoEngine &io) : fd(fd), io(io) {
+    struct stat st{};
+    if (fstat(fd, &st) == -1) {
+        throw std::runtime_error("fstat");
+    }
+    auto size = static_cast<uint64_t>(st.st_size);
+    if (!loadIndex(size)) {
+        scanBlocks(size);
+    }
+    trim = append != size;
+}
+
+CompressedPages::~CompressedPages() {
+    if (!modified) {
+        return;
+    }
+    std::vector<uint8_t> index(blocks.size() * INDEX_ENTRY_SIZE + sizeof(Trailer));
+    for (size_t group = 0; group < blocks.size(); group++) {
+        std::memcpy(index.data() + group * INDEX_ENTRY_SIZE, &blocks[group], INDEX_ENTRY_SIZE);
+    }
+    Trailer trailer{append, blocks.size(), crc32c(index.data(), blocks.size() * INDEX_ENTRY_SIZE), INDEX_MAGIC};
+    std::memcpy(index.data() + blocks.size() * INDEX_ENTRY_SIZE, &trailer, sizeof(trailer));
+    try {
+        io.submit({{fd, index.data(), index.size(), static_cast<off_t>(append), true}});
+        if (ftruncate(fd, static_cast<off_t>(append + index.size())) == -1) {
+            throw std::runtime_error("ftruncate");
+        }
+    } catch (const std::exception &) {
+        // Without the index, the blocks are scanned when the file is opened
+    }
+}
+
+bool CompressedPages::loadIndex(uint64_t size) {
+    Trailer trailer{};
+    if (size < sizeof(trailer)) {
+        return false;
+    }
+    io.submit({{fd, reinterpret_cast<uint8_t *>(&trailer), sizeof(trailer),
+                static_cast<off_t>(size - sizeof(trailer)), false}});
+    if (trailer.magic != INDEX_MAGIC || trailer.offset > size ||
+        trailer.groups > (size - trailer.offset) / INDEX_ENTRY_SIZE ||
+        trailer.offset + trailer.groups * INDEX_ENTRY_SIZE + sizeof(trailer) != size) {
+        return false;
+    }
+    std::vector<uint8_t> index(trailer.groups * INDEX_ENTRY_SIZE);
+    io.submit({{fd, index.data(), index.size(), static_cast<off_t>(trailer.offset), false}});
+    if (crc32c(index.data(), index.size()) != trailer.crc) {
+        return false;
+    }
+    blocks.resize(trailer.groups);
+    for (size_t group = 0; group < blocks.size(); group++) {
+        std::memcpy(&blocks[group], index.data() + group * INDEX_ENTRY_SIZE, INDEX_ENTRY_SIZE);
+    }
+    append = trailer.offset;
+    return true;
+}
+
+void CompressedPages::scanBlocks(uint64_t size) {
+    uint64_t offset = 0;
+    while (offset + sizeof(BlockHeader) <= size) {
+        BlockHeader header{};
+        io.submit({{fd, reinterpret_cast<uint8_t *>(&header), sizeof(header), static_cast<off_t>(offset), false}});
+        uint64_t end = offset + sizeof(header) + header.length;
+        if (header.magic != BLOCK_MAGIC || header.pages == 0 || header.pages > GROUP_PAGES ||
+            header.length > lz4Bound(GROUP_SIZE) || end > size) {
+            break;
+        }
+        if (header.group >= blocks.size()) {
+            blocks.resize(header.group + 1);
+        }
+        // A group written again is superseded by its later block
+        blocks[header.group] = {offset, header.pages, header.length};
+        offset = end;
+    }
+    append = offset;
+}
+
+size_t CompressedPages::size() {
+    std::lock_guard lock(latch);
+    for (size_t group = blocks.size(); group-- > 0;) {
+        if (blocks[group].pages != 0) {
+            return group * GROUP_PAGES + blocks[group].pages;
+        }
+    }
+    return 0;
+}
+
+void CompressedPages::load(const std::vector<size_t> &groups, std::vector<std::vector<uint8_t>> &buffers) {
+    std::vector<std::vector<uint8_t>> data(groups.size());
+    std::vector<IoRequest> requests;
+    for (size_t i = 0; i < groups.size(); i++) {
+        if (groups[i] < blocks.size() && blocks[groups[i]].pages != 0) {
+            const Block &block = blocks[groups[i]];
+            data[i].resize(block.length);
+            requests.push_back({fd, data[i].data(), block.length, static_cast<off_t>(block.offset + sizeof(BlockHeader)),
+                                false});
+        }
+    }
+    io.submit(requests);
+    buffers.resize(groups.size());
+    for (size_t i = 0; i < groups.size(); i++) {
+        std::vector<uint8_t> &buffer = buffers[i];
+        buffer.assign(GROUP_SIZE, 0);
+        if (data[i].empty()) {
+            continue;
+        }
+        const Block &block = blocks[groups[i]];
+        size_t raw = block.pages * DEFAULT_PAGE_SIZE;
+        if (block.length == raw) {
+            std::memcpy(buffer.data(), data[i].data(), raw);
+        } else {
+            lz4Decompress(data[i].data(), block.length, buffer.data(), raw);
+        }
+    }
+}
+
+void CompressedPages::store(const std::vector<std::pair<size_t, const uint8_t *>> &groups,
+                            const std::vector<uint32_t> &pages) {
+    // All the blocks are appended back to back with a single write
+    std::vector<uint8_t> data;
+    std::vector<Block> written;
+    std::vector<uint8_t> compressed(lz4Bound(GROUP_SIZE));
+    for (size_t i = 0; i < groups.size(); i++) {
+        const auto &[group, raw] = groups[i];
+        size_t size = pages[i] * DEFAULT_PAGE_SIZE;
+        size_t length = lz4Compress(raw, size, compressed.data());
+        // Store the pages as they are if they do not compress
+        const uint8_t *block = length < size ? compressed.data() : raw;
+        length = std::min(length, size);
+        BlockHeader header{BLOCK_MAGIC, static_cast<uint32_t>(group), pages[i], static_cast<uint32_t>(length)};
+        written.push_back({append + data.size(), pages[i], static_cast<uint32_t>(length)});
+        data.insert(data.end(), reinterpret_cast<const uint8_t *>(&header),
+                    reinterpret_cast<const uint8_t *>(&header) + sizeof(header));
+        data.insert(data.end(), block, block + length);
+    }
+    if (trim) {
+        // Remove the index (or an incomplete block), so that it is not mistaken for the index of the new blocks
+        if (ftruncate(fd, static_cast<off_t>(append)) == -1) {
+            throw std::runtime_error("ftruncate");
+        }
+        trim = false;
+    }
+    io.submit({{fd, data.data(), data.size(), static_cast<off_t>(append), true}});
+    append += data.size();
+    modified = true;
+    for (size_t i = 0; i < groups.size(); i++) {
+        size_t group = groups[i].first;
+        if (group >= blocks.size()) {
+            blocks.resize(group + 1);
+        }
+        blocks[group] = written[i];
+        if (group == cached_group) {
+            std::memcpy(cached.data(), groups[i].second, GROUP_SIZE);
+        }
+    }
+}
+
+void CompressedPages::read(const std::vector<std::pair<size_t, uint8_t *>> &pages) {
+    std::lock_guard lock(latch);
+    std::vector<size_t> groups;
+    for (const auto &[id, data]: pages) {
+        size_t group = id / GROUP_PAGES;
+        if (group != cached_group) {
+            groups.push_back(group);
+        }
+    }
+    std::sort(groups.begin(), groups.end());
+    groups.erase(std::unique(groups.begin(), groups.end()), groups.end());
+    std::vector<std::vector<uint8_t>> buffers;
+    load(groups, buffers);
+    for (const auto &[id, data]: pages) {
+        size_t group = id / GROUP_PAGES;
+        const uint8_t *buffer = group == cached_group ? cached.data()
+                                                      : buffers[std::lower_bound(groups.begin(), groups.end(), group) -
+                                                                groups.begin()].data();
+        std::memcpy(data, buffer + id % GROUP_PAGES * DEFAULT_PAGE_SIZE, DEFAULT_PAGE_SIZE);
+    }
+    if (!groups.empty()) {
+        cached_group = groups.back();
+        cached = std::move(buffers.back());
+    }
+}
+
+void CompressedPages::write(const std::vector<std::pair<size_t, uint8_t *>> &pages) {
+    std::lock_guard lock(latch);
+    std::map<size_t, std::vector<std::pair<size_t, const uint8_t *>>> updates;
+    for (const auto &[id, data]: pages) {
+        updates[id / GROUP_PAGES].emplace_back(id % GROUP_PAGES, data);
+    }
+    // The groups that are not entirely overwritten are read first
+    std::vector<size_t> partial;
+    for (const auto &[group, changes]: updates) {
+        if (changes.size() < GROUP_PAGES && group != cached_group) {
+            partial.push_back(group);
+        }
+    }
+    std::vector<std::vector<uint8_t>> buffers;
+    load(partial, buffers);
+    std::vector<std::vector<uint8_t>> raw;
+    std::vector<std::pair<size_t, const uint8_t *>> groups;
+    std::vector<uint32_t> counts;
+    raw.reserve(updates.size());
+    for (const auto &[group, changes]: updates) {
+        auto it = std::lower_bound(partial.begin(), partial.end(), group);
+        if (it != partial.end() && *it == group) {
+            raw.push_back(std::move(buffers[it - partial.begin()]));
+        } else if (group == cached_group) {
+            raw.push_back(cached);
+        } else {
+            raw.emplace_back(GROUP_SIZE, 0);
+        }
+        uint32_t count = group < blocks.size() ? blocks[group].pages : 0;
+        for (const auto &[page, data]: changes) {
+            std::memcpy(raw.back().data() + page * DEFAULT_PAGE_SIZE, data, DEFAULT_PAGE_SIZE);
+            count = std::max<uint32_t>(count, page + 1);
+        }
+        groups.emplace_back(group, raw.back().data());
+        counts.push_back(count);
+    }
+    store(groups, counts);
+}
+
+void CompressedPages::truncate(size_t pages) {
+    std::lock_guard lock(latch);
+    size_t group = pages / GROUP_PAGES;
+    size_t count = pages % GROUP_PAGES;
+    if (count != 0 && group < blocks.size() && blocks[group].pages > count) {
+        // Rewrite the last group without the removed pages
+        std::vector<std::vector<uint8_t>> buffers;
+        load({group}, buffers);
+        std::memset(buffers[0].data() + count * DEFAULT_PAGE_SIZE, 0, GROUP_SIZE - count * DEFAULT_PAGE_SIZE);
+        store({{group, buffers[0].data()}}, {static_cast<uint32_t>(count)});
+    }
+    if (blocks.size() > (pages + GROUP_PAGES - 1) / GROUP_PAGES) {
+        blocks.resize((pages + GROUP_PAGES - 1) / GROUP_PAGES);
+        modified = true;
+    }
+    if (cached_group != SIZE_MAX && cached_group * GROUP_PAGES >= pages) {
+        cached_group = SIZE_MAX;
+    }
+}
@@ -1,7 +1,10 @@
 #include <db/Database.hpp>
+#include <stdexcept>
 
 using namespace db;
 
+Database::Database() : files(std::make_unique<std::unique_ptr<DbFile>[]>(MAX_FILES)) {}
+
 BufferPool &Database::getBufferPool() { return bufferPool; }
 
 Database &db::getDatabase() {
@@ -11,24 +14,63 @@ Database &db::getDatabase() {
 
 void Database::add(std::unique_ptr<DbFile> file) {
     // TODO pa0
-    const std::string &name = file->getName();
-    if (files.contains(name)) {
+    size_t id = file->getId();
+    if (files[id]) {
         throw std::logic_error("File already exists");
     }
-    files[name] = std::move(file);
+    files[id] = std::move(file);
 }
 
 std::unique_ptr<DbFile> Database::remove(const std::string &name) {
     // TODO pa0
-    auto nh = files.extract(name);
-    if (nh.empty()) {
+    size_t id = getId(name);
+    if (!files[id]) {
         throw std::logic_error("File does not exist");
     }
-    Database::getBufferPool().flushFile(nh.key());
-    return std::move(nh.mapped());
+    // Flush while the file is still in the catalog: writing a page looks the file up by id
+    Database::getBufferPool().flushFile(name);
+    return std::move(files[id]);
 }
 
 DbFile &Database::get(const std::string &name) const {
     // TODO pa0
-    return *files.at(name);
+    size_t id;
+    {
+        std::lock_guard lock(ids_latch);
+        auto it = ids.find(name);
+        if (it == ids.end()) {
+            throw std::logic_error("File does not exist");
+        }
+        id = it->second;
+    }
+    return get(id);
 }
+
+DbFile &Database::get(size_t id) const {
+    if (id >= MAX_FILES || !files[id]) {
+        throw std::logic_error("File does not exist");
+    }
+    return *files[id];
+}
+
+bool Database::contains(const std::string &name) const {
+    std::lock_guard lock(ids_latch);
+    auto it = ids.find(name);
+    return it != ids.end() && files[it->second];
+}
+
+size_t Database::getId(const std::string &name) {
+    std::lock_guard lock(ids_latch);
+    auto it = ids.find(name);
+    if (it != ids.end()) {
+        return it->second;
+    }
+    if (ids.size() == MAX_FILES) {
+        throw std::runtime_error("Too many files");
+    }
+    size_t id = ids.size();
+    ids.emplace(name, id);
+    return id;
+}
+
+PageId::PageId(const std::string &file, size_t page) : PageId(getDatabase().getId(file), page) {}
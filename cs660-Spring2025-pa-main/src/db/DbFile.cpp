@@ -1,6 +1,14 @@
+#include <db/Checksum.hpp>
+#include <db/Database.hpp>
 #include <db/DbFile.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <new>
 #include <stdexcept>
 #include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
@@ -8,10 +16,22 @@ using namespace db;
 
 const TupleDesc &DbFile::getTupleDesc() const { return td; }
 
-DbFile::DbFile(const std::string &name, const TupleDesc &td) : name(name), td(td) {
+DbFile::DbFile(const std::string &name, const TupleDesc &td, const DbFileOptions &options)
+        : direct(options.direct && !options.mmap && !options.compressed), io(makeIoEngine(options.io)),
+          mapped(options.mmap), name(name), file_id(getDatabase().getId(name)), td(td) {
     // TODO pa1: open file and initialize numPages
     // Hint: use open, fstat
-    fd = open(name.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (options.compressed && options.mmap) {
+        throw std::invalid_argument("A compressed file cannot be mapped");
+    }
+    int flags = mapped ? O_RDONLY : O_RDWR | O_CREAT;
+    mode_t mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
+    fd = open(name.c_str(), direct ? flags | O_DIRECT : flags, mode);
+    if (fd == -1 && direct && errno == EINVAL) {
+        // The file system does not support O_DIRECT
+        direct = false;
+        fd = open(name.c_str(), flags, mode);
+    }
     if (fd == -1) {
         throw std::runtime_error("open");
     }
@@ -19,33 +39,292 @@ DbFile::DbFile(const std::string &name, const TupleDesc &td) : name(name), td(td
     if (fstat(fd, &st) == -1) {
         throw std::runtime_error("fstat");
     }
-    numPages = st.st_size / DEFAULT_PAGE_SIZE;
+    const size_t size = st.st_size;
+    numPages = size / DEFAULT_PAGE_SIZE;
     if (numPages == 0) {
         numPages = 1;
     }
+    if (mapped) {
+        remap();
+    }
+    if (options.compressed) {
+        compressed = std::make_unique<CompressedPages>(fd, *io);
+        numPages = std::max<size_t>(compressed->size(), 1);
+    }
+    if (options.checksums) {
+        std::string crc_name = name + ".crc";
+        crc_fd = open(crc_name.c_str(), mapped ? O_RDONLY : O_RDWR | O_CREAT, mode);
+        if (crc_fd == -1 || fstat(crc_fd, &st) == -1) {
+            throw std::runtime_error("open " + crc_name);
+        }
+        crcs.resize(st.st_size / sizeof(uint32_t));
+        size_t length = crcs.size() * sizeof(uint32_t);
+        if (pread(crc_fd, crcs.data(), length, 0) != static_cast<ssize_t>(length)) {
+            throw std::runtime_error("read " + crc_name);
+        }
+        // The checksum file may be left over from a deleted file with the same name: only the checksums of the pages
+        // in the file are kept, including a partially written last page
+        size_t pages = compressed ? compressed->size() : (size + DEFAULT_PAGE_SIZE - 1) / DEFAULT_PAGE_SIZE;
+        if (crcs.size() > pages) {
+            crcs.resize(pages);
+            if (!mapped && ftruncate(crc_fd, static_cast<off_t>(pages * sizeof(uint32_t))) == -1) {
+                throw std::runtime_error("ftruncate " + crc_name);
+            }
+        }
+    }
 }
 
 DbFile::~DbFile() {
     // TODO pa1: close file
     // Hind: use close
+    for (const auto &[addr, length]: mappings) {
+        munmap(addr, length);
+    }
+    if (crc_fd != -1) {
+        close(crc_fd);
+    }
+    // The index of a compressed file is written before the file is closed
+    compressed.reset();
     close(fd);
 }
 
 const std::string &DbFile::getName() const { return name; }
 
+size_t DbFile::getId() const { return file_id; }
+
+IoEngineType DbFile::getIoEngine() const { return io->type(); }
+
+bool DbFile::isDirect() const { return direct; }
+
+bool DbFile::isMapped() const { return mapped; }
+
+bool DbFile::hasChecksums() const { return crc_fd != -1; }
+
+bool DbFile::isCompressed() const { return compressed != nullptr; }
+
+void DbFile::remap() const {
+    std::lock_guard lock(map_latch);
+    struct stat st{};
+    if (fstat(fd, &st) == -1) {
+        throw std::runtime_error("fstat");
+    }
+    size_t pages = st.st_size / DEFAULT_PAGE_SIZE;
+    if (pages <= map_pages) {
+        return;
+    }
+    size_t length = pages * DEFAULT_PAGE_SIZE;
+    void *addr = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        throw std::runtime_error("mmap");
+    }
+    mappings.emplace_back(addr, length);
+    // Publish the base before the size: a reader that sees the new size also sees the new base
+    map_base = static_cast<const uint8_t *>(addr);
+    map_pages = pages;
+    numPages = std::max(numPages, pages);
+}
+
+PageView DbFile::viewPage(size_t id) const {
+    if (!mapped) {
+        return {getDatabase().getBufferPool(), {file_id, id}};
+    }
+    if (id >= map_pages) {
+        remap();
+    }
+    if (id >= map_pages) {
+        static const Page empty{};
+        return PageView(empty);
+    }
+    return PageView(*reinterpret_cast<const Page *>(map_base.load() + id * DEFAULT_PAGE_SIZE));
+}
+
+void DbFile::adviseSequential() const {
+    if (!mapped) {
+        return;
+    }
+    remap();
+    if (map_pages != 0) {
+        madvise(const_cast<uint8_t *>(map_base.load()), map_pages * DEFAULT_PAGE_SIZE, MADV_SEQUENTIAL);
+    }
+}
+
+void DbFile::adviseWillNeed(size_t first, size_t count) const {
+    if (!mapped) {
+        getDatabase().getBufferPool().prefetch(file_id, first, count);
+        return;
+    }
+    size_t pages = map_pages;
+    if (first < pages) {
+        count = std::min(count, pages - first);
+        madvise(const_cast<uint8_t *>(map_base.load()) + first * DEFAULT_PAGE_SIZE, count * DEFAULT_PAGE_SIZE,
+                MADV_WILLNEED);
+    }
+}
+
+void DbFile::transfer(const std::vector<std::pair<size_t, uint8_t *>> &pages, bool write) const {
+    if (compressed) {
+        write ? compressed->write(pages) : compressed->read(pages);
+        return;
+    }
+    // O_DIRECT requires aligned buffers: stage the unaligned pages in an aligned bounce buffer
+    std::vector<size_t> bounced;
+    if (direct) {
+        for (size_t i = 0; i < pages.size(); i++) {
+            if (reinterpret_cast<uintptr_t>(pages[i].second) % DEFAULT_PAGE_SIZE != 0) {
+                bounced.push_back(i);
+            }
+        }
+    }
+    std::unique_ptr<uint8_t, decltype(&std::free)> bounce(nullptr, &std::free);
+    if (!bounced.empty()) {
+        bounce.reset(static_cast<uint8_t *>(std::aligned_alloc(DEFAULT_PAGE_SIZE, bounced.size() * DEFAULT_PAGE_SIZE)));
+        if (!bounce) {
+            throw std::bad_alloc();
+        }
+    }
+
+    std::vector<IoRequest> requests;
+    for (const auto &[id, data]: pages) {
+        requests.push_back({fd, data, DEFAULT_PAGE_SIZE, static_cast<off_t>(id * DEFAULT_PAGE_SIZE), write});
+    }
+    for (size_t i = 0; i < bounced.size(); i++) {
+        uint8_t *staged = bounce.get() + i * DEFAULT_PAGE_SIZE;
+        if (write) {
+            std::memcpy(staged, pages[bounced[i]].second, DEFAULT_PAGE_SIZE);
+        }
+        requests[bounced[i]].buf = staged;
+    }
+    io->submit(requests);
+    if (!write) {
+        for (size_t i = 0; i < bounced.size(); i++) {
+            std::memcpy(pages[bounced[i]].second, bounce.get() + i * DEFAULT_PAGE_SIZE, DEFAULT_PAGE_SIZE);
+        }
+    }
+}
+
+void DbFile::stamp(const std::vector<std::pair<size_t, uint8_t *>> &pages) const {
+    std::vector<uint32_t> sums;
+    for (const auto &[id, data]: pages) {
+        sums.push_back(crc32c(data, DEFAULT_PAGE_SIZE));
+    }
+    std::lock_guard lock(crc_latch);
+    for (size_t i = 0; i < pages.size(); i++) {
+        size_t id = pages[i].first;
+        if (id >= crcs.size()) {
+            crcs.resize(id + 1);
+        }
+        crcs[id] = sums[i];
+    }
+    // The checksums are written after the pages, so a page torn by a crash in between does not match its old checksum.
+    // The checksums of adjacent pages are written together.
+    for (size_t i = 0; i < pages.size();) {
+        size_t first = pages[i].first;
+        size_t count = 1;
+        while (i + count < pages.size() && pages[i + count].first == first + count) {
+            count++;
+        }
+        size_t length = count * sizeof(uint32_t);
+        off_t offset = static_cast<off_t>(first * sizeof(uint32_t));
+        if (pwrite(crc_fd, &crcs[first], length, offset) != static_cast<ssize_t>(length)) {
+            throw std::runtime_error("write " + name + ".crc");
+        }
+        i += count;
+    }
+}
+
+void DbFile::verify(const std::vector<std::pair<size_t, uint8_t *>> &pages) const {
+    for (const auto &[id, data]: pages) {
+        uint32_t expected;
+        {
+            std::lock_guard lock(crc_latch);
+            expected = id < crcs.size() ? crcs[id] : 0;
+        }
+        // A page that was never written with checksums has none (and a page whose checksum is 0 is not verified)
+        if (expected != 0 && crc32c(data, DEFAULT_PAGE_SIZE) != expected) {
+            throw std::runtime_error("Checksum mismatch in page " + std::to_string(id) + " of " + name);
+        }
+    }
+}
+
 void DbFile::readPage(Page &page, const size_t id) const {
-    reads.push_back(id);
+    {
+        std::lock_guard lock(io_latch);
+        reads.push_back(id);
+    }
     // TODO pa1: read page
     // Hint: use pread
-    std::fill(page.begin(), page.end(), 0);
-    pread(fd, page.data(), DEFAULT_PAGE_SIZE, id * DEFAULT_PAGE_SIZE);
+    transfer({{id, page.data()}}, false);
+    if (crc_fd != -1) {
+        verify({{id, page.data()}});
+    }
+}
+
+void DbFile::readPages(const std::vector<std::pair<size_t, Page *>> &pages) const {
+    std::vector<std::pair<size_t, uint8_t *>> data;
+    {
+        std::lock_guard lock(io_latch);
+        for (const auto &[id, page]: pages) {
+            reads.push_back(id);
+            data.emplace_back(id, page->data());
+        }
+    }
+    transfer(data, false);
+    if (crc_fd != -1) {
+        verify(data);
+    }
 }
 
 void DbFile::writePage(const Page &page, const size_t id) const {
-    writes.push_back(id);
+    {
+        std::lock_guard lock(io_latch);
+        writes.push_back(id);
+    }
     // TODO pa1: write page
     // Hint: use pwrite
-    pwrite(fd, page.data(), DEFAULT_PAGE_SIZE, id * DEFAULT_PAGE_SIZE);
+    transfer({{id, const_cast<uint8_t *>(page.data())}}, true);
+    if (crc_fd != -1) {
+        stamp({{id, const_cast<uint8_t *>(page.data())}});
+    }
+}
+
+void DbFile::writePages(const std::vector<std::pair<size_t, const Page *>> &pages) const {
+    std::vector<std::pair<size_t, uint8_t *>> data;
+    {
+        std::lock_guard lock(io_latch);
+        for (const auto &[id, page]: pages) {
+            writes.push_back(id);
+            data.emplace_back(id, const_cast<uint8_t *>(page->data()));
+        }
+    }
+    transfer(data, true);
+    if (crc_fd != -1) {
+        stamp(data);
+    }
+}
+
+void DbFile::truncate(size_t pages) {
+    if (mapped) {
+        throw std::logic_error("Cannot truncate a memory-mapped file");
+    }
+    BufferPool &bufferPool = getDatabase().getBufferPool();
+    for (size_t id = pages; id < numPages; id++) {
+        if (bufferPool.contains({file_id, id})) {
+            bufferPool.discardPage({file_id, id});
+        }
+    }
+    if (compressed) {
+        compressed->truncate(pages);
+    } else if (ftruncate(fd, static_cast<off_t>(pages * DEFAULT_PAGE_SIZE)) == -1) {
+        throw std::runtime_error("ftruncate");
+    }
+    if (crc_fd != -1) {
+        std::lock_guard lock(crc_latch);
+        crcs.resize(std::min(crcs.size(), pages));
+        if (ftruncate(crc_fd, static_cast<off_t>(crcs.size() * sizeof(uint32_t))) == -1) {
+            throw std::runtime_error("ftruncate");
+        }
+    }
+    numPages = std::max<size_t>(pages, 1);
 }
 
 const std::vector<size_t> &DbFile::getReads() const { return reads; }
@@ -58,6 +337,18 @@ void DbFile::deleteTuple(const Iterator &it) { throw std::runtime_error("Not imp
 
 Tuple DbFile::getTuple(const Iterator &it) const { throw std::runtime_error("Not implemented"); }
 
+TupleView DbFile::view(const Iterator &it) const { throw std::runtime_error("Not implemented"); }
+
+void DbFile::scan(const std::function<void(const TupleView &)> &f) const {
+    for (Iterator it = begin(); it != end(); ++it) {
+        f(it.view());
+    }
+}
+
+void DbFile::scan(const std::vector<size_t> &fields, const std::function<void(const TupleView &)> &f) const {
+    scan(f);
+}
+
 void DbFile::next(Iterator &it) const { throw std::runtime_error("Not implemented"); }
 
 Iterator DbFile::begin() const { throw std::runtime_error("Not implemented"); }
@@ -0,0 +1,81 @@
+#include <db/FreeSpaceMap.hpp>
+#include <algorithm>
+#include <bit>
+#include <fstream>
+#include <stdexcept>
+
+using namespace db;
+
+FreeSpaceMap::FreeSpaceMap(size_t pages) : leaves(std::bit_ceil(std::max<size_t>(pages, 1))), pages(pages) {
+    tree.assign(2 * leaves, 0);
+}
+
+uint8_t FreeSpaceMap::get(size_t page) const { return page < pages ? tree[leaves + page] : 0; }
+
+void FreeSpaceMap::set(size_t page, uint8_t free) {
+    if (page >= leaves) {
+        // Double the number of leaves: the old tree becomes the left subtree of the new root
+        std::vector<uint8_t> old = std::move(tree);
+        size_t old_leaves = leaves;
+        leaves = std::bit_ceil(page + 1);
+        tree.assign(2 * leaves, 0);
+        std::copy_n(old.begin() + old_leaves, old_leaves, tree.begin() + leaves);
+        for (size_t i = leaves - 1; i > 0; i--) {
+            tree[i] = std::max(tree[2 * i], tree[2 * i + 1]);
+        }
+    }
+    pages = std::max(pages, page + 1);
+    size_t i = leaves + page;
+    tree[i] = free;
+    for (i /= 2; i > 0; i /= 2) {
+        uint8_t max = std::max(tree[2 * i], tree[2 * i + 1]);
+        if (tree[i] == max) {
+            break;
+        }
+        tree[i] = max;
+    }
+}
+
+void FreeSpaceMap::truncate(size_t pages) {
+    for (size_t page = pages; page < this->pages; page++) {
+        set(page, 0);
+    }
+    this->pages = std::min(this->pages, pages);
+}
+
+size_t FreeSpaceMap::find(uint8_t free) const {
+    if (tree[1] < free) {
+        return npos;
+    }
+    size_t i = 1;
+    while (i < leaves) {
+        i = tree[2 * i] >= free ? 2 * i : 2 * i + 1;
+    }
+    return i - leaves;
+}
+
+bool FreeSpaceMap::load(const std::string &path, size_t pages) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in || static_cast<size_t>(in.tellg()) != pages) {
+        return false;
+    }
+    std::vector<uint8_t> bytes(pages);
+    in.seekg(0);
+    if (!in.read(reinterpret_cast<char *>(bytes.data()), static_cast<std::streamsize>(pages))) {
+        return false;
+    }
+    *this = FreeSpaceMap(pages);
+    std::copy(bytes.begin(), bytes.end(), tree.begin() + leaves);
+    for (size_t i = leaves - 1; i > 0; i--) {
+        tree[i] = std::max(tree[2 * i], tree[2 * i + 1]);
+    }
+    return true;
+}
+
+void FreeSpaceMap::save(const std::string &path) const {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char *>(tree.data() + leaves), static_cast<std::streamsize>(pages));
+    if (!out) {
+        throw std::runtime_error("Cannot write " + path);
+    }
+}
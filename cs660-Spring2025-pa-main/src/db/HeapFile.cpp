@@ -1,70 +1,770 @@
+#include <db/BTreeFile.hpp>
 #include <db/Database.hpp>
 #include <db/HeapFile.hpp>
 #include <db/HeapPage.hpp>
+#include <db/PaxPage.hpp>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <numeric>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
 
 using namespace db;
 
-HeapFile::HeapFile(const std::string &name, const TupleDesc &td) : DbFile(name, td) {}
+/// The unit of the free space of a slotted page in the FreeSpaceMap, in bytes.
+static constexpr size_t FSM_UNIT = 16;
+
+HeapFile::HeapFile(const std::string &name, const TupleDesc &td, const DbFileOptions &options)
+        : DbFile(name, td, options), format(options.format), fsm(numPages) {
+    if (isMapped()) {
+        return;
+    }
+    // A new file may be given the stale map of a deleted file with the same name
+    if (std::filesystem::file_size(name) == 0 || !fsm.load(name + ".fsm", numPages)) {
+        // The free space of the pages is unknown until they are modified: only the last page is tried for inserts
+        fsm.set(numPages - 1, UINT8_MAX);
+        fsm_complete = std::filesystem::file_size(name) == 0;
+    }
+}
+
+HeapFile::~HeapFile() {
+    if (isMapped()) {
+        return;
+    }
+    try {
+        std::lock_guard lock(fsm_latch);
+        fsm.save(name + ".fsm");
+    } catch (const std::exception &) {
+        // The map is only a hint: without it, free space in earlier pages is not reused until they are modified
+    }
+}
+
+uint8_t HeapFile::freeSpace(const Page &page) const {
+    size_t free = format == PageFormat::SLOTTED ? SlottedPage(page, td).freeSpace() / FSM_UNIT
+                                                : HeapPage(page, td).freeSlots();
+    return std::min<size_t>(free, UINT8_MAX);
+}
+
+void HeapFile::updateFreeSpace(size_t page, uint8_t free) {
+    std::lock_guard lock(fsm_latch);
+    fsm.set(page, free);
+}
+
+PageFormat HeapFile::getFormat() const { return format; }
+
+/**
+ * Calls `f` with the page wrapped in the heap page class of the format.
+ */
+template<typename P, typename F>
+static auto withHeapPage(PageFormat format, P &page, const TupleDesc &td, F &&f) {
+    if (format == PageFormat::SLOTTED) {
+        return f(SlottedPage(page, td));
+    }
+    return f(HeapPage(page, td));
+}
+
+SlottedPage::Overflow HeapFile::writeOverflow(const std::string &s) {
+    BufferPool &bufferPool = getDatabase().getBufferPool();
+    size_t pages = (s.size() + SlottedPage::OVERFLOW_CAPACITY - 1) / SlottedPage::OVERFLOW_CAPACITY;
+    size_t first = numPages;
+    numPages += pages;
+    for (size_t i = 0; i < pages; i++) {
+        PageGuard p(bufferPool, {file_id, first + i});
+        std::unique_lock lock(p.latch());
+        std::string_view chunk = std::string_view(s).substr(i * SlottedPage::OVERFLOW_CAPACITY,
+                                                            SlottedPage::OVERFLOW_CAPACITY);
+        SlottedPage(*p, td).makeOverflow(chunk, i + 1 < pages ? first + i + 1 : 0);
+        p.markDirty();
+        updateFreeSpace(first + i, 0);
+    }
+    return {static_cast<uint32_t>(first), static_cast<uint32_t>(s.size())};
+}
+
+std::string HeapFile::readOverflow(const SlottedPage::Overflow &overflow) const {
+    std::string s;
+    s.reserve(overflow.length);
+    size_t page = overflow.page;
+    do {
+        PageView p = viewPage(page);
+        s += SlottedPage(*p, td).readOverflow(page);
+    } while (page != 0 && s.size() < overflow.length);
+    return s;
+}
+
+void HeapFile::freeOverflow(const SlottedPage::Overflow &overflow) {
+    BufferPool &bufferPool = getDatabase().getBufferPool();
+    size_t next = overflow.page;
+    do {
+        size_t page = next;
+        PageGuard p(bufferPool, {file_id, page});
+        std::unique_lock lock(p.latch());
+        SlottedPage(*p, td).readOverflow(next);
+        p->fill(0);
+        p.markDirty();
+        updateFreeSpace(page, freeSpace(*p));
+    } while (next != 0);
+}
 
 void HeapFile::insertTuple(const Tuple &t) {
     // TODO pa1
     if (!td.compatible(t)) {
         throw std::runtime_error("Tuple not compatible with TupleDesc");
     }
+    if (isMapped()) {
+        throw std::logic_error("Cannot insert into a memory-mapped file");
+    }
+    std::vector<std::pair<size_t, SlottedPage::Overflow>> overflows;
+    size_t page;
+    size_t slot;
+    try {
+        if (format == PageFormat::SLOTTED) {
+            for (size_t field: SlottedPage::outOfLine(td, t)) {
+                overflows.emplace_back(field, writeOverflow(std::get<std::string>(t.get_field(field))));
+            }
+        }
+        if (!insertFree(t, overflows, SIZE_MAX, page, slot)) {
+            page = numPages++;
+            free_hint = 0;
+            insertInto(page, t, overflows, slot);
+        }
+    } catch (...) {
+        // The overflow pages of a record that is not inserted (e.g. too large for a page) are freed
+        for (const auto &[field, overflow]: overflows) {
+            freeOverflow(overflow);
+        }
+        throw;
+    }
+    updateIndexes(t, page, slot, true);
+}
+
+bool HeapFile::insertInto(size_t page, const Tuple &t,
+                          const std::vector<std::pair<size_t, SlottedPage::Overflow>> &overflows, size_t &slot) {
+    PageGuard p(getDatabase().getBufferPool(), {file_id, page});
+    std::unique_lock lock(p.latch());
+    bool inserted;
+    if (format == PageFormat::SLOTTED) {
+        inserted = SlottedPage(*p, td).insertTuple(t, overflows, slot);
+    } else {
+        // The hint only applies to the last page
+        size_t hint = page == numPages - 1 ? free_hint.load() : 0;
+        inserted = format == PageFormat::PAX ? PaxPage(*p, td).insertTuple(t, hint)
+                                             : HeapPage(*p, td).insertTuple(t, hint);
+        // The hint is moved past the inserted tuple
+        if (inserted) {
+            slot = hint - 1;
+        }
+        if (page == numPages - 1) {
+            free_hint = hint;
+        }
+    }
+    if (inserted) {
+        p.markDirty();
+    }
+    updateFreeSpace(page, freeSpace(*p));
+    return inserted;
+}
+
+bool HeapFile::insertFree(const Tuple &t, const std::vector<std::pair<size_t, SlottedPage::Overflow>> &overflows,
+                          size_t limit, size_t &page, size_t &slot) {
+    uint8_t needed = 1;
+    if (format == PageFormat::SLOTTED) {
+        size_t size = SlottedPage::recordSize(td, t, overflows) + SlottedPage::SLOT_SIZE;
+        needed = std::min<size_t>((size + FSM_UNIT - 1) / FSM_UNIT, UINT8_MAX);
+    }
+    // A page with enough recorded space may not have it, but it is then updated and not chosen again
+    while (true) {
+        {
+            std::lock_guard lock(fsm_latch);
+            page = fsm.find(needed);
+        }
+        if (page == FreeSpaceMap::npos || page >= limit) {
+            return false;
+        }
+        if (insertInto(page, t, overflows, slot)) {
+            return true;
+        }
+    }
+}
+
+size_t HeapFile::vacuum(size_t pages) {
+    if (isMapped()) {
+        throw std::logic_error("Cannot vacuum a memory-mapped file");
+    }
+    bool complete;
+    {
+        std::lock_guard lock(fsm_latch);
+        complete = fsm_complete;
+    }
+    if (!complete) {
+        // The pages are read without holding the latch of the map, which is taken while pages are latched
+        for (size_t page = 0; page < numPages; page++) {
+            updateFreeSpace(page, freeSpace(*viewPage(page)));
+        }
+        std::lock_guard lock(fsm_latch);
+        fsm_complete = true;
+    }
+    size_t end = numPages;
+    while (end > 1 && numPages - end < pages) {
+        size_t last = end - 1;
+        // The live tuples of the last page, with their slot and the references to their overflow pages
+        std::vector<std::pair<size_t, Tuple>> tuples;
+        std::vector<std::vector<std::pair<size_t, SlottedPage::Overflow>>> overflows;
+        // The tuples with their strings stored in overflow pages, to update the indexes
+        std::vector<Tuple> resolved;
+        const bool has_indexes = indexed();
+        {
+            PageView p = viewPage(last);
+            if (format == PageFormat::SLOTTED) {
+                const SlottedPage sp(*p, td);
+                if (sp.isOverflow()) {
+                    break;
+                }
+                for (size_t slot = sp.begin(); slot != sp.end(); sp.next(slot)) {
+                    tuples.emplace_back(slot, sp.getTuple(slot));
+                    overflows.push_back(sp.overflows(slot));
+                    if (has_indexes) {
+                        resolved.push_back(overflows.back().empty() ? tuples.back().second : resolve(sp, slot));
+                    }
+                }
+            } else {
+                const HeapPage hp(*p, td);
+                const PaxPage pax(*p, td);
+                for (size_t slot = hp.begin(); slot != hp.end(); hp.next(slot)) {
+                    tuples.emplace_back(slot, format == PageFormat::PAX ? pax.getTuple(slot) : hp.getTuple(slot));
+                    overflows.emplace_back();
+                }
+            }
+        }
+        // The tuples are removed from the last page before they are inserted in other pages, so that a scan running
+        // meanwhile may miss a moved tuple, but never sees it twice
+        if (!tuples.empty()) {
+            PageGuard p(getDatabase().getBufferPool(), {file_id, last});
+            std::unique_lock lock(p.latch());
+            withHeapPage(format, *p, td, [&](auto &&hp) {
+                for (const auto &[slot, t]: tuples) {
+                    hp.deleteTuple(slot);
+                }
+            });
+            p.markDirty();
+            updateFreeSpace(last, freeSpace(*p));
+        }
+        // Slots of the last page may have been freed before the hint
+        free_hint = 0;
+        // The new page and slot of the tuples. The tuples that do not fit in other pages are put back in the last one.
+        std::vector<std::pair<size_t, size_t>> positions;
+        size_t page;
+        size_t slot;
+        while (positions.size() < tuples.size() &&
+               insertFree(tuples[positions.size()].second, overflows[positions.size()], last, page, slot)) {
+            positions.emplace_back(page, slot);
+        }
+        size_t moved = positions.size();
+        for (size_t i = moved; i < tuples.size(); i++) {
+            if (!insertInto(last, tuples[i].second, overflows[i], slot)) {
+                throw std::logic_error("Tuple does not fit back in its page");
+            }
+            positions.emplace_back(last, slot);
+        }
+        // All the old entries are removed first, since a tuple may take the old slot of another one
+        for (size_t pass = 0; pass < 2 && has_indexes; pass++) {
+            for (size_t i = 0; i < tuples.size(); i++) {
+                if (positions[i] == std::pair{last, tuples[i].first}) {
+                    continue;
+                }
+                const Tuple &t = format == PageFormat::SLOTTED ? resolved[i] : tuples[i].second;
+                if (pass == 0) {
+                    updateIndexes(t, last, tuples[i].first, false);
+                } else {
+                    updateIndexes(t, positions[i].first, positions[i].second, true);
+                }
+            }
+        }
+        if (moved != tuples.size()) {
+            break;
+        }
+        end = last;
+    }
+    size_t removed = numPages - end;
+    if (removed != 0) {
+        truncate(end);
+        std::lock_guard lock(fsm_latch);
+        fsm.truncate(end);
+    }
+    // Slots of the last page may have been freed before the hint
+    free_hint = 0;
+    return removed;
+}
+
+size_t HeapFile::batchStart() {
+    size_t last = numPages - 1;
+    bool empty;
+    {
+        PageView p = viewPage(last);
+        empty = freeSpace(*p) == freeSpace(Page{});
+    }
+    if (!empty) {
+        return numPages;
+    }
     BufferPool &bufferPool = getDatabase().getBufferPool();
-    PageId pid{name, 0};
-    pid.page = numPages - 1;
-    Page &p = bufferPool.getPage(pid);
-    HeapPage hp(p, td);
-    if (!hp.insertTuple(t)) {
-        numPages++;
-        pid.page++;
-        Page &np = bufferPool.getPage(pid);
-        HeapPage nhp(np, td);
-        nhp.insertTuple(t);
+    if (bufferPool.contains({file_id, last})) {
+        bufferPool.discardPage({file_id, last});
+    }
+    return last;
+}
+
+void HeapFile::writeBatch(const std::vector<Page> &pages, size_t count, size_t first) {
+    if (count == 0) {
+        return;
+    }
+    BufferPool &bufferPool = getDatabase().getBufferPool();
+    std::vector<std::pair<size_t, const Page *>> batch;
+    batch.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        // A page past the end of the file may have been read as zeros into the buffer pool
+        if (bufferPool.contains({file_id, first + i})) {
+            bufferPool.discardPage({file_id, first + i});
+        }
+        batch.emplace_back(first + i, &pages[i]);
+    }
+    writePages(batch);
+    std::lock_guard lock(fsm_latch);
+    for (size_t i = 0; i < count; i++) {
+        fsm.set(first + i, freeSpace(pages[i]));
+    }
+}
+
+void HeapFile::insertBatch(std::span<const Tuple> tuples) {
+    if (isMapped()) {
+        throw std::logic_error("Cannot insert into a memory-mapped file");
+    }
+    for (const Tuple &t: tuples) {
+        if (!td.compatible(t)) {
+            throw std::runtime_error("Tuple not compatible with TupleDesc");
+        }
+    }
+    if (tuples.empty()) {
+        return;
+    }
+    std::vector<Page> pages(BATCH_PAGES);
+    // pages[0] goes to page `next`; pages[0, filled) are full and pages[filled] is being filled if `open`
+    size_t next = batchStart();
+    const size_t start = next;
+    size_t filled = 0;
+    bool open = false;
+    size_t hint = 0;
+    auto flush = [&] {
+        size_t count = filled + open;
+        writeBatch(pages, count, next);
+        next += count;
+        numPages = std::max(numPages, next);
+        filled = 0;
+        open = false;
+    };
+    auto insert = [&](const Tuple &t) {
+        if (!open) {
+            pages[filled].fill(0);
+            hint = 0;
+            open = true;
+        }
+        if (format == PageFormat::SLOTTED) {
+            return SlottedPage(pages[filled], td).insertTuple(t);
+        }
+        if (format == PageFormat::PAX) {
+            return PaxPage(pages[filled], td).insertTuple(t, hint);
+        }
+        return HeapPage(pages[filled], td).insertTuple(t, hint);
+    };
+    for (const Tuple &t: tuples) {
+        if (format == PageFormat::SLOTTED && !SlottedPage::outOfLine(td, t).empty()) {
+            // Overflow pages are appended to the file, so the pages filled so far are written first
+            flush();
+            insertTuple(t);
+            next = numPages;
+            continue;
+        }
+        if (!insert(t)) {
+            open = false;
+            if (++filled == BATCH_PAGES) {
+                flush();
+            }
+            insert(t);
+        }
+    }
+    flush();
+    free_hint = 0;
+    if (indexed()) {
+        // Tuples inserted with insertTuple are already indexed, and their entries are replaced
+        forEachTuple(start, numPages, [&](const Tuple &t, size_t page, size_t slot) {
+            updateIndexes(t, page, slot, true);
+        });
+    }
+}
+
+void HeapFile::insertBatch(const uint8_t *data, size_t count) {
+    if (format == PageFormat::SLOTTED) {
+        // Slotted records are not laid out like serialized tuples
+        constexpr size_t CHUNK = 1 << 16;
+        std::vector<Tuple> tuples;
+        for (size_t i = 0; i < count; i += CHUNK) {
+            tuples.clear();
+            for (size_t j = i; j < std::min(count, i + CHUNK); j++) {
+                tuples.push_back(td.deserialize(data + j * td.length()));
+            }
+            insertBatch(tuples);
+        }
+        return;
+    }
+    if (isMapped()) {
+        throw std::logic_error("Cannot insert into a memory-mapped file");
+    }
+    if (count == 0) {
+        return;
+    }
+    std::vector<Page> pages(BATCH_PAGES);
+    size_t next = batchStart();
+    const size_t start = next;
+    while (count > 0) {
+        size_t filled = 0;
+        while (filled < BATCH_PAGES && count > 0) {
+            pages[filled].fill(0);
+            size_t n = format == PageFormat::PAX ? PaxPage(pages[filled], td).fill(data, count)
+                                                 : HeapPage(pages[filled], td).fill(data, count);
+            data += n * td.length();
+            count -= n;
+            filled++;
+        }
+        writeBatch(pages, filled, next);
+        next += filled;
+    }
+    numPages = next;
+    free_hint = 0;
+    if (indexed()) {
+        forEachTuple(start, numPages, [&](const Tuple &t, size_t page, size_t slot) {
+            updateIndexes(t, page, slot, true);
+        });
     }
-    bufferPool.markDirty(pid);
 }
 
 void HeapFile::deleteTuple(const Iterator &it) {
     // TODO pa1
-    BufferPool &bufferPool = getDatabase().getBufferPool();
-    PageId pid{name, it.page};
-    Page &p = bufferPool.getPage(pid);
-    HeapPage hp(p, td);
-    bufferPool.markDirty(pid);
-    hp.deleteTuple(it.slot);
+    if (isMapped()) {
+        throw std::logic_error("Cannot delete from a memory-mapped file");
+    }
+    if (indexed()) {
+        updateIndexes(getTuple(it), it.page, it.slot, false);
+    }
+    std::vector<std::pair<size_t, SlottedPage::Overflow>> overflows;
+    {
+        PageGuard p(getDatabase().getBufferPool(), {file_id, it.page});
+        std::unique_lock lock(p.latch());
+        if (format == PageFormat::SLOTTED) {
+            SlottedPage sp(*p, td);
+            overflows = sp.overflows(it.slot);
+            sp.deleteTuple(it.slot);
+        } else {
+            HeapPage hp(*p, td);
+            hp.deleteTuple(it.slot);
+            if (it.page == numPages - 1) {
+                // The freed slot is the first free slot of the last page if it is before the hint
+                size_t hint = free_hint;
+                while (it.slot < hint && !free_hint.compare_exchange_weak(hint, it.slot));
+            }
+        }
+        p.markDirty();
+        updateFreeSpace(it.page, freeSpace(*p));
+    }
+    for (const auto &[field, overflow]: overflows) {
+        freeOverflow(overflow);
+    }
+}
+
+Tuple HeapFile::indexEntry(const SecondaryIndex &index, const Tuple &t, size_t page, size_t slot) {
+    std::vector<field_t> fields;
+    fields.reserve(index.fields.size() + 2);
+    for (size_t field: index.fields) {
+        fields.push_back(t.get_field(field));
+    }
+    fields.emplace_back(static_cast<int>(page));
+    fields.emplace_back(static_cast<int>(slot));
+    return Tuple(std::move(fields));
+}
+
+bool HeapFile::indexed() const {
+    std::lock_guard lock(index_latch);
+    return !indexes.empty();
+}
+
+/**
+ * Find the entry of a tuple in an index.
+ */
+static Iterator findEntry(const SecondaryIndex &index, const Tuple &entry) {
+    std::vector<field_t> key;
+    for (size_t i = 0; i < entry.size(); i++) {
+        key.push_back(entry.get_field(i));
+    }
+    return index.file->find(key);
+}
+
+void HeapFile::updateIndexes(const Tuple &t, size_t page, size_t slot, bool insert) {
+    std::lock_guard lock(index_latch);
+    if (insert) {
+        size_t done = 0;
+        try {
+            for (; done < indexes.size(); done++) {
+                indexes[done].file->insertTuple(indexEntry(indexes[done], t, page, slot));
+            }
+        } catch (...) {
+            // The entries already added are removed, so that all the indexes still agree with the file
+            for (size_t i = 0; i < done; i++) {
+                Iterator it = findEntry(indexes[i], indexEntry(indexes[i], t, page, slot));
+                if (it != indexes[i].file->end()) {
+                    indexes[i].file->deleteTuple(it);
+                }
+            }
+            throw;
+        }
+        return;
+    }
+    // All the entries are found before any is removed
+    std::vector<Iterator> entries;
+    for (const SecondaryIndex &index: indexes) {
+        entries.push_back(findEntry(index, indexEntry(index, t, page, slot)));
+        if (entries.back() == index.file->end()) {
+            throw std::logic_error("Tuple not in index");
+        }
+    }
+    for (size_t i = 0; i < indexes.size(); i++) {
+        indexes[i].file->deleteTuple(entries[i]);
+    }
+}
+
+void HeapFile::forEachTuple(size_t first, size_t last,
+                            const std::function<void(const Tuple &, size_t, size_t)> &f) const {
+    std::vector<size_t> slots;
+    for (size_t page = first; page < last; page++) {
+        slots.clear();
+        {
+            PageView p = viewPage(page);
+            withHeapPage(format, *p, td, [&](auto &&hp) {
+                for (size_t slot = hp.begin(); slot != hp.end(); hp.next(slot)) {
+                    slots.push_back(slot);
+                }
+            });
+        }
+        for (size_t slot: slots) {
+            f(getTuple({*this, page, slot}), page, slot);
+        }
+    }
+}
+
+BTreeFile &HeapFile::createIndex(const std::string &name, const std::vector<std::string> &fields,
+                                 const DbFileOptions &options) {
+    if (isMapped()) {
+        throw std::logic_error("Cannot index a memory-mapped file");
+    }
+    // An open file with the same name has the same id: loading the index would overwrite its pages
+    if (getDatabase().contains(name)) {
+        throw std::logic_error("File already exists");
+    }
+    SecondaryIndex index;
+    std::vector<type_t> types;
+    std::vector<std::string> names;
+    for (const std::string &field: fields) {
+        index.fields.push_back(td.index_of(field));
+        types.push_back(td.field_type(index.fields.back()));
+        names.push_back("key" + std::to_string(names.size()));
+    }
+    types.insert(types.end(), {type_t::INT, type_t::INT});
+    names.insert(names.end(), {"page", "slot"});
+    std::vector<size_t> key_fields(types.size());
+    std::iota(key_fields.begin(), key_fields.end(), 0);
+    TupleDesc index_td(types, names);
+    auto file = std::make_unique<BTreeFile>(name, index_td, key_fields, options);
+
+    // Holding the latch, so that no tuple is inserted or deleted until the index is maintained
+    std::lock_guard lock(index_latch);
+    std::vector<uint8_t> entries;
+    size_t count = 0;
+    forEachTuple(0, numPages, [&](const Tuple &t, size_t page, size_t slot) {
+        entries.resize(entries.size() + index_td.length());
+        index_td.serialize(entries.data() + entries.size() - index_td.length(), indexEntry(index, t, page, slot));
+        count++;
+    });
+    file->bulkLoad(entries.data(), count);
+    index.file = file.get();
+    getDatabase().add(std::move(file));
+    indexes.push_back(std::move(index));
+    return *indexes.back().file;
+}
+
+void HeapFile::dropIndex(const std::string &name) {
+    std::lock_guard lock(index_latch);
+    auto it = std::find_if(indexes.begin(), indexes.end(), [&](const SecondaryIndex &index) {
+        return index.file->getName() == name;
+    });
+    if (it == indexes.end()) {
+        throw std::invalid_argument("Not an index of the file");
+    }
+    indexes.erase(it);
+}
+
+std::vector<SecondaryIndex> HeapFile::getIndexes() const {
+    std::lock_guard lock(index_latch);
+    return indexes;
+}
+
+Tuple HeapFile::resolve(const SlottedPage &page, size_t slot) const {
+    Tuple t = page.getTuple(slot);
+    std::vector<std::pair<size_t, SlottedPage::Overflow>> overflows = page.overflows(slot);
+    if (overflows.empty()) {
+        return t;
+    }
+    std::vector<field_t> fields;
+    for (size_t i = 0; i < t.size(); i++) {
+        fields.push_back(t.get_field(i));
+    }
+    for (const auto &[field, overflow]: overflows) {
+        fields[field] = readOverflow(overflow);
+    }
+    return Tuple(std::move(fields));
 }
 
 Tuple HeapFile::getTuple(const Iterator &it) const {
     // TODO pa1
-    BufferPool &bufferPool = getDatabase().getBufferPool();
-    PageId pid{name, it.page};
-    Page &p = bufferPool.getPage(pid);
-    HeapPage hp(p, td);
+    PageView p = viewPage(it.page);
+    if (format == PageFormat::SLOTTED) {
+        return resolve(SlottedPage(*p, td), it.slot);
+    }
+    if (format == PageFormat::PAX) {
+        return PaxPage(*p, td).getTuple(it.slot);
+    }
+    const HeapPage hp(*p, td);
     return hp.getTuple(it.slot);
 }
 
+/**
+ * Views the tuple in a slot of a page. The view does not pin the page if `p` does not.
+ */
+static TupleView viewTuple(PageFormat format, PageView p, const TupleDesc &td, size_t slot) {
+    if (format == PageFormat::PAX) {
+        const PaxPage pax(*p, td);
+        if (pax.empty(slot)) {
+            throw std::runtime_error("Slot not occupied");
+        }
+        const uint8_t *columns = pax.column(0);
+        size_t rows = pax.end();
+        return {std::move(p), td, columns, rows, slot};
+    }
+    if (format == PageFormat::SLOTTED) {
+        const uint8_t *data = SlottedPage(*p, td).tupleData(slot);
+        return {std::move(p), td, data, true};
+    }
+    const uint8_t *data = HeapPage(*p, td).tupleData(slot);
+    return {std::move(p), td, data};
+}
+
+TupleView HeapFile::view(const Iterator &it) const {
+    PageView p = viewPage(it.page);
+    if (format == PageFormat::SLOTTED && !SlottedPage(*p, td).overflows(it.slot).empty()) {
+        // The strings stored in overflow pages are not contiguous with the record
+        return {resolve(SlottedPage(*p, td), it.slot), td};
+    }
+    return viewTuple(format, std::move(p), td, it.slot);
+}
+
+void HeapFile::scan(const std::function<void(const TupleView &)> &f) const {
+    std::vector<size_t> fields(format == PageFormat::PAX ? td.size() : 0);
+    std::iota(fields.begin(), fields.end(), 0);
+    scan(fields, f);
+}
+
+void HeapFile::scan(const std::vector<size_t> &fields, const std::function<void(const TupleView &)> &f) const {
+    adviseSequential();
+    size_t length = 0;
+    size_t end = 0;
+    for (size_t page = 0; page < numPages; page++) {
+        readAhead(page, length, end);
+        // The page is copied and released before calling f, which may scan or modify other files, or this file
+        // again (e.g. in a self-join): the views borrow the copy
+        Page copy;
+        {
+            PageView p = viewPage(page);
+            if (format == PageFormat::PAX) {
+                // Only the header and the occupied rows of the minipages of the fields are copied, at their offsets
+                const PaxPage pax(*p, td);
+                size_t rows = 0;
+                for (size_t slot = pax.begin(); slot != pax.end(); pax.next(slot)) {
+                    rows = slot + 1;
+                }
+                std::memcpy(copy.data(), p->data(), (pax.end() + 7) / 8);
+                for (size_t field: fields) {
+                    size_t offset = pax.column(field) - p->data();
+                    std::memcpy(copy.data() + offset, p->data() + offset, rows * td.field_length(field));
+                }
+            } else {
+                copy = *p;
+            }
+        }
+        withHeapPage(format, std::as_const(copy), td, [&](auto &&hp) {
+            for (size_t slot = hp.begin(); slot != hp.end(); hp.next(slot)) {
+                if constexpr (std::is_same_v<std::decay_t<decltype(hp)>, SlottedPage>) {
+                    if (!hp.overflows(slot).empty()) {
+                        f(TupleView(resolve(hp, slot), td));
+                        continue;
+                    }
+                }
+                f(viewTuple(format, PageView(copy), td, slot));
+            }
+        });
+    }
+}
+
+/**
+ * Moves the slot to the first occupied slot of the page at or after `slot` (exclusive if `advance`).
+ * @return true if an occupied slot was found.
+ */
+static bool seek(PageFormat format, const PageView &p, const TupleDesc &td, size_t &slot, bool advance) {
+    return withHeapPage(format, *p, td, [&](auto &&hp) {
+        if (advance) {
+            hp.next(slot);
+        } else {
+            slot = hp.begin();
+        }
+        return slot != hp.end();
+    });
+}
+
+void HeapFile::readAhead(size_t page, size_t &length, size_t &end) const {
+    if (length++ < READAHEAD_TRIGGER) {
+        return;
+    }
+    // Read the next batch when the scan is halfway through the pages read ahead
+    BufferPool &bufferPool = getDatabase().getBufferPool();
+    size_t window = std::min(READAHEAD_PAGES, std::max<size_t>(1, bufferPool.capacity() / 4));
+    size_t first = std::max(page + 1, end);
+    if (first > page + window / 2 + 1) {
+        return;
+    }
+    size_t last = std::min(numPages, page + 1 + window);
+    if (first < last) {
+        end = last;
+        adviseWillNeed(first, last - first);
+    }
+}
+
 void HeapFile::next(Iterator &it) const {
     // TODO pa1
-    BufferPool &bufferPool = getDatabase().getBufferPool();
     if (it.page < numPages) {
-        PageId pid{name, it.page};
-        Page &p = bufferPool.getPage(pid);
-        const HeapPage hp(p, td);
-        hp.next(it.slot);
-        if (it.slot != hp.end()) {
+        if (seek(format, viewPage(it.page), td, it.slot, true)) {
             return;
         }
         it.page++;
     }
     while (it.page < numPages) {
-        PageId pid{name, it.page};
-        Page &p = bufferPool.getPage(pid);
-        const HeapPage hp(p, td);
-        it.slot = hp.begin();
-        if (it.slot != hp.end()) {
+        readAhead(it.page, it.scan_length, it.readahead_end);
+        if (seek(format, viewPage(it.page), td, it.slot, false)) {
             return;
         }
         it.page++;
@@ -74,15 +774,19 @@ void HeapFile::next(Iterator &it) const {
 
 Iterator HeapFile::begin() const {
     // TODO pa1
-    BufferPool &bufferPool = getDatabase().getBufferPool();
+    adviseSequential();
+    size_t length = 0;
+    size_t end = 0;
     size_t page = 0;
     while (page < numPages) {
-        PageId pid{name, page};
-        Page &p = bufferPool.getPage(pid);
-        const HeapPage hp(p, td);
-        size_t slot = hp.begin();
-        if (slot != hp.end())
-            return {*this, page, slot};
+        readAhead(page, length, end);
+        size_t slot;
+        if (seek(format, viewPage(page), td, slot, false)) {
+            Iterator it(*this, page, slot);
+            it.scan_length = length;
+            it.readahead_end = end;
+            return it;
+        }
         page++;
     }
     return {*this, numPages, 0};
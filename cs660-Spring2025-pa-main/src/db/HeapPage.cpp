@@ -1,5 +1,8 @@
 #include <db/Database.hpp>
 #include <db/HeapPage.hpp>
+#include <algorithm>
+#include <bit>
+#include <cstring>
 #include <stdexcept>
 
 using namespace db;
@@ -12,16 +15,42 @@ HeapPage::HeapPage(Page &page, const TupleDesc &td) : td(td) {
     data = header + DEFAULT_PAGE_SIZE - td.length() * capacity;
 }
 
-size_t HeapPage::begin() const {
-    // TODO pa1
-    for (size_t i = 0; i < capacity; i++) {
-        if (!empty(i)) {
-            return i;
+HeapPage::HeapPage(const Page &page, const TupleDesc &td) : HeapPage(const_cast<Page &>(page), td) {}
+
+uint64_t HeapPage::word(size_t i) const {
+    // Slot s is bit 7 - s % 8 of byte s / 8, so the bytes of the header form a big-endian bit string
+    size_t first = i * 8;
+    uint64_t word = 0;
+    std::memcpy(&word, header + first, std::min<size_t>(8, (capacity + 7) / 8 - first));
+    if constexpr (std::endian::native == std::endian::little) {
+        word = __builtin_bswap64(word);
+    }
+    return word;
+}
+
+size_t HeapPage::find(size_t slot, bool occupied) const {
+    while (slot < capacity) {
+        size_t i = slot / 64;
+        size_t slots = capacity - i * 64;
+        uint64_t bits = occupied ? word(i) : ~word(i);
+        // Ignore the slots before `slot` and the padding bits after the last slot
+        bits &= ~uint64_t{0} >> slot % 64;
+        if (slots < 64) {
+            bits &= ~(~uint64_t{0} >> slots);
         }
+        if (bits != 0) {
+            return i * 64 + std::countl_zero(bits);
+        }
+        slot = (i + 1) * 64;
     }
     return capacity;
 }
 
+size_t HeapPage::begin() const {
+    // TODO pa1
+    return find(0, true);
+}
+
 size_t HeapPage::end() const {
     // TODO pa1
     return capacity;
@@ -29,19 +58,62 @@ size_t HeapPage::end() const {
 
 bool HeapPage::insertTuple(const Tuple &t) {
     // TODO pa1
-    size_t slot = 0;
-    while (slot < capacity && (header[slot / 8] & (1 << (7 - slot % 8)))) {
-        slot++;
+    size_t hint = 0;
+    return insertTuple(t, hint);
+}
+
+size_t HeapPage::allocate(size_t &hint) {
+    size_t slot = find(hint, false);
+    if (slot == capacity) {
+        hint = capacity;
+        return capacity;
     }
+    header[slot / 8] |= 1 << (7 - slot % 8);
+    hint = slot + 1;
+    return slot;
+}
+
+size_t HeapPage::occupy(size_t count) {
+    if (begin() != end()) {
+        throw std::logic_error("Page is not empty");
+    }
+    size_t n = std::min(count, capacity);
+    std::memset(header, 0xff, n / 8);
+    if (n % 8 != 0) {
+        header[n / 8] = static_cast<uint8_t>(0xff << (8 - n % 8));
+    }
+    return n;
+}
+
+bool HeapPage::insertTuple(const Tuple &t, size_t &hint) {
+    size_t slot = allocate(hint);
     if (slot == capacity) {
         return false;
     }
-    header[slot / 8] |= 1 << (7 - slot % 8);
     uint8_t *slotData = data + slot * td.length();
     td.serialize(slotData, t);
     return true;
 }
 
+size_t HeapPage::fill(const uint8_t *tuples, size_t count) {
+    size_t n = occupy(count);
+    std::memcpy(data, tuples, n * td.length());
+    return n;
+}
+
+size_t HeapPage::freeSlots() const {
+    size_t occupied = 0;
+    for (size_t i = 0; i * 64 < capacity; i++) {
+        uint64_t bits = word(i);
+        size_t slots = capacity - i * 64;
+        if (slots < 64) {
+            bits &= ~(~uint64_t{0} >> slots);
+        }
+        occupied += std::popcount(bits);
+    }
+    return capacity - occupied;
+}
+
 void HeapPage::deleteTuple(size_t slot) {
     // TODO pa1
     if (slot >= capacity) {
@@ -55,16 +127,19 @@ void HeapPage::deleteTuple(size_t slot) {
 
 Tuple HeapPage::getTuple(size_t slot) const {
     // TODO pa1
+    return td.deserialize(tupleData(slot));
+}
+
+const uint8_t *HeapPage::tupleData(size_t slot) const {
     if (empty(slot)) {
         throw std::runtime_error("Slot not occupied");
     }
-    uint8_t *slotData = data + slot * td.length();
-    return td.deserialize(slotData);
+    return data + slot * td.length();
 }
 
 void HeapPage::next(size_t &slot) const {
     // TODO pa1
-    while (++slot < capacity && empty(slot));
+    slot = find(slot + 1, true);
 }
 
 bool HeapPage::empty(size_t slot) const {
@@ -1,35 +1,121 @@
 #include <db/IndexPage.hpp>
+#include <algorithm>
+#include <cstring>
+#include <vector>
 #include <stdexcept>
 
 using namespace db;
 
-IndexPage::IndexPage(Page &page) {
+IndexPage::IndexPage(Page &page, size_t key_size) : key_size(key_size) {
     // TODO pa2
-    capacity = (DEFAULT_PAGE_SIZE - sizeof(IndexPageHeader) - sizeof(int)) / (sizeof(int) + sizeof(size_t));
+    // Keys are followed by the children, aligned for size_t; each array has room for one more entry than the capacity
+    auto childrenOffset = [&](size_t capacity) {
+        size_t keys_end = sizeof(IndexPageHeader) + (capacity + 1) * key_size;
+        return (keys_end + alignof(size_t) - 1) / alignof(size_t) * alignof(size_t);
+    };
+    size_t n = (DEFAULT_PAGE_SIZE - sizeof(IndexPageHeader)) / (key_size + sizeof(size_t)) - 1;
+    while (childrenOffset(n) + (n + 1) * sizeof(size_t) > DEFAULT_PAGE_SIZE) {
+        n--;
+    }
+    capacity = n;
     header = reinterpret_cast<IndexPageHeader *>(page.data());
-    keys = reinterpret_cast<int *>(header + 1);
-    children = reinterpret_cast<size_t *>(keys + capacity + 1);
+    key_data = page.data() + sizeof(IndexPageHeader);
+    keys = reinterpret_cast<int *>(key_data);
+    children = reinterpret_cast<size_t *>(page.data() + childrenOffset(capacity));
+}
+
+IndexPage::IndexPage(const Page &page, size_t key_size) : IndexPage(const_cast<Page &>(page), key_size) {}
+
+size_t IndexPage::search(const uint8_t *key) const {
+    size_t lo = 0;
+    size_t hi = header->size;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (std::memcmp(key, this->key(mid), key_size) < 0) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return lo;
+}
+
+void IndexPage::insertAt(size_t pos, const uint8_t *key, size_t child) {
+    std::memmove(key_data + (pos + 1) * key_size, key_data + pos * key_size, (header->size - pos) * key_size);
+    std::move_backward(children + pos + 1, children + header->size + 1, children + header->size + 2);
+    std::memcpy(key_data + pos * key_size, key, key_size);
+    children[pos + 1] = child;
+    ++header->size;
 }
 
 bool IndexPage::insert(int key, size_t child) {
     // TODO pa2
     auto it = std::lower_bound(keys, keys + header->size, key);
-    auto slot = it - keys;
-    std::move_backward(keys + slot, keys + header->size, keys + header->size + 1);
-    std::move_backward(children + slot + 1, children + header->size + 1, children + header->size + 2);
-    keys[slot] = key;
-    children[slot + 1] = child;
-    ++header->size;
+    insertAt(it - keys, reinterpret_cast<const uint8_t *>(&key), child);
+    return header->size == capacity;
+}
+
+bool IndexPage::insert(const uint8_t *key, size_t child) {
+    size_t lo = 0;
+    size_t hi = header->size;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (std::memcmp(this->key(mid), key, key_size) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    insertAt(lo, key, child);
     return header->size == capacity;
 }
 
+void IndexPage::erase(size_t pos) {
+    std::memmove(key_data + pos * key_size, key_data + (pos + 1) * key_size, (header->size - pos - 1) * key_size);
+    std::copy(children + pos + 2, children + header->size + 1, children + pos + 1);
+    --header->size;
+}
+
+void IndexPage::merge(IndexPage &right, const uint8_t *separator) {
+    std::memcpy(key_data + header->size * key_size, separator, key_size);
+    std::memcpy(key_data + (header->size + 1) * key_size, right.key_data, right.header->size * key_size);
+    std::copy(right.children, right.children + right.header->size + 1, children + header->size + 1);
+    header->size += right.header->size + 1;
+    right.header->size = 0;
+}
+
+void IndexPage::redistribute(IndexPage &right, const uint8_t *separator, uint8_t *new_separator) {
+    // Lay the keys (with the separator between them) and the children of the two pages out in order, and split them
+    std::vector<uint8_t> all_keys(key_data, key_data + header->size * key_size);
+    all_keys.insert(all_keys.end(), separator, separator + key_size);
+    all_keys.insert(all_keys.end(), right.key_data, right.key_data + right.header->size * key_size);
+    std::vector<size_t> all_children(children, children + header->size + 1);
+    all_children.insert(all_children.end(), right.children, right.children + right.header->size + 1);
+
+    size_t count = all_keys.size() / key_size;
+    size_t half = (count - 1) / 2;
+    std::memcpy(key_data, all_keys.data(), half * key_size);
+    std::copy(all_children.begin(), all_children.begin() + half + 1, children);
+    header->size = half;
+    std::memcpy(new_separator, all_keys.data() + half * key_size, key_size);
+    std::memcpy(right.key_data, all_keys.data() + (half + 1) * key_size, (count - half - 1) * key_size);
+    std::copy(all_children.begin() + half + 1, all_children.end(), right.children);
+    right.header->size = count - half - 1;
+}
+
 int IndexPage::split(IndexPage &new_page) {
     // TODO pa2
+    int key;
+    split(new_page, reinterpret_cast<uint8_t *>(&key));
+    return key;
+}
+
+void IndexPage::split(IndexPage &new_page, uint8_t *separator) {
     size_t half = header->size / 2;
     new_page.header->size = header->size - half - 1;
     new_page.header->index_children = header->index_children;
-    std::copy(keys + half + 1, keys + header->size, new_page.keys);
+    std::memcpy(new_page.key_data, key_data + (half + 1) * key_size, new_page.header->size * key_size);
     std::copy(children + half + 1, children + header->size + 1, new_page.children);
+    std::memcpy(separator, key_data + half * key_size, key_size);
     header->size = half;
-    return keys[half];
 }
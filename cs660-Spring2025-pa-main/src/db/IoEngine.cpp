@@ -0,0 +1,300 @@
+#include <db/IoEngine.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+using namespace db;
+
+namespace {
+    std::runtime_error ioError(const char *call, int error) {
+        return std::runtime_error(std::string(call) + ": " + std::strerror(error));
+    }
+
+    /// Transfers a run of buffers that are adjacent in the file, resuming short transfers.
+    void transfer(int fd, std::vector<iovec> iov, off_t offset, bool write) {
+        size_t i = 0;
+        while (i < iov.size()) {
+            int count = static_cast<int>(std::min<size_t>(IOV_MAX, iov.size() - i));
+            ssize_t n = write ? pwritev(fd, &iov[i], count, offset) : preadv(fd, &iov[i], count, offset);
+            if (n == -1) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw ioError(write ? "pwritev" : "preadv", errno);
+            }
+            if (n == 0) {
+                if (write) {
+                    throw std::runtime_error("pwritev: no progress");
+                }
+                // End of file: the missing pages read as zeros
+                for (; i < iov.size(); i++) {
+                    std::memset(iov[i].iov_base, 0, iov[i].iov_len);
+                }
+                break;
+            }
+            offset += n;
+            for (size_t left = n; left > 0;) {
+                size_t step = std::min(left, iov[i].iov_len);
+                iov[i].iov_base = static_cast<uint8_t *>(iov[i].iov_base) + step;
+                iov[i].iov_len -= step;
+                left -= step;
+                if (iov[i].iov_len == 0) {
+                    i++;
+                }
+            }
+        }
+    }
+
+    /// An io_uring instance with its submission and completion queues mapped into memory.
+    class Ring {
+        int fd;
+        unsigned entries;
+
+        void *sq_ring;
+        size_t sq_ring_size;
+        void *cq_ring;
+        size_t cq_ring_size;
+        io_uring_sqe *sqes;
+        size_t sqes_size;
+
+        unsigned *sq_tail;
+        unsigned sq_mask;
+        unsigned *sq_array;
+        unsigned *cq_head;
+        unsigned *cq_tail;
+        unsigned cq_mask;
+        io_uring_cqe *cqes;
+
+        template<typename T>
+        static T *at(void *ring, size_t offset) {
+            return reinterpret_cast<T *>(static_cast<uint8_t *>(ring) + offset);
+        }
+
+    public:
+        explicit Ring(unsigned depth) {
+            io_uring_params params{};
+            fd = static_cast<int>(syscall(__NR_io_uring_setup, depth, &params));
+            if (fd == -1) {
+                throw ioError("io_uring_setup", errno);
+            }
+            entries = params.sq_entries;
+            sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+            if (single) {
+                sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+            }
+            sq_ring = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                           IORING_OFF_SQ_RING);
+            if (sq_ring == MAP_FAILED) {
+                int error = errno;
+                close(fd);
+                throw ioError("mmap", error);
+            }
+            cq_ring = single ? sq_ring : mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                              fd, IORING_OFF_CQ_RING);
+            if (cq_ring == MAP_FAILED) {
+                int error = errno;
+                munmap(sq_ring, sq_ring_size);
+                close(fd);
+                throw ioError("mmap", error);
+            }
+            sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+            void *sqes_map = mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                                  IORING_OFF_SQES);
+            if (sqes_map == MAP_FAILED) {
+                int error = errno;
+                if (cq_ring != sq_ring) {
+                    munmap(cq_ring, cq_ring_size);
+                }
+                munmap(sq_ring, sq_ring_size);
+                close(fd);
+                throw ioError("mmap", error);
+            }
+            sqes = static_cast<io_uring_sqe *>(sqes_map);
+
+            sq_tail = at<unsigned>(sq_ring, params.sq_off.tail);
+            sq_mask = *at<unsigned>(sq_ring, params.sq_off.ring_mask);
+            sq_array = at<unsigned>(sq_ring, params.sq_off.array);
+            cq_head = at<unsigned>(cq_ring, params.cq_off.head);
+            cq_tail = at<unsigned>(cq_ring, params.cq_off.tail);
+            cq_mask = *at<unsigned>(cq_ring, params.cq_off.ring_mask);
+            cqes = at<io_uring_cqe>(cq_ring, params.cq_off.cqes);
+        }
+
+        Ring(const Ring &) = delete;
+
+        Ring &operator=(const Ring &) = delete;
+
+        ~Ring() {
+            munmap(sqes, sqes_size);
+            if (cq_ring != sq_ring) {
+                munmap(cq_ring, cq_ring_size);
+            }
+            munmap(sq_ring, sq_ring_size);
+            close(fd);
+        }
+
+        unsigned capacity() const { return entries; }
+
+        /// Queues a vectored read or write. The caller keeps the number of queued requests below the capacity.
+        void prepare(int file, const iovec *iov, off_t offset, bool write, uint64_t user_data) {
+            unsigned tail = *sq_tail;
+            unsigned index = tail & sq_mask;
+            io_uring_sqe &sqe = sqes[index];
+            std::memset(&sqe, 0, sizeof(sqe));
+            sqe.opcode = write ? IORING_OP_WRITEV : IORING_OP_READV;
+            sqe.fd = file;
+            sqe.addr = reinterpret_cast<uint64_t>(iov);
+            sqe.len = 1;
+            sqe.off = offset;
+            sqe.user_data = user_data;
+            sq_array[index] = index;
+            __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+        }
+
+        /// Submits the queued requests and waits until at least one completion is available.
+        void enter(unsigned to_submit) {
+            while (true) {
+                long n = syscall(__NR_io_uring_enter, fd, to_submit, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+                if (n >= 0) {
+                    to_submit -= static_cast<unsigned>(n);
+                    if (to_submit == 0) {
+                        return;
+                    }
+                } else if (errno != EINTR) {
+                    throw ioError("io_uring_enter", errno);
+                }
+            }
+        }
+
+        /// Calls `handle(user_data, res)` for every available completion.
+        template<typename F>
+        void reap(F &&handle) {
+            unsigned head = *cq_head;
+            unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+            for (; head != tail; head++) {
+                const io_uring_cqe &cqe = cqes[head & cq_mask];
+                handle(cqe.user_data, cqe.res);
+            }
+            __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+        }
+    };
+
+    /// Each thread submits to its own ring, so batches of different threads never wait for each other.
+    Ring *threadRing() {
+        thread_local std::unique_ptr<Ring> ring;
+        thread_local bool failed = false;
+        if (!ring && !failed) {
+            try {
+                ring = std::make_unique<Ring>(UringIoEngine::QUEUE_DEPTH);
+            } catch (const std::runtime_error &) {
+                failed = true;
+            }
+        }
+        return ring.get();
+    }
+} // namespace
+
+IoEngineType SyncIoEngine::type() const { return IoEngineType::SYNC; }
+
+void SyncIoEngine::submit(const std::vector<IoRequest> &requests) {
+    // Merge requests that are adjacent in the same file into a single vectored call
+    size_t first = 0;
+    while (first < requests.size()) {
+        const IoRequest &head = requests[first];
+        std::vector<iovec> iov{{head.buf, head.length}};
+        off_t end = head.offset + static_cast<off_t>(head.length);
+        size_t last = first + 1;
+        while (last < requests.size() && requests[last].fd == head.fd && requests[last].write == head.write &&
+               requests[last].offset == end) {
+            iov.push_back({requests[last].buf, requests[last].length});
+            end += static_cast<off_t>(requests[last].length);
+            last++;
+        }
+        transfer(head.fd, std::move(iov), head.offset, head.write);
+        first = last;
+    }
+}
+
+bool UringIoEngine::supported() { return threadRing() != nullptr; }
+
+IoEngineType UringIoEngine::type() const { return IoEngineType::IO_URING; }
+
+void UringIoEngine::submit(const std::vector<IoRequest> &requests) {
+    Ring *ring = threadRing();
+    if (ring == nullptr) {
+        SyncIoEngine().submit(requests);
+        return;
+    }
+
+    // The part of each request that has not been transferred yet
+    std::vector<IoRequest> remaining(requests);
+    std::vector<iovec> iov(requests.size());
+    std::deque<size_t> pending;
+    for (size_t i = 0; i < requests.size(); i++) {
+        if (requests[i].length != 0) {
+            pending.push_back(i);
+        }
+    }
+
+    unsigned in_flight = 0;
+    int error = 0;
+    const char *failed = nullptr;
+    while (!pending.empty() || in_flight != 0) {
+        unsigned queued = 0;
+        while (!pending.empty() && in_flight + queued < ring->capacity()) {
+            size_t i = pending.front();
+            pending.pop_front();
+            iov[i] = {remaining[i].buf, remaining[i].length};
+            ring->prepare(remaining[i].fd, &iov[i], remaining[i].offset, remaining[i].write, i);
+            queued++;
+        }
+        in_flight += queued;
+        ring->enter(queued);
+        ring->reap([&](uint64_t i, int res) {
+            in_flight--;
+            IoRequest &request = remaining[i];
+            if (res == -EINTR || res == -EAGAIN) {
+                pending.push_back(i);
+            } else if (res < 0) {
+                error = -res;
+                failed = request.write ? "pwritev" : "preadv";
+            } else if (res == 0) {
+                if (request.write) {
+                    error = EIO;
+                    failed = "pwritev";
+                } else {
+                    // End of file: the rest of the page reads as zeros
+                    std::memset(request.buf, 0, request.length);
+                }
+            } else {
+                request.buf += res;
+                request.length -= res;
+                request.offset += res;
+                if (request.length != 0) {
+                    pending.push_back(i);
+                }
+            }
+        });
+    }
+    if (failed != nullptr) {
+        throw ioError(failed, error);
+    }
+}
+
+std::unique_ptr<IoEngine> db::makeIoEngine(IoEngineType type) {
+    if (type == IoEngineType::IO_URING && UringIoEngine::supported()) {
+        return std::make_unique<UringIoEngine>();
+    }
+    return std::make_unique<SyncIoEngine>();
+}
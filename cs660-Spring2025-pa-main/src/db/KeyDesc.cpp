@@ -0,0 +1,139 @@
+#include <db/KeyDesc.hpp>
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+using namespace db;
+
+namespace {
+    size_t keySize(type_t type) {
+        switch (type) {
+            case type_t::INT:
+                return INT_SIZE;
+            case type_t::DOUBLE:
+                return DOUBLE_SIZE;
+            case type_t::CHAR:
+                return CHAR_SIZE;
+        }
+        throw std::logic_error("Unknown field type");
+    }
+
+    void storeBigEndian(uint8_t *key, uint32_t bits) {
+        if constexpr (std::endian::native == std::endian::little) {
+            bits = __builtin_bswap32(bits);
+        }
+        std::memcpy(key, &bits, sizeof(bits));
+    }
+
+    void storeBigEndian(uint8_t *key, uint64_t bits) {
+        if constexpr (std::endian::native == std::endian::little) {
+            bits = __builtin_bswap64(bits);
+        }
+        std::memcpy(key, &bits, sizeof(bits));
+    }
+
+    void encodeInt(uint8_t *key, int value) {
+        storeBigEndian(key, static_cast<uint32_t>(value) ^ 0x80000000u);
+    }
+
+    void encodeDouble(uint8_t *key, double value) {
+        uint64_t bits = std::bit_cast<uint64_t>(value == 0 ? 0.0 : value);
+        bits = bits >> 63 ? ~bits : bits ^ uint64_t{1} << 63;
+        storeBigEndian(key, bits);
+    }
+
+    void encodeChar(uint8_t *key, const std::string &value) {
+        size_t n = std::min(value.size(), CHAR_SIZE);
+        std::memcpy(key, value.data(), n);
+        std::memset(key + n, 0, CHAR_SIZE - n);
+    }
+
+    /**
+     * Encodes a value of a key field, and returns the length of the encoded field.
+     */
+    size_t encodeField(uint8_t *key, type_t type, const field_t &value) {
+        switch (type) {
+            case type_t::INT:
+                if (!std::holds_alternative<int>(value)) {
+                    throw std::invalid_argument("Key value is not an INT");
+                }
+                encodeInt(key, std::get<int>(value));
+                return INT_SIZE;
+            case type_t::DOUBLE:
+                if (!std::holds_alternative<double>(value)) {
+                    throw std::invalid_argument("Key value is not a DOUBLE");
+                }
+                encodeDouble(key, std::get<double>(value));
+                return DOUBLE_SIZE;
+            case type_t::CHAR:
+                if (!std::holds_alternative<std::string>(value)) {
+                    throw std::invalid_argument("Key value is not a CHAR");
+                }
+                encodeChar(key, std::get<std::string>(value));
+                return CHAR_SIZE;
+        }
+        throw std::logic_error("Unknown field type");
+    }
+}
+
+KeyDesc::KeyDesc(const TupleDesc &td, std::vector<size_t> fields) : key_fields(std::move(fields)) {
+    if (key_fields.empty()) {
+        throw std::invalid_argument("Key without fields");
+    }
+    for (size_t field: key_fields) {
+        if (field >= td.size()) {
+            throw std::invalid_argument("Key field out of range");
+        }
+        types.push_back(td.field_type(field));
+        offsets.push_back(td.offset_of(field));
+        len += keySize(types.back());
+    }
+    if (len > MAX_KEY_SIZE) {
+        throw std::invalid_argument("Key too long");
+    }
+}
+
+void KeyDesc::encode(uint8_t *key, const uint8_t *tuple) const {
+    for (size_t i = 0; i < types.size(); i++) {
+        const uint8_t *field = tuple + offsets[i];
+        switch (types[i]) {
+            case type_t::INT: {
+                int value;
+                std::memcpy(&value, field, INT_SIZE);
+                encodeInt(key, value);
+                key += INT_SIZE;
+                break;
+            }
+            case type_t::DOUBLE: {
+                double value;
+                std::memcpy(&value, field, DOUBLE_SIZE);
+                encodeDouble(key, value);
+                key += DOUBLE_SIZE;
+                break;
+            }
+            case type_t::CHAR:
+                // Serialized CHAR fields are already padded with NULs
+                std::memcpy(key, field, CHAR_SIZE);
+                key += CHAR_SIZE;
+                break;
+        }
+    }
+}
+
+void KeyDesc::encode(uint8_t *key, const Tuple &t) const {
+    for (size_t i = 0; i < types.size(); i++) {
+        key += encodeField(key, types[i], t.get_field(key_fields[i]));
+    }
+}
+
+void KeyDesc::encode(uint8_t *key, const std::vector<field_t> &values, uint8_t pad) const {
+    if (values.size() > types.size()) {
+        throw std::invalid_argument("Too many key values");
+    }
+    const uint8_t *end = key + len;
+    for (size_t i = 0; i < values.size(); i++) {
+        key += encodeField(key, types[i], values[i]);
+    }
+    std::memset(key, pad, end - key);
+}
@@ -1,61 +1,43 @@
 #include <db/LeafPage.hpp>
+#include <algorithm>
+#include <cstring>
 #include <stdexcept>
 
 using namespace db;
 
-struct Iterator {
-    using iterator_category = std::contiguous_iterator_tag;
-    using difference_type = uint16_t;
-    using value_type = int;
-    using reference = int &;
-
-    const uint8_t *data;
-    size_t width;
-    uint16_t slot;
-
-    Iterator &operator++() {
-        ++slot;
-        return *this;
-    }
-
-    Iterator &operator--() {
-        --slot;
-        return *this;
-    }
-
-    Iterator &operator+=(uint16_t n) {
-        slot += n;
-        return *this;
-    }
-
-    Iterator &operator-=(uint16_t n) {
-        slot -= n;
-        return *this;
-    }
-
-    uint16_t operator-(const Iterator &other) const { return slot - other.slot; }
+LeafPage::LeafPage(Page &page, const TupleDesc &td, size_t key_index)
+        : td(td), key_index(key_index), owned_key(std::in_place, td, std::vector<size_t>{key_index}),
+          key_desc(&*owned_key) {
+    // TODO pa2
+    header = reinterpret_cast<LeafPageHeader *>(page.data());
+    capacity = (DEFAULT_PAGE_SIZE - sizeof(LeafPageHeader)) / td.length();
+    data = page.data() + DEFAULT_PAGE_SIZE - td.length() * capacity;
+}
 
-    int operator*() const { return *reinterpret_cast<const int *>(data + slot * width); }
-};
+LeafPage::LeafPage(const Page &page, const TupleDesc &td, size_t key_index)
+        : LeafPage(const_cast<Page &>(page), td, key_index) {}
 
-LeafPage::LeafPage(Page &page, const TupleDesc &td, size_t key_index) : td(td), key_index(key_index) {
-    // TODO pa2
+LeafPage::LeafPage(Page &page, const TupleDesc &td, const KeyDesc &key)
+        : td(td), key_index(key.fields()[0]), key_desc(&key) {
     header = reinterpret_cast<LeafPageHeader *>(page.data());
     capacity = (DEFAULT_PAGE_SIZE - sizeof(LeafPageHeader)) / td.length();
     data = page.data() + DEFAULT_PAGE_SIZE - td.length() * capacity;
 }
 
+LeafPage::LeafPage(const Page &page, const TupleDesc &td, const KeyDesc &key)
+        : LeafPage(const_cast<Page &>(page), td, key) {}
+
 bool LeafPage::insertTuple(const Tuple &t) {
     // TODO pa2
-    int key = std::get<int>(t.get_field(key_index));
-
-    const auto first = data + td.offset_of(key_index);
+    uint8_t key[MAX_KEY_SIZE];
+    uint8_t other[MAX_KEY_SIZE];
+    key_desc->encode(key, t);
     const auto width = td.length();
-    const auto last = first + header->size * width;
-
-    auto it = std::lower_bound(Iterator{first, width, 0}, Iterator{last, width, header->size}, key);
-    auto slot = it.slot;
-    if (slot >= header->size || key != *it) {
+    size_t slot = lowerBound(key);
+    if (slot < header->size) {
+        key_desc->encode(other, data + slot * width);
+    }
+    if (slot >= header->size || std::memcmp(key, other, key_desc->length()) != 0) {
         std::copy_backward(data + slot * width, data + header->size * width, data + (header->size + 1) * width);
         ++header->size;
     }
@@ -63,21 +45,97 @@ bool LeafPage::insertTuple(const Tuple &t) {
     return header->size == capacity;
 }
 
-int LeafPage::split(LeafPage &new_page) {
+size_t LeafPage::lowerBound(const uint8_t *key) const {
+    uint8_t probe[MAX_KEY_SIZE];
+    size_t lo = 0;
+    size_t hi = header->size;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        key_desc->encode(probe, data + mid * td.length());
+        if (std::memcmp(probe, key, key_desc->length()) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+size_t LeafPage::upperBound(const uint8_t *key) const {
+    uint8_t probe[MAX_KEY_SIZE];
+    size_t lo = 0;
+    size_t hi = header->size;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        key_desc->encode(probe, data + mid * td.length());
+        if (std::memcmp(key, probe, key_desc->length()) < 0) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return lo;
+}
+
+void LeafPage::key(size_t slot, uint8_t *key) const {
+    key_desc->encode(key, tupleData(slot));
+}
+
+void LeafPage::erase(size_t slot) {
+    if (slot >= header->size) {
+        throw std::out_of_range("slot out of range");
+    }
+    const auto width = td.length();
+    uint8_t *tuple = data + slot * width;
+    std::copy(tuple + width, data + header->size * width, tuple);
+    --header->size;
+}
+
+void LeafPage::merge(LeafPage &right) {
+    const auto width = td.length();
+    std::copy(right.data, right.data + right.header->size * width, data + header->size * width);
+    header->size += right.header->size;
+    header->next_leaf = right.header->next_leaf;
+    right.header->size = 0;
+}
+
+void LeafPage::redistribute(LeafPage &right) {
+    const auto width = td.length();
+    size_t total = header->size + right.header->size;
+    size_t half = total / 2;
+    if (header->size > half) {
+        // Move the last tuples of this page to the front of the next one
+        size_t n = header->size - half;
+        std::copy_backward(right.data, right.data + right.header->size * width,
+                           right.data + (right.header->size + n) * width);
+        std::copy(data + half * width, data + header->size * width, right.data);
+    } else {
+        // Move the first tuples of the next page to the end of this one
+        size_t n = half - header->size;
+        std::copy(right.data, right.data + n * width, data + header->size * width);
+        std::copy(right.data + n * width, right.data + right.header->size * width, right.data);
+    }
+    header->size = half;
+    right.header->size = total - half;
+}
+
+void LeafPage::split(LeafPage &new_page) {
     // TODO pa2
     size_t half = header->size / 2;
     new_page.header->size = header->size - half;
     new_page.header->next_leaf = header->next_leaf;
     std::copy(data + half * td.length(), data + header->size * td.length(), new_page.data);
     header->size = half;
-    return std::get<int>(td.deserialize(new_page.data).get_field(key_index));
-
 }
 
 Tuple LeafPage::getTuple(size_t slot) const {
     // TODO pa2
+    return td.deserialize(tupleData(slot));
+}
+
+const uint8_t *LeafPage::tupleData(size_t slot) const {
     if (slot >= header->size) {
         throw std::out_of_range("slot out of range");
     }
-    return td.deserialize(data + slot * td.length());
+    return data + slot * td.length();
 }
@@ -0,0 +1,92 @@
+#include <db/PageTable.hpp>
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+using namespace db;
+
+PageTable::PageTable(size_t capacity) : bits(std::bit_width(std::max<size_t>(capacity, 8) * 2 - 1)) {
+    slots = std::make_unique<Slot[]>(mask() + 1);
+    for (size_t i = 0; i <= mask(); i++) {
+        slots[i].pos = EMPTY;
+    }
+}
+
+size_t PageTable::home(const PageId &pid) const {
+    // The low bits of the hash select the partition of the buffer pool, so use the high bits here
+    return std::hash<const PageId>()(pid) >> (64 - bits);
+}
+
+size_t PageTable::probe(const PageId &pid) const {
+    size_t i = home(pid);
+    while (slots[i].pos != EMPTY && !(slots[i].pid == pid)) {
+        i = (i + 1) & mask();
+    }
+    return i;
+}
+
+const size_t *PageTable::find(const PageId &pid) const {
+    const Slot &slot = slots[probe(pid)];
+    return slot.pos == EMPTY ? nullptr : &slot.pos;
+}
+
+size_t PageTable::at(const PageId &pid) const {
+    const size_t *pos = find(pid);
+    if (pos == nullptr) {
+        throw std::out_of_range("Page not in buffer pool");
+    }
+    return *pos;
+}
+
+void PageTable::insert(const PageId &pid, size_t pos) {
+    size_t i = probe(pid);
+    if (slots[i].pos == EMPTY) {
+        if (2 * (count + 1) > mask() + 1) {
+            grow();
+            i = probe(pid);
+        }
+        count++;
+    }
+    slots[i] = {pid, pos};
+}
+
+void PageTable::erase(const PageId &pid) {
+    size_t i = probe(pid);
+    if (slots[i].pos == EMPTY) {
+        return;
+    }
+    count--;
+    // Shift back the entries of the run that follows, unless they would move before their home slot
+    size_t j = i;
+    while (true) {
+        slots[i].pos = EMPTY;
+        while (true) {
+            j = (j + 1) & mask();
+            if (slots[j].pos == EMPTY) {
+                return;
+            }
+            size_t k = home(slots[j].pid);
+            // Move the entry at j to i only if its home slot k is not cyclically in (i, j]
+            if (i <= j ? (i >= k || k > j) : (i >= k && k > j)) {
+                break;
+            }
+        }
+        slots[i] = slots[j];
+        i = j;
+    }
+}
+
+void PageTable::grow() {
+    std::unique_ptr<Slot[]> old = std::move(slots);
+    size_t old_size = mask() + 1;
+    bits++;
+    slots = std::make_unique<Slot[]>(mask() + 1);
+    for (size_t i = 0; i <= mask(); i++) {
+        slots[i].pos = EMPTY;
+    }
+    for (size_t i = 0; i < old_size; i++) {
+        if (old[i].pos != EMPTY) {
+            slots[probe(old[i].pid)] = old[i];
+        }
+    }
+}
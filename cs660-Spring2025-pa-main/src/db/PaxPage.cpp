@@ -0,0 +1,58 @@
+#include <db/PaxPage.hpp>
+#include <cstring>
+#include <stdexcept>
+
+using namespace db;
+
+PaxPage::PaxPage(Page &page, const TupleDesc &td) : HeapPage(page, td) {}
+
+PaxPage::PaxPage(const Page &page, const TupleDesc &td) : HeapPage(page, td) {}
+
+bool PaxPage::insertTuple(const Tuple &t) {
+    size_t hint = 0;
+    return insertTuple(t, hint);
+}
+
+bool PaxPage::insertTuple(const Tuple &t, size_t &hint) {
+    size_t slot = allocate(hint);
+    if (slot == capacity) {
+        return false;
+    }
+    // Serialize the tuple as a row, then scatter its fields
+    Page row;
+    td.serialize(row.data(), t);
+    for (size_t i = 0; i < td.size(); i++) {
+        size_t length = td.field_length(i);
+        std::memcpy(data + capacity * td.offset(i) + slot * length, row.data() + td.offset(i), length);
+    }
+    return true;
+}
+
+size_t PaxPage::fill(const uint8_t *tuples, size_t count) {
+    size_t n = occupy(count);
+    // One field at a time, so that each minipage is written sequentially
+    for (size_t i = 0; i < td.size(); i++) {
+        size_t length = td.field_length(i);
+        uint8_t *minipage = data + capacity * td.offset(i);
+        const uint8_t *value = tuples + td.offset(i);
+        for (size_t slot = 0; slot < n; slot++) {
+            std::memcpy(minipage + slot * length, value, length);
+            value += td.length();
+        }
+    }
+    return n;
+}
+
+Tuple PaxPage::getTuple(size_t slot) const {
+    if (empty(slot)) {
+        throw std::runtime_error("Slot not occupied");
+    }
+    Page row;
+    for (size_t i = 0; i < td.size(); i++) {
+        size_t length = td.field_length(i);
+        std::memcpy(row.data() + td.offset(i), data + capacity * td.offset(i) + slot * length, length);
+    }
+    return td.deserialize(row.data());
+}
+
+const uint8_t *PaxPage::column(size_t field) const { return data + capacity * td.offset(field); }
@@ -1,18 +1,21 @@
 #include <db/Query.hpp>
+#include <db/BTreeFile.hpp>
 #include <db/DbFile.hpp>
+#include <db/HeapFile.hpp>
 #include <db/Tuple.hpp>
+#include <db/TupleView.hpp>
 
+#include <algorithm>
 #include <unordered_map>
 #include <string>
+#include <string_view>
 #include <cmath>
 
 using namespace db;
 
-static bool evalFilter(const Tuple &t, const FilterPredicate &p, const TupleDesc &td) {
-    size_t i = td.index_of(p.field_name);
-    int tv = std::get<int>(t.get_field(i));
-    int pv = std::get<int>(p.value);
-    switch(p.op) {
+template<typename T>
+static bool compare(const T &tv, PredicateOp op, const T &pv) {
+    switch(op) {
         case PredicateOp::EQ: return tv == pv;
         case PredicateOp::NE: return tv != pv;
         case PredicateOp::LT: return tv < pv;
@@ -23,22 +26,88 @@ static bool evalFilter(const Tuple &t, const FilterPredicate &p, const TupleDesc
     }
 }
 
+static bool evalFilter(const TupleView &t, const FilterPredicate &p, const TupleDesc &td) {
+    size_t i = td.index_of(p.field_name);
+    switch (td.field_type(i)) {
+        case type_t::INT: return compare(t.get_int(i), p.op, std::get<int>(p.value));
+        case type_t::DOUBLE: return compare(t.get_double(i), p.op, std::get<double>(p.value));
+        case type_t::CHAR:
+            return compare(t.get_string_view(i), p.op, std::string_view(std::get<std::string>(p.value)));
+        default: return false;
+    }
+}
+
+/**
+ * Finds the positions of the tuples that may satisfy the predicates with the index that matches the fewest tuples.
+ * An index applies to the predicates (other than NE) on its first key field, and its range is the intersection of
+ * theirs. The bounds are inclusive: CHAR keys are truncated, so the tuples are checked against the predicates anyway.
+ * @return false if no index applies, or if they all match more than `limit` tuples.
+ */
+static bool indexLookup(const HeapFile &in, const std::vector<FilterPredicate> &preds, size_t limit,
+                        std::vector<std::pair<size_t, size_t>> &positions) {
+    const TupleDesc &td = in.getTupleDesc();
+    bool found = false;
+    std::vector<std::pair<size_t, size_t>> candidates;
+    for (const SecondaryIndex &index: in.getIndexes()) {
+        const field_t *lo = nullptr;
+        const field_t *hi = nullptr;
+        for (const FilterPredicate &p: preds) {
+            if (p.op == PredicateOp::NE || td.index_of(p.field_name) != index.fields[0]) {
+                continue;
+            }
+            if (p.op != PredicateOp::LT && p.op != PredicateOp::LE && (lo == nullptr || *lo < p.value)) {
+                lo = &p.value;
+            }
+            if (p.op != PredicateOp::GT && p.op != PredicateOp::GE && (hi == nullptr || p.value < *hi)) {
+                hi = &p.value;
+            }
+        }
+        if (lo == nullptr && hi == nullptr) {
+            continue;
+        }
+        candidates.clear();
+        bool complete = true;
+        if (lo == nullptr || hi == nullptr || !(*hi < *lo)) {
+            const BTreeFile &file = *index.file;
+            BTreeFile::Range range{lo != nullptr ? file.lowerBound({*lo}) : file.begin(),
+                                   hi != nullptr ? file.upperBound({*hi}) : file.end()};
+            size_t k = index.fields.size();
+            file.scanRange(range, [&](const TupleView &entry) {
+                if (candidates.size() == limit) {
+                    complete = false;
+                    return false;
+                }
+                candidates.emplace_back(entry.get_int(k), entry.get_int(k + 1));
+                return true;
+            });
+        }
+        if (complete) {
+            // The next indexes must match fewer tuples to be used
+            positions.swap(candidates);
+            limit = positions.size();
+            found = true;
+        }
+    }
+    return found;
+}
+
 void db::projection(const DbFile &in, DbFile &out, const std::vector<std::string> &fields) {
-    for (Iterator it = in.begin(); it != in.end(); ++it) {
-        Tuple t = *it;
+    std::vector<size_t> idxs;
+    for (auto &f : fields) {
+        idxs.push_back(in.getTupleDesc().index_of(f));
+    }
+    in.scan(idxs, [&](const TupleView &t) {
         std::vector<field_t> vals;
-        for (auto &f : fields) {
-            size_t idx = in.getTupleDesc().index_of(f);
+        for (size_t idx : idxs) {
             vals.push_back(t.get_field(idx));
         }
         out.insertTuple(Tuple(vals));
-    }
+    });
 }
 
 void db::filter(const DbFile &in, DbFile &out, const std::vector<FilterPredicate> &preds) {
     const TupleDesc &td = in.getTupleDesc();
-    for (Iterator it = in.begin(); it != in.end(); ++it) {
-        Tuple t = *it;
+    auto visit = [&](const TupleView &t) {
         bool pass = true;
         for (auto &p : preds) {
             if (!evalFilter(t, p, td)) {
@@ -46,10 +115,28 @@ void db::filter(const DbFile &in, DbFile &out, const std::vector<FilterPredicate
                 break;
             }
         }
-        if (pass) out.insertTuple(t);
+        // Only the tuples that pass are copied out of the page
+        if (pass) out.insertTuple(t.materialize());
+    };
+    std::vector<std::pair<size_t, size_t>> positions;
+    auto heap = dynamic_cast<const HeapFile *>(&in);
+    size_t limit = static_cast<size_t>(in.getNumPages() * INDEX_MATCHES_PER_PAGE);
+    if (heap != nullptr && indexLookup(*heap, preds, limit, positions)) {
+        // Visiting the tuples in the order of the file reads each page once, and outputs them like a scan
+        std::sort(positions.begin(), positions.end());
+        for (auto [page, slot] : positions) {
+            visit(in.view({in, page, slot}));
+        }
+        return;
     }
+    in.scan(visit);
 }
 
+struct StringHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view s) const { return std::hash<std::string_view>()(s); }
+};
+
 struct AggRes {
     int sum;
     int minv;
@@ -68,9 +155,8 @@ void db::aggregate(const DbFile &in, DbFile &out, const Aggregate &agg) {
     if (!hasGroup) {
         AggRes r;
         bool first = true;
-        for (Iterator it = in.begin(); it != in.end(); ++it) {
-            Tuple t = *it;
-            int v = std::get<int>(t.get_field(aggIdx));
+        in.scan({aggIdx}, [&](const TupleView &t) {
+            int v = t.get_int(aggIdx);
             r.sum += v;
             r.count++;
             if (first) {
@@ -81,7 +167,7 @@ void db::aggregate(const DbFile &in, DbFile &out, const Aggregate &agg) {
                 if (v < r.minv) r.minv = v;
                 if (v > r.maxv) r.maxv = v;
             }
-        }
+        });
         std::vector<field_t> val;
         switch (agg.op) {
             case AggregateOp::COUNT: val.push_back(r.count); break;
@@ -100,10 +186,9 @@ void db::aggregate(const DbFile &in, DbFile &out, const Aggregate &agg) {
         type_t gtype = td.field_type(groupIdx);
         if (gtype == type_t::INT) {
             std::unordered_map<int, AggRes> m;
-            for (Iterator it = in.begin(); it != in.end(); ++it) {
-                Tuple t = *it;
-                int gv = std::get<int>(t.get_field(groupIdx));
-                int av = std::get<int>(t.get_field(aggIdx));
+            in.scan({groupIdx, aggIdx}, [&](const TupleView &t) {
+                int gv = t.get_int(groupIdx);
+                int av = t.get_int(aggIdx);
                 auto &r = m[gv];
                 if (r.count == 0) {
                     r.minv = av;
@@ -114,7 +199,7 @@ void db::aggregate(const DbFile &in, DbFile &out, const Aggregate &agg) {
                 }
                 r.sum += av;
                 r.count++;
-            }
+            });
             for (auto &kv : m) {
                 std::vector<field_t> row;
                 row.push_back(kv.first);
@@ -133,12 +218,16 @@ void db::aggregate(const DbFile &in, DbFile &out, const Aggregate &agg) {
                 out.insertTuple(Tuple(row));
             }
         } else if (gtype == type_t::CHAR) {
-            std::unordered_map<std::string, AggRes> m;
-            for (Iterator it = in.begin(); it != in.end(); ++it) {
-                Tuple t = *it;
-                std::string gval = std::get<std::string>(t.get_field(groupIdx));
-                int av = std::get<int>(t.get_field(aggIdx));
-                auto &r = m[gval];
+            // Look groups up by string_view: a key is only copied when a new group appears
+            std::unordered_map<std::string, AggRes, StringHash, std::equal_to<>> m;
+            in.scan({groupIdx, aggIdx}, [&](const TupleView &t) {
+                std::string_view gval = t.get_string_view(groupIdx);
+                int av = t.get_int(aggIdx);
+                auto found = m.find(gval);
+                if (found == m.end()) {
+                    found = m.emplace(std::string(gval), AggRes()).first;
+                }
+                auto &r = found->second;
                 if (r.count == 0) {
                     r.minv = av;
                     r.maxv = av;
@@ -148,7 +237,7 @@ void db::aggregate(const DbFile &in, DbFile &out, const Aggregate &agg) {
                 }
                 r.sum += av;
                 r.count++;
-            }
+            });
             for (auto &kv : m) {
                 std::vector<field_t> row;
                 row.push_back(kv.first);
@@ -177,12 +266,10 @@ void db::join(const DbFile &left, const DbFile &right, DbFile &out, const JoinPr
     const TupleDesc &rtd = right.getTupleDesc();
     size_t li = ltd.index_of(pred.left);
     size_t ri = rtd.index_of(pred.right);
-    for (Iterator lit = left.begin(); lit != left.end(); ++lit) {
-        Tuple lt = *lit;
-        int lv = std::get<int>(lt.get_field(li));
-        for (Iterator rit = right.begin(); rit != right.end(); ++rit) {
-            Tuple rt = *rit;
-            int rv = std::get<int>(rt.get_field(ri));
+    left.scan([&](const TupleView &lt) {
+        int lv = lt.get_int(li);
+        right.scan([&](const TupleView &rt) {
+            int rv = rt.get_int(ri);
             bool match = false;
             switch (pred.op) {
                 case PredicateOp::EQ: match = (lv == rv); break;
@@ -201,6 +288,6 @@ void db::join(const DbFile &left, const DbFile &right, DbFile &out, const JoinPr
                 }
                 out.insertTuple(Tuple(merged));
             }
-        }
-    }
+        });
+    });
 }
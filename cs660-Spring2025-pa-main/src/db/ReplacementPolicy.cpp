@@ -0,0 +1,224 @@
+#include <db/ReplacementPolicy.hpp>
+#include <stdexcept>
+
+using namespace db;
+
+LruPolicy::LruPolicy(size_t numPages) : prev(numPages + 1), next(numPages + 1) {
+    prev[sentinel()] = next[sentinel()] = sentinel();
+}
+
+void LruPolicy::link(size_t pos) {
+    size_t first = next[sentinel()];
+    prev[pos] = sentinel();
+    next[pos] = first;
+    prev[first] = pos;
+    next[sentinel()] = pos;
+}
+
+void LruPolicy::unlink(size_t pos) {
+    next[prev[pos]] = next[pos];
+    prev[next[pos]] = prev[pos];
+}
+
+void LruPolicy::insert(size_t pos, const PageId &) {
+    link(pos);
+}
+
+void LruPolicy::access(size_t pos) {
+    unlink(pos);
+    link(pos);
+}
+
+void LruPolicy::erase(size_t pos) {
+    unlink(pos);
+}
+
+size_t LruPolicy::victim(const std::function<bool(size_t)> &evictable) {
+    for (size_t pos = prev[sentinel()]; pos != sentinel(); pos = prev[pos]) {
+        if (evictable(pos)) {
+            return pos;
+        }
+    }
+    throw std::runtime_error("No page to evict");
+}
+
+void LruPolicy::resize(size_t numPages) {
+    std::vector<size_t> order;
+    for (size_t pos = prev[sentinel()]; pos != sentinel(); pos = prev[pos]) {
+        order.push_back(pos);
+    }
+    prev.assign(numPages + 1, 0);
+    next.assign(numPages + 1, 0);
+    prev[sentinel()] = next[sentinel()] = sentinel();
+    for (size_t pos: order) {
+        link(pos);
+    }
+}
+
+ClockPolicy::ClockPolicy(size_t numPages) : resident(numPages), referenced(numPages) {}
+
+void ClockPolicy::insert(size_t pos, const PageId &) {
+    resident[pos] = true;
+    referenced[pos] = true;
+}
+
+void ClockPolicy::access(size_t pos) {
+    referenced[pos] = true;
+}
+
+void ClockPolicy::erase(size_t pos) {
+    resident[pos] = false;
+    referenced[pos] = false;
+}
+
+size_t ClockPolicy::victim(const std::function<bool(size_t)> &evictable) {
+    // Two sweeps are enough: the first one clears every reference bit
+    for (size_t i = 0; i < 2 * resident.size(); i++) {
+        size_t pos = hand;
+        hand = (hand + 1) % resident.size();
+        if (!resident[pos] || !evictable(pos)) {
+            continue;
+        }
+        if (!referenced[pos]) {
+            return pos;
+        }
+        referenced[pos] = false;
+    }
+    throw std::runtime_error("No page to evict");
+}
+
+void ClockPolicy::resize(size_t numPages) {
+    resident.resize(numPages);
+    referenced.resize(numPages);
+    hand %= numPages;
+}
+
+TwoQPolicy::TwoQPolicy(size_t numPages) {
+    resize(numPages);
+}
+
+void TwoQPolicy::remember(const PageId &pid) {
+    a1out.push_back(pid);
+    a1out_count[pid]++;
+    while (a1out.size() > kout) {
+        auto it = a1out_count.find(a1out.front());
+        if (--it->second == 0) {
+            a1out_count.erase(it);
+        }
+        a1out.pop_front();
+    }
+}
+
+void TwoQPolicy::insert(size_t pos, const PageId &pid) {
+    // A page that was recently evicted from A1in is hot: admit it straight to Am
+    bool hot = a1out_count.contains(pid);
+    std::list<size_t> &queue = hot ? am : a1in;
+    queue.push_front(pos);
+    pos_to_queue[pos] = {hot, queue.begin()};
+    pos_to_pid[pos] = pid;
+}
+
+void TwoQPolicy::access(size_t pos) {
+    // Correlated references of a page in A1in do not promote it
+    auto &[hot, it] = pos_to_queue.at(pos);
+    if (hot) {
+        am.splice(am.begin(), am, it);
+    }
+}
+
+void TwoQPolicy::erase(size_t pos) {
+    auto [hot, it] = pos_to_queue.at(pos);
+    if (hot) {
+        am.erase(it);
+    } else {
+        a1in.erase(it);
+    }
+    pos_to_queue.erase(pos);
+    pos_to_pid.erase(pos);
+}
+
+void TwoQPolicy::evict(size_t pos) {
+    // Only remember the pages evicted from A1in: a page discarded or moved to another frame was not replaced
+    if (!pos_to_queue.at(pos).first) {
+        remember(pos_to_pid.at(pos));
+    }
+    erase(pos);
+}
+
+size_t TwoQPolicy::victim(const std::function<bool(size_t)> &evictable) {
+    std::list<size_t> *first = a1in.size() > kin ? &a1in : &am;
+    std::list<size_t> *second = first == &a1in ? &am : &a1in;
+    for (const std::list<size_t> *queue: {first, second}) {
+        for (auto it = queue->rbegin(); it != queue->rend(); ++it) {
+            if (evictable(*it)) {
+                return *it;
+            }
+        }
+    }
+    throw std::runtime_error("No page to evict");
+}
+
+void TwoQPolicy::resize(size_t numPages) {
+    kin = std::max<size_t>(1, numPages / 4);
+    kout = std::max<size_t>(1, numPages / 2);
+}
+
+LruKPolicy::LruKPolicy(size_t k) : k(k) {
+    if (k == 0) {
+        throw std::invalid_argument("K must be positive");
+    }
+}
+
+std::tuple<bool, size_t, size_t> LruKPolicy::key(size_t pos) const {
+    const std::deque<size_t> &times = history.at(pos);
+    if (times.size() < k) {
+        // Infinite backward K-distance: fall back to LRU among these frames
+        return {false, times.back(), pos};
+    }
+    return {true, times.front(), pos};
+}
+
+void LruKPolicy::insert(size_t pos, const PageId &) {
+    history[pos] = {clock++};
+    order.insert(key(pos));
+}
+
+void LruKPolicy::access(size_t pos) {
+    order.erase(key(pos));
+    std::deque<size_t> &times = history.at(pos);
+    times.push_back(clock++);
+    if (times.size() > k) {
+        times.pop_front();
+    }
+    order.insert(key(pos));
+}
+
+void LruKPolicy::erase(size_t pos) {
+    order.erase(key(pos));
+    history.erase(pos);
+}
+
+size_t LruKPolicy::victim(const std::function<bool(size_t)> &evictable) {
+    for (const auto &[complete, time, pos]: order) {
+        if (evictable(pos)) {
+            return pos;
+        }
+    }
+    throw std::runtime_error("No page to evict");
+}
+
+void LruKPolicy::resize(size_t) {}
+
+std::unique_ptr<ReplacementPolicy> db::makeReplacementPolicy(ReplacementPolicyType type, size_t numPages) {
+    switch (type) {
+        case ReplacementPolicyType::LRU:
+            return std::make_unique<LruPolicy>(numPages);
+        case ReplacementPolicyType::CLOCK:
+            return std::make_unique<ClockPolicy>(numPages);
+        case ReplacementPolicyType::TWO_Q:
+            return std::make_unique<TwoQPolicy>(numPages);
+        case ReplacementPolicyType::LRU_K:
+            return std::make_unique<LruKPolicy>();
+    }
+    throw std::logic_error("Unknown replacement policy");
+}
@@ -0,0 +1,294 @@
+#include <db/SlottedPage.hpp>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using namespace db;
+
+namespace {
+    // Header of a data page
+    constexpr size_t KIND = 0;
+    constexpr size_t COUNT = 2;
+    constexpr size_t UPPER = 4;
+    // Header of an overflow page
+    constexpr size_t CHUNK_LENGTH = 2;
+    constexpr size_t NEXT = 4;
+
+    constexpr uint16_t OVERFLOW_PAGE = 1;
+
+    uint16_t load16(const uint8_t *p) {
+        uint16_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    void store16(uint8_t *p, uint16_t value) { std::memcpy(p, &value, sizeof(value)); }
+} // namespace
+
+SlottedPage::SlottedPage(Page &page, const TupleDesc &td) : td(td), page(page.data()) {}
+
+SlottedPage::SlottedPage(const Page &page, const TupleDesc &td) : SlottedPage(const_cast<Page &>(page), td) {}
+
+size_t SlottedPage::count() const { return isOverflow() ? 0 : load16(page + COUNT); }
+
+size_t SlottedPage::upper() const {
+    size_t upper = load16(page + UPPER);
+    return upper == 0 ? DEFAULT_PAGE_SIZE : upper;
+}
+
+size_t SlottedPage::recordOffset(size_t slot) const { return load16(page + HEADER_SIZE + slot * SLOT_SIZE); }
+
+size_t SlottedPage::recordLength(size_t slot) const { return load16(page + HEADER_SIZE + slot * SLOT_SIZE + 2); }
+
+std::vector<size_t> SlottedPage::outOfLine(const TupleDesc &td, const Tuple &t) {
+    size_t size = td.var_length();
+    std::vector<std::pair<size_t, size_t>> strings;
+    for (size_t i = 0; i < td.size(); i++) {
+        if (td.type(i) == type_t::CHAR) {
+            size_t length = std::get<std::string>(t.get_field(i)).size();
+            size += length;
+            strings.emplace_back(length, i);
+        }
+    }
+    std::sort(strings.begin(), strings.end(), std::greater<>());
+    std::vector<size_t> fields;
+    for (const auto &[length, i]: strings) {
+        if (size <= MAX_RECORD_SIZE || length <= sizeof(Overflow)) {
+            break;
+        }
+        size -= length - sizeof(Overflow);
+        fields.push_back(i);
+    }
+    std::sort(fields.begin(), fields.end());
+    return fields;
+}
+
+size_t SlottedPage::recordSize(const TupleDesc &td, const Tuple &t,
+                               const std::vector<std::pair<size_t, Overflow>> &overflows) {
+    size_t size = td.var_length();
+    auto overflow = overflows.begin();
+    for (size_t i = 0; i < td.size(); i++) {
+        if (td.type(i) == type_t::CHAR) {
+            if (overflow != overflows.end() && overflow->first == i) {
+                size += sizeof(Overflow);
+                overflow++;
+            } else {
+                size += std::get<std::string>(t.get_field(i)).size();
+            }
+        }
+    }
+    return size;
+}
+
+size_t SlottedPage::freeSpace() const {
+    if (isOverflow()) {
+        return 0;
+    }
+    size_t used = HEADER_SIZE + SLOT_SIZE * count();
+    for (size_t slot = 0; slot < count(); slot++) {
+        used += recordOffset(slot) == 0 ? 0 : recordLength(slot);
+    }
+    return DEFAULT_PAGE_SIZE - used;
+}
+
+bool SlottedPage::isOverflow() const { return load16(page + KIND) == OVERFLOW_PAGE; }
+
+size_t SlottedPage::begin() const {
+    size_t slot = 0;
+    while (slot < count() && recordOffset(slot) == 0) {
+        slot++;
+    }
+    return slot;
+}
+
+size_t SlottedPage::end() const { return count(); }
+
+void SlottedPage::compact() {
+    Page records;
+    size_t upper = DEFAULT_PAGE_SIZE;
+    for (size_t slot = 0; slot < count(); slot++) {
+        if (recordOffset(slot) != 0) {
+            size_t length = recordLength(slot);
+            upper -= length;
+            std::memcpy(records.data() + upper, page + recordOffset(slot), length);
+            store16(page + HEADER_SIZE + slot * SLOT_SIZE, upper);
+        }
+    }
+    std::memcpy(page + upper, records.data() + upper, DEFAULT_PAGE_SIZE - upper);
+    store16(page + UPPER, upper);
+}
+
+bool SlottedPage::insertTuple(const Tuple &t, const std::vector<std::pair<size_t, Overflow>> &overflows) {
+    size_t slot;
+    return insertTuple(t, overflows, slot);
+}
+
+bool SlottedPage::insertTuple(const Tuple &t, const std::vector<std::pair<size_t, Overflow>> &overflows,
+                              size_t &slot) {
+    if (isOverflow()) {
+        return false;
+    }
+    size_t size = recordSize(td, t, overflows);
+    if (HEADER_SIZE + SLOT_SIZE + size > DEFAULT_PAGE_SIZE) {
+        throw std::length_error("Tuple too large for a page");
+    }
+
+    size_t n = count();
+    slot = 0;
+    while (slot < n && recordOffset(slot) != 0) {
+        slot++;
+    }
+    size_t directory = HEADER_SIZE + SLOT_SIZE * std::max(n, slot + 1);
+    if (directory + size > upper()) {
+        if (freeSpace() < size + (slot == n ? SLOT_SIZE : 0)) {
+            return false;
+        }
+        compact();
+    }
+
+    size_t offset = upper() - size;
+    uint8_t *record = page + offset;
+    size_t tail = td.var_length();
+    auto overflow = overflows.begin();
+    for (size_t i = 0; i < td.size(); i++) {
+        uint8_t *field = record + td.var_offset(i);
+        switch (td.type(i)) {
+            case type_t::INT: {
+                int value = std::get<int>(t.get_field(i));
+                std::memcpy(field, &value, INT_SIZE);
+                break;
+            }
+            case type_t::DOUBLE: {
+                double value = std::get<double>(t.get_field(i));
+                std::memcpy(field, &value, DOUBLE_SIZE);
+                break;
+            }
+            case type_t::CHAR: {
+                store16(field, tail);
+                if (overflow != overflows.end() && overflow->first == i) {
+                    store16(field + 2, OVERFLOW_LENGTH);
+                    std::memcpy(record + tail, &overflow->second, sizeof(Overflow));
+                    tail += sizeof(Overflow);
+                    overflow++;
+                } else {
+                    const std::string &value = std::get<std::string>(t.get_field(i));
+                    store16(field + 2, value.size());
+                    std::memcpy(record + tail, value.data(), value.size());
+                    tail += value.size();
+                }
+                break;
+            }
+        }
+    }
+    store16(page + HEADER_SIZE + slot * SLOT_SIZE, offset);
+    store16(page + HEADER_SIZE + slot * SLOT_SIZE + 2, size);
+    store16(page + UPPER, offset);
+    if (slot == n) {
+        store16(page + COUNT, n + 1);
+    }
+    return true;
+}
+
+void SlottedPage::deleteTuple(size_t slot) {
+    if (slot >= count()) {
+        throw std::runtime_error("Out of index");
+    }
+    if (empty(slot)) {
+        throw std::runtime_error("Slot not occupied");
+    }
+    store16(page + HEADER_SIZE + slot * SLOT_SIZE, 0);
+    store16(page + HEADER_SIZE + slot * SLOT_SIZE + 2, 0);
+    // Trailing empty slots are removed from the directory
+    size_t n = count();
+    while (n > 0 && recordOffset(n - 1) == 0) {
+        n--;
+    }
+    store16(page + COUNT, n);
+    if (n == 0) {
+        store16(page + UPPER, 0);
+    }
+}
+
+bool SlottedPage::empty(size_t slot) const { return slot >= count() || recordOffset(slot) == 0; }
+
+Tuple SlottedPage::getTuple(size_t slot) const {
+    const uint8_t *record = tupleData(slot);
+    std::vector<field_t> fields;
+    fields.reserve(td.size());
+    for (size_t i = 0; i < td.size(); i++) {
+        const uint8_t *field = record + td.var_offset(i);
+        switch (td.type(i)) {
+            case type_t::INT: {
+                int value;
+                std::memcpy(&value, field, INT_SIZE);
+                fields.emplace_back(value);
+                break;
+            }
+            case type_t::DOUBLE: {
+                double value;
+                std::memcpy(&value, field, DOUBLE_SIZE);
+                fields.emplace_back(value);
+                break;
+            }
+            case type_t::CHAR: {
+                uint16_t length = load16(field + 2);
+                if (length == OVERFLOW_LENGTH) {
+                    fields.emplace_back(std::string());
+                } else {
+                    fields.emplace_back(std::string(reinterpret_cast<const char *>(record + load16(field)), length));
+                }
+                break;
+            }
+        }
+    }
+    return Tuple(std::move(fields));
+}
+
+const uint8_t *SlottedPage::tupleData(size_t slot) const {
+    if (empty(slot)) {
+        throw std::runtime_error("Slot not occupied");
+    }
+    return page + recordOffset(slot);
+}
+
+std::vector<std::pair<size_t, SlottedPage::Overflow>> SlottedPage::overflows(size_t slot) const {
+    const uint8_t *record = tupleData(slot);
+    std::vector<std::pair<size_t, Overflow>> overflows;
+    for (size_t i = 0; i < td.size(); i++) {
+        const uint8_t *field = record + td.var_offset(i);
+        if (td.type(i) == type_t::CHAR && load16(field + 2) == OVERFLOW_LENGTH) {
+            Overflow overflow;
+            std::memcpy(&overflow, record + load16(field), sizeof(Overflow));
+            overflows.emplace_back(i, overflow);
+        }
+    }
+    return overflows;
+}
+
+void SlottedPage::next(size_t &slot) const {
+    // The directory may have shrunk below the slot if its tuple was the last one and was deleted
+    size_t n = count();
+    while (++slot < n && recordOffset(slot) == 0);
+    slot = std::min(slot, n);
+}
+
+void SlottedPage::makeOverflow(std::string_view chunk, size_t next) {
+    if (chunk.size() > OVERFLOW_CAPACITY) {
+        throw std::length_error("Chunk too large for an overflow page");
+    }
+    auto next32 = static_cast<uint32_t>(next);
+    store16(page + KIND, OVERFLOW_PAGE);
+    store16(page + CHUNK_LENGTH, chunk.size());
+    std::memcpy(page + NEXT, &next32, sizeof(next32));
+    std::memcpy(page + HEADER_SIZE, chunk.data(), chunk.size());
+}
+
+std::string_view SlottedPage::readOverflow(size_t &next) const {
+    if (!isOverflow()) {
+        throw std::runtime_error("Not an overflow page");
+    }
+    uint32_t next32;
+    std::memcpy(&next32, page + NEXT, sizeof(next32));
+    next = next32;
+    return {reinterpret_cast<const char *>(page + HEADER_SIZE), load16(page + CHUNK_LENGTH)};
+}
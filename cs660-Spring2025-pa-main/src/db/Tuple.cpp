@@ -1,11 +1,148 @@
+#include <algorithm>
+#include <array>
 #include <cstring>
 #include <db/Tuple.hpp>
 #include <stdexcept>
+#include <utility>
 
 using namespace db;
 
+namespace {
+    size_t fieldSize(type_t type) {
+        switch (type) {
+            case type_t::INT:
+                return INT_SIZE;
+            case type_t::DOUBLE:
+                return DOUBLE_SIZE;
+            case type_t::CHAR:
+                return CHAR_SIZE;
+        }
+        throw std::logic_error("Unknown field type");
+    }
+
+    template<type_t T>
+    struct FieldCodec;
+
+    template<>
+    struct FieldCodec<type_t::INT> {
+        static constexpr size_t size = INT_SIZE;
+
+        static void write(uint8_t *data, const field_t &field) {
+            int value = std::get<int>(field);
+            std::memcpy(data, &value, INT_SIZE);
+        }
+
+        static field_t read(const uint8_t *data) {
+            int value;
+            std::memcpy(&value, data, INT_SIZE);
+            return value;
+        }
+    };
+
+    template<>
+    struct FieldCodec<type_t::DOUBLE> {
+        static constexpr size_t size = DOUBLE_SIZE;
+
+        static void write(uint8_t *data, const field_t &field) {
+            double value = std::get<double>(field);
+            std::memcpy(data, &value, DOUBLE_SIZE);
+        }
+
+        static field_t read(const uint8_t *data) {
+            double value;
+            std::memcpy(&value, data, DOUBLE_SIZE);
+            return value;
+        }
+    };
+
+    template<>
+    struct FieldCodec<type_t::CHAR> {
+        static constexpr size_t size = CHAR_SIZE;
+
+        static void write(uint8_t *data, const field_t &field) {
+            strncpy(reinterpret_cast<char *>(data), std::get<std::string>(field).c_str(), CHAR_SIZE);
+        }
+
+        static field_t read(const uint8_t *data) {
+            const char *chars = reinterpret_cast<const char *>(data);
+            return std::string(chars, strnlen(chars, CHAR_SIZE));
+        }
+    };
+
+    /**
+     * @brief Serialization of a schema known at compile time.
+     * @details The offsets are constants and the field loop is unrolled, so each field is a single load or store.
+     */
+    template<type_t... Ts>
+    struct FixedLayout {
+        static constexpr size_t N = sizeof...(Ts);
+        static constexpr std::array<type_t, N> types{Ts...};
+        static constexpr std::array<size_t, N> offsets = [] {
+            std::array<size_t, N> offsets{};
+            std::array<size_t, N> sizes{FieldCodec<Ts>::size...};
+            for (size_t i = 1; i < N; i++) {
+                offsets[i] = offsets[i - 1] + sizes[i - 1];
+            }
+            return offsets;
+        }();
+
+        template<size_t... I>
+        static void serialize(uint8_t *data, const Tuple &t, std::index_sequence<I...>) {
+            (FieldCodec<Ts>::write(data + offsets[I], t.get_field(I)), ...);
+        }
+
+        template<size_t... I>
+        static Tuple deserialize(const uint8_t *data, std::index_sequence<I...>) {
+            return std::vector<field_t>{FieldCodec<Ts>::read(data + offsets[I])...};
+        }
+
+        static void serialize(const TupleDesc &, uint8_t *data, const Tuple &t) {
+            serialize(data, t, std::make_index_sequence<N>{});
+        }
+
+        static Tuple deserialize(const TupleDesc &, const uint8_t *data) {
+            return deserialize(data, std::make_index_sequence<N>{});
+        }
+
+        static bool matches(const std::vector<type_t> &schema) {
+            return schema.size() == N && std::equal(schema.begin(), schema.end(), types.begin());
+        }
+    };
+
+    struct Specialization {
+        bool (*matches)(const std::vector<type_t> &);
+        void (*serialize)(const TupleDesc &, uint8_t *, const Tuple &);
+        Tuple (*deserialize)(const TupleDesc &, const uint8_t *);
+    };
+
+    template<type_t... Ts>
+    constexpr Specialization specialize() {
+        return {&FixedLayout<Ts...>::matches, &FixedLayout<Ts...>::serialize, &FixedLayout<Ts...>::deserialize};
+    }
+
+    constexpr type_t I = type_t::INT;
+    constexpr type_t D = type_t::DOUBLE;
+    constexpr type_t C = type_t::CHAR;
+
+    /// The schemas that get a specialized serializer; any other schema uses the generic one.
+    constexpr Specialization SPECIALIZATIONS[] = {
+            specialize<I>(),
+            specialize<I, I>(),
+            specialize<I, I, I>(),
+            specialize<I, I, I, I>(),
+            specialize<D>(),
+            specialize<I, D>(),
+            specialize<I, I, D>(),
+            specialize<I, C>(),
+            specialize<I, I, C>(),
+            specialize<I, C, D>(),
+    };
+} // namespace
+
 Tuple::Tuple(const std::vector<field_t> &fields) : fields(fields) {}
 
+Tuple::Tuple(std::vector<field_t> &&fields) : fields(std::move(fields)) {}
+
 type_t Tuple::field_type(size_t i) const {
     const field_t &field = fields.at(i);
     if (std::holds_alternative<int>(field)) {
@@ -29,25 +166,29 @@ TupleDesc::TupleDesc(const std::vector<type_t> &types, const std::vector<std::st
     if (types.size() != names.size()) {
         throw std::logic_error("Types and names sizes do not match");
     }
-    size_t offset = 0;
+    offsets.reserve(types.size());
+    var_offsets.reserve(types.size());
     for (size_t i = 0; i < types.size(); i++) {
-        offsets.push_back(offset);
+        offsets.push_back(len);
+        var_offsets.push_back(var_len);
+        var_len += types[i] == type_t::CHAR ? CHAR_REF_SIZE : fieldSize(types[i]);
         name_to_index[names[i]] = i;
-        switch (types[i]) {
-            case type_t::INT:
-                offset += INT_SIZE;
-                break;
-            case type_t::DOUBLE:
-                offset += DOUBLE_SIZE;
-                break;
-            case type_t::CHAR:
-                offset += CHAR_SIZE;
-                break;
+        size_t size = fieldSize(types[i]);
+        if (types[i] != type_t::CHAR && len % size != 0) {
+            is_aligned = false;
         }
+        len += size;
     }
     if (name_to_index.size() != names.size()) {
         throw std::logic_error("Duplicate name");
     }
+    for (const Specialization &specialization: SPECIALIZATIONS) {
+        if (specialization.matches(types)) {
+            serializer = specialization.serialize;
+            deserializer = specialization.deserialize;
+            break;
+        }
+    }
 }
 
 bool TupleDesc::compatible(const Tuple &tuple) const {
@@ -75,25 +216,6 @@ size_t TupleDesc::offset_of(const size_t &index) const {
     return offsets.at(index);
 }
 
-size_t TupleDesc::length() const {
-    // TODO pa1
-    size_t length = 0;
-    for (type_t type: types) {
-        switch (type) {
-            case type_t::INT:
-                length += INT_SIZE;
-                break;
-            case type_t::DOUBLE:
-                length += DOUBLE_SIZE;
-                break;
-            case type_t::CHAR:
-                length += CHAR_SIZE;
-                break;
-        }
-    }
-    return length;
-}
-
 size_t TupleDesc::size() const {
     // TODO pa1
     return types.size();
@@ -101,44 +223,46 @@ size_t TupleDesc::size() const {
 
 Tuple TupleDesc::deserialize(const uint8_t *data) const {
     // TODO pa1
+    return deserializer(*this, data);
+}
+
+void TupleDesc::serialize(uint8_t *data, const Tuple &t) const {
+    // TODO pa1
+    serializer(*this, data, t);
+}
+
+Tuple TupleDesc::deserializeAny(const TupleDesc &td, const uint8_t *data) {
     std::vector<field_t> fields;
-    fields.reserve(types.size());
-    for (const type_t &type: types) {
-        switch (type) {
+    fields.reserve(td.types.size());
+    for (size_t i = 0; i < td.types.size(); i++) {
+        const uint8_t *field = data + td.offsets[i];
+        switch (td.types[i]) {
             case type_t::INT:
-                fields.emplace_back(*reinterpret_cast<const int *>(data));
-                data += INT_SIZE;
+                fields.push_back(FieldCodec<type_t::INT>::read(field));
                 break;
             case type_t::DOUBLE:
-                fields.emplace_back(*reinterpret_cast<const double *>(data));
-                data += DOUBLE_SIZE;
+                fields.push_back(FieldCodec<type_t::DOUBLE>::read(field));
                 break;
             case type_t::CHAR:
-                fields.emplace_back(std::string(reinterpret_cast<const char *>(data)));
-                data += CHAR_SIZE;
+                fields.push_back(FieldCodec<type_t::CHAR>::read(field));
                 break;
         }
     }
-    return {fields};
+    return Tuple(std::move(fields));
 }
 
-void TupleDesc::serialize(uint8_t *data, const Tuple &t) const {
-    // TODO pa1
-    for (size_t i = 0; i < types.size(); i++) {
-        const type_t &type = types[i];
-        const field_t &field = t.get_field(i);
-        switch (type) {
+void TupleDesc::serializeAny(const TupleDesc &td, uint8_t *data, const Tuple &t) {
+    for (size_t i = 0; i < td.types.size(); i++) {
+        uint8_t *field = data + td.offsets[i];
+        switch (td.types[i]) {
             case type_t::INT:
-                *reinterpret_cast<int *>(data) = std::get<int>(field);
-                data += INT_SIZE;
+                FieldCodec<type_t::INT>::write(field, t.get_field(i));
                 break;
             case type_t::DOUBLE:
-                *reinterpret_cast<double *>(data) = std::get<double>(field);
-                data += DOUBLE_SIZE;
+                FieldCodec<type_t::DOUBLE>::write(field, t.get_field(i));
                 break;
             case type_t::CHAR:
-                strncpy(reinterpret_cast<char *>(data), std::get<std::string>(field).c_str(), CHAR_SIZE);
-                data += CHAR_SIZE;
+                FieldCodec<type_t::CHAR>::write(field, t.get_field(i));
                 break;
         }
     }
@@ -0,0 +1,81 @@
+#include <db/TupleView.hpp>
+#include <cstring>
+#include <stdexcept>
+
+using namespace db;
+
+TupleView::TupleView(PageView page, const TupleDesc &td, const uint8_t *data, bool var)
+        : page(std::move(page)), td(&td), data(data), var(var) {}
+
+TupleView::TupleView(PageView page, const TupleDesc &td, const uint8_t *columns, size_t rows, size_t slot)
+        : page(std::move(page)), td(&td), data(columns), rows(rows), slot(slot) {}
+
+TupleView::TupleView(Tuple t, const TupleDesc &td) : td(&td), owned(std::move(t)) {}
+
+size_t TupleView::size() const { return td->size(); }
+
+type_t TupleView::field_type(size_t i) const { return td->field_type(i); }
+
+int TupleView::get_int(size_t i) const {
+    if (i >= td->size() || td->type(i) != type_t::INT) {
+        throw std::logic_error("Field is not an INT");
+    }
+    if (owned) {
+        return std::get<int>(owned->get_field(i));
+    }
+    int value;
+    std::memcpy(&value, field(i), INT_SIZE);
+    return value;
+}
+
+double TupleView::get_double(size_t i) const {
+    if (i >= td->size() || td->type(i) != type_t::DOUBLE) {
+        throw std::logic_error("Field is not a DOUBLE");
+    }
+    if (owned) {
+        return std::get<double>(owned->get_field(i));
+    }
+    double value;
+    std::memcpy(&value, field(i), DOUBLE_SIZE);
+    return value;
+}
+
+std::string_view TupleView::get_string_view(size_t i) const {
+    if (i >= td->size() || td->type(i) != type_t::CHAR) {
+        throw std::logic_error("Field is not a CHAR");
+    }
+    if (owned) {
+        return std::get<std::string>(owned->get_field(i));
+    }
+    if (var) {
+        uint16_t ref[2];
+        std::memcpy(ref, field(i), CHAR_REF_SIZE);
+        return {reinterpret_cast<const char *>(data + ref[0]), ref[1]};
+    }
+    const char *chars = reinterpret_cast<const char *>(field(i));
+    return {chars, strnlen(chars, CHAR_SIZE)};
+}
+
+field_t TupleView::get_field(size_t i) const {
+    switch (td->field_type(i)) {
+        case type_t::INT:
+            return get_int(i);
+        case type_t::DOUBLE:
+            return get_double(i);
+        case type_t::CHAR:
+            return std::string(get_string_view(i));
+    }
+    throw std::logic_error("Unknown field type");
+}
+
+Tuple TupleView::materialize() const {
+    if (owned) {
+        return *owned;
+    }
+    std::vector<field_t> fields;
+    fields.reserve(size());
+    for (size_t i = 0; i < size(); i++) {
+        fields.push_back(get_field(i));
+    }
+    return Tuple(std::move(fields));
+}
@@ -2,6 +2,10 @@
 
 #include <db/Database.hpp>
 #include <db/DbFile.hpp>
+#include <atomic>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
 
 TEST(BufferPoolTest, getPage) {
     db::Database &db = db::getDatabase();
@@ -249,3 +253,331 @@ TEST(BufferPoolTest, LRU) {
         EXPECT_EQ(writes[i], size + i);
     }
 }
+
+TEST(BufferPoolTest, concurrentHits) {
+    db::Database &db = db::getDatabase();
+    db::BufferPool &bufferPool = db.getBufferPool();
+
+    std::string name{"file.hits"};
+    db::TupleDesc td;
+    db.add(std::make_unique<db::DbFile>(name, td));
+    const size_t capacity = bufferPool.capacity();
+    const size_t hot = capacity / 2;
+    for (size_t i = 0; i < capacity; i++) {
+        bufferPool.getPage({name, i});
+    }
+
+    // touch the oldest pages from many threads at once: every hit is recorded, none is dropped under contention
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([&] {
+            for (int round = 0; round < 20; round++) {
+                for (size_t i = 0; i < hot; i++) {
+                    db::PageView view(bufferPool, {name, i});
+                }
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+
+    // the new pages evict the pages that were not touched
+    for (size_t i = 0; i < capacity - hot; i++) {
+        bufferPool.getPage({name, capacity + i});
+    }
+    for (size_t i = 0; i < hot; i++) {
+        EXPECT_TRUE(bufferPool.contains({name, i}));
+    }
+    for (size_t i = hot; i < capacity; i++) {
+        EXPECT_FALSE(bufferPool.contains({name, i}));
+    }
+    EXPECT_EQ(db.get(name).getReads().size(), capacity + capacity - hot);
+
+    // hits and misses from many threads at once
+    threads.clear();
+    for (size_t t = 0; t < 8; t++) {
+        threads.emplace_back([&, t] {
+            for (size_t i = 0; i < capacity; i++) {
+                db::PageView view(bufferPool, {name, (t * capacity / 4 + i) % (2 * capacity)});
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    for (size_t i = 0; i < 2 * capacity; i++) {
+        db::PageView view(bufferPool, {name, i});
+        EXPECT_TRUE(bufferPool.contains({name, i}));
+    }
+}
+
+TEST(BufferPoolTest, capacity) {
+    constexpr size_t size = 4 * db::DEFAULT_NUM_PAGES;
+    db::Database &db = db::getDatabase();
+
+    std::string name{"file"};
+    db::TupleDesc td;
+    db.add(std::make_unique<db::DbFile>(name, td));
+    db::BufferPool bufferPool(size);
+    EXPECT_EQ(bufferPool.capacity(), size);
+    for (size_t i = 0; i < size; i++) {
+        bufferPool.getPage({name, i});
+    }
+    for (size_t i = 0; i < size; i++) {
+        EXPECT_TRUE(bufferPool.contains({name, i}));
+    }
+
+    const db::DbFile &file = db.get(name);
+    EXPECT_EQ(file.getReads().size(), size);
+    EXPECT_EQ(file.getWrites().size(), 0);
+    EXPECT_ANY_THROW(db::BufferPool(0));
+}
+
+TEST(BufferPoolTest, resize) {
+    constexpr size_t size = 10;
+    db::Database &db = db::getDatabase();
+
+    std::string name{"file"};
+    db::TupleDesc td;
+    db.add(std::make_unique<db::DbFile>(name, td));
+    db::BufferPool bufferPool(size);
+    for (size_t i = 0; i < size; i++) {
+        db::PageId pid{name, i};
+        db::Page &page = bufferPool.getPage(pid);
+        page[0] = i;
+        if (i % 2 == 0) {
+            bufferPool.markDirty(pid);
+        }
+    }
+
+    // grow: every page stays resident with its contents and dirty bit
+    bufferPool.resize(2 * size);
+    EXPECT_EQ(bufferPool.capacity(), 2 * size);
+    for (size_t i = 0; i < size; i++) {
+        db::PageId pid{name, i};
+        EXPECT_TRUE(bufferPool.contains(pid));
+        EXPECT_EQ(bufferPool.isDirty(pid), i % 2 == 0);
+        EXPECT_EQ(bufferPool.getPage(pid)[0], i);
+    }
+    for (size_t i = size; i < 2 * size; i++) {
+        bufferPool.getPage({name, i});
+    }
+
+    const db::DbFile &file = db.get(name);
+    const auto &reads = file.getReads();
+    const auto &writes = file.getWrites();
+    EXPECT_EQ(reads.size(), 2 * size);
+    EXPECT_EQ(writes.size(), 0);
+
+    // shrink: pages [0, size) are the least recently used and get evicted, dirty ones are flushed
+    bufferPool.resize(size);
+    EXPECT_EQ(bufferPool.capacity(), size);
+    for (size_t i = 0; i < size; i++) {
+        EXPECT_FALSE(bufferPool.contains({name, i}));
+        EXPECT_TRUE(bufferPool.contains({name, size + i}));
+    }
+    EXPECT_EQ(reads.size(), 2 * size);
+    EXPECT_EQ(writes.size(), size / 2);
+}
+
+TEST(BufferPoolTest, resizePolicy) {
+    constexpr size_t size = 10;
+    db::Database &db = db::getDatabase();
+
+    std::string name{"file"};
+    db::TupleDesc td;
+    db.add(std::make_unique<db::DbFile>(name, td));
+    db::BufferPool bufferPool(size, false, db::ReplacementPolicyType::CLOCK);
+    for (size_t i = 0; i < size; i++) {
+        bufferPool.getPage({name, i})[0] = i;
+    }
+    bufferPool.resize(size / 2);
+    bufferPool.resize(size);
+    size_t resident = 0;
+    for (size_t i = 0; i < size; i++) {
+        if (bufferPool.contains({name, i})) {
+            EXPECT_EQ(bufferPool.getPage({name, i})[0], i);
+            resident++;
+        }
+    }
+    EXPECT_EQ(resident, size / 2);
+    for (size_t i = size; i < 2 * size; i++) {
+        bufferPool.getPage({name, i});
+    }
+    EXPECT_EQ(db.get(name).getReads().size(), 2 * size);
+}
+
+TEST(BufferPoolTest, pinPage) {
+    db::Database &db = db::getDatabase();
+
+    std::string name{"file"};
+    db::TupleDesc td;
+    db.add(std::make_unique<db::DbFile>(name, td));
+    db::BufferPool bufferPool(2);
+    db::Page &page0 = bufferPool.pinPage({name, 0});
+    for (size_t i = 1; i < 10; i++) {
+        bufferPool.getPage({name, i});
+        EXPECT_TRUE(bufferPool.contains({name, 0}));
+    }
+    EXPECT_ANY_THROW(bufferPool.discardPage({name, 0}));
+
+    db::Page &page1 = bufferPool.pinPage({name, 1});
+    EXPECT_THROW(bufferPool.getPage({name, 2}), std::runtime_error);
+    bufferPool.unpinPage(page1);
+    bufferPool.getPage({name, 2});
+    EXPECT_FALSE(bufferPool.contains({name, 1}));
+    EXPECT_TRUE(bufferPool.contains({name, 0}));
+
+    bufferPool.unpinPage(page0);
+    EXPECT_ANY_THROW(bufferPool.unpinPage(page0));
+    bufferPool.discardPage({name, 0});
+    EXPECT_FALSE(bufferPool.contains({name, 0}));
+}
+
+TEST(BufferPoolTest, PageGuard) {
+    db::Database &db = db::getDatabase();
+
+    std::string name{"file"};
+    db::TupleDesc td;
+    db.add(std::make_unique<db::DbFile>(name, td));
+    db::BufferPool bufferPool(2);
+    {
+        db::PageGuard guard(bufferPool, {name, 0});
+        (*guard)[0] = 1;
+        guard.markDirty();
+        EXPECT_TRUE(bufferPool.isDirty({name, 0}));
+        db::PageGuard moved(std::move(guard));
+        for (size_t i = 1; i < 10; i++) {
+            bufferPool.getPage({name, i});
+        }
+        EXPECT_TRUE(bufferPool.contains({name, 0}));
+        EXPECT_EQ(moved->at(0), 1);
+        EXPECT_ANY_THROW(bufferPool.discardPage({name, 0}));
+    }
+    // the page is no longer pinned and can be evicted
+    bufferPool.getPage({name, 10});
+    bufferPool.getPage({name, 11});
+    EXPECT_FALSE(bufferPool.contains({name, 0}));
+    EXPECT_EQ(db.get(name).getWrites().size(), 1);
+}
+
+TEST(BufferPoolTest, flushOldest) {
+    db::Database &db = db::getDatabase();
+
+    std::string name{"file"};
+    db::TupleDesc td;
+    db.add(std::make_unique<db::DbFile>(name, td));
+    db::BufferPool bufferPool(10);
+    for (size_t i: {5, 6, 2, 7, 0, 1}) {
+        bufferPool.getPage({name, i});
+        bufferPool.markDirty({name, i});
+    }
+    EXPECT_EQ(bufferPool.getNumDirty(), 6);
+    EXPECT_EQ(bufferPool.flushOldest(4), 4);
+    EXPECT_EQ(bufferPool.getNumDirty(), 2);
+    for (size_t i: {5, 6, 2, 7}) {
+        EXPECT_FALSE(bufferPool.isDirty({name, i}));
+    }
+    EXPECT_TRUE(bufferPool.isDirty({name, 0}));
+    EXPECT_TRUE(bufferPool.isDirty({name, 1}));
+
+    // written in page order
+    const auto &writes = db.get(name).getWrites();
+    EXPECT_EQ(writes, std::vector<size_t>({2, 5, 6, 7}));
+    EXPECT_EQ(bufferPool.flushOldest(10), 2);
+    EXPECT_EQ(bufferPool.getNumDirty(), 0);
+}
+
+TEST(BufferPoolTest, flusher) {
+    constexpr size_t size = 20;
+    db::Database &db = db::getDatabase();
+
+    std::string name{"file"};
+    db::TupleDesc td;
+    db.add(std::make_unique<db::DbFile>(name, td));
+    db::BufferPool bufferPool(size);
+    EXPECT_ANY_THROW(bufferPool.setDirtyWatermarks(0.5, 0.2));
+    bufferPool.setDirtyWatermarks(0.25, 0.5);
+    bufferPool.startFlusher();
+    for (size_t i = 0; i < size; i++) {
+        db::PageGuard page(bufferPool, {name, i});
+        std::unique_lock lock(page.latch());
+        page.markDirty();
+    }
+    for (int i = 0; i < 100 && bufferPool.getNumDirty() > size / 4; i++) {
+        std::this_thread::sleep_for(db::FLUSH_INTERVAL);
+    }
+    EXPECT_LE(bufferPool.getNumDirty(), size / 4);
+    bufferPool.stopFlusher();
+
+    // the oldest pages were written back first
+    for (size_t i = 0; i < size / 2; i++) {
+        EXPECT_FALSE(bufferPool.isDirty({name, i}));
+    }
+    EXPECT_EQ(db.get(name).getWrites().size(), size - bufferPool.getNumDirty());
+}
+
+TEST(BufferPoolTest, failedRead) {
+    db::Database &db = db::getDatabase();
+    db::BufferPool &bufferPool = db.getBufferPool();
+    std::string name{"checksumfile.pool"};
+    std::remove(name.c_str());
+    std::remove((name + ".crc").c_str());
+    db::TupleDesc td;
+    db::DbFileOptions options;
+    options.checksums = true;
+    db.add(std::make_unique<db::DbFile>(name, td, options));
+    db::DbFile &file = db.get(name);
+    db::Page page;
+    page.fill(7);
+    file.writePages({{0, &page}, {1, &page}});
+
+    // corrupt page 1 on disk, so that reading it fails its checksum
+    int fd = open(name.c_str(), O_RDWR);
+    ASSERT_NE(fd, -1);
+    uint8_t byte = 9;
+    EXPECT_EQ(pwrite(fd, &byte, 1, db::DEFAULT_PAGE_SIZE + 100), 1);
+    close(fd);
+
+    // the page is not kept: every read fails again instead of blocking or returning an unread frame
+    for (int i = 0; i < 3; i++) {
+        EXPECT_THROW(bufferPool.getPage({name, 1}), std::runtime_error);
+        EXPECT_FALSE(bufferPool.contains({name, 1}));
+    }
+    EXPECT_THROW(bufferPool.prefetch(file.getId(), 0, 2), std::runtime_error);
+    EXPECT_FALSE(bufferPool.contains({name, 0}));
+    std::atomic<int> failures = 0;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 100; i++) {
+                try {
+                    db::PageView view(bufferPool, {name, 1});
+                } catch (const std::runtime_error &) {
+                    failures++;
+                }
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    EXPECT_EQ(failures, 800);
+
+    // no frame was lost: every frame can still be pinned
+    std::vector<db::Page *> pinned;
+    for (size_t i = 0; i < bufferPool.capacity(); i++) {
+        pinned.push_back(&bufferPool.pinPage({name, 2 + i}));
+    }
+    for (db::Page *p: pinned) {
+        bufferPool.unpinPage(*p);
+    }
+
+    // the page is read once it is repaired
+    file.writePage(page, 1);
+    EXPECT_EQ(bufferPool.getPage({name, 1}), page);
+    db.remove(name);
+    std::remove(name.c_str());
+    std::remove((name + ".crc").c_str());
+}
@@ -116,3 +116,43 @@ TEST(DatabaseTest, MultipleOperations) {
     db.add(std::move(file));
     EXPECT_EQ(expected, &db.get(name2));
 }
+
+TEST(DatabaseTest, FileIds) {
+    db::Database &db = db::getDatabase();
+    db::TupleDesc td;
+    size_t id = db.getId("ids");
+    EXPECT_EQ(db.getId("ids"), id);
+    EXPECT_NE(db.getId("other ids"), id);
+    EXPECT_ANY_THROW(db.get(id));
+
+    auto file = std::make_unique<db::DbFile>("ids", td);
+    db::DbFile *expected = file.get();
+    EXPECT_EQ(file->getId(), id);
+    db.add(std::move(file));
+    EXPECT_EQ(&db.get(id), expected);
+
+    // the id of a name survives its file
+    db.remove("ids");
+    EXPECT_ANY_THROW(db.get(id));
+    EXPECT_EQ(db.getId("ids"), id);
+    EXPECT_EQ(db::PageId("ids", 7), db::PageId(id, 7));
+    // page numbers are stored in 32 bits
+    EXPECT_EQ(db::PageId(id, UINT32_MAX).page, UINT32_MAX);
+    EXPECT_THROW(db::PageId(id, size_t{UINT32_MAX} + 1), std::out_of_range);
+    EXPECT_THROW(db::PageId("ids", size_t{1} << 32), std::out_of_range);
+}
+
+TEST(DatabaseTest, PageIdHash) {
+    // consecutive pages of a few files spread over the buckets of a small table
+    constexpr size_t buckets = 64;
+    std::array<size_t, buckets> counts{};
+    for (size_t file = 0; file < 4; file++) {
+        for (size_t page = 0; page < 16 * buckets; page++) {
+            counts[std::hash<const db::PageId>()({file, page}) % buckets]++;
+        }
+    }
+    for (size_t count: counts) {
+        EXPECT_GT(count, 32);
+        EXPECT_LT(count, 96);
+    }
+}
@@ -0,0 +1,40 @@
+#include <gtest/gtest.h>
+
+#include <db/PageTable.hpp>
+#include <random>
+#include <unordered_map>
+
+TEST(PageTableTest, InsertErase) {
+    db::PageTable table;
+    std::unordered_map<const db::PageId, size_t> expected;
+    std::mt19937 rng(660);
+    // few distinct pages and a mix of operations: long probe runs, updates, erasures and growth
+    for (size_t i = 0; i < 100000; i++) {
+        db::PageId pid{rng() % 4, rng() % 512};
+        if (rng() % 3 == 0) {
+            table.erase(pid);
+            expected.erase(pid);
+        } else {
+            table.insert(pid, i);
+            expected[pid] = i;
+        }
+    }
+    EXPECT_EQ(table.size(), expected.size());
+    for (size_t file = 0; file < 4; file++) {
+        for (size_t page = 0; page < 512; page++) {
+            auto it = expected.find({file, page});
+            if (it == expected.end()) {
+                EXPECT_FALSE(table.contains({file, page}));
+                EXPECT_THROW(table.at({file, page}), std::out_of_range);
+            } else {
+                EXPECT_EQ(table.at({file, page}), it->second);
+            }
+        }
+    }
+    size_t count = 0;
+    table.forEach([&](const db::PageId &pid, size_t pos) {
+        EXPECT_EQ(expected.at(pid), pos);
+        count++;
+    });
+    EXPECT_EQ(count, expected.size());
+}
@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+
+#include <db/BTreeFile.hpp>
+#include <db/Database.hpp>
+#include <db/ReplacementPolicy.hpp>
+
+static bool unpinned(size_t) { return true; }
+
+TEST(ReplacementPolicyTest, LRU) {
+    db::LruPolicy policy(4);
+    for (size_t i = 0; i < 4; i++) {
+        policy.insert(i, {"file", i});
+    }
+    EXPECT_EQ(policy.victim(unpinned), 0);
+    policy.access(0);
+    EXPECT_EQ(policy.victim(unpinned), 1);
+    policy.erase(1);
+    EXPECT_EQ(policy.victim(unpinned), 2);
+}
+
+TEST(ReplacementPolicyTest, CLOCK) {
+    db::ClockPolicy policy(4);
+    for (size_t i = 0; i < 4; i++) {
+        policy.insert(i, {"file", i});
+    }
+    // every page has its reference bit set: the hand clears them all and comes back to the first frame
+    EXPECT_EQ(policy.victim(unpinned), 0);
+    policy.erase(0);
+    policy.insert(0, {"file", 4});
+    policy.access(2);
+    // frame 1 has been cleared by the previous sweep, frame 2 gets a second chance
+    EXPECT_EQ(policy.victim(unpinned), 1);
+    policy.erase(1);
+    EXPECT_EQ(policy.victim(unpinned), 3);
+}
+
+TEST(ReplacementPolicyTest, TWO_Q) {
+    db::TwoQPolicy policy(8);
+    for (size_t i = 0; i < 8; i++) {
+        policy.insert(i, {"file", i});
+    }
+    // pages referenced once are evicted in FIFO order, even if they are accessed again while resident
+    policy.access(0);
+    EXPECT_EQ(policy.victim(unpinned), 0);
+    policy.evict(0);
+
+    // a page evicted recently from A1in is admitted to Am when it is read again
+    policy.insert(0, {"file", 0});
+    for (size_t i = 1; i < 8; i++) {
+        EXPECT_EQ(policy.victim(unpinned), i);
+        policy.evict(i);
+        policy.insert(i, {"file", 100 + i});
+    }
+    EXPECT_EQ(policy.victim(unpinned), 1);
+}
+
+TEST(ReplacementPolicyTest, TWO_Q_Erase) {
+    db::TwoQPolicy policy(8);
+    for (size_t i = 0; i < 8; i++) {
+        policy.insert(i, {"file", i});
+    }
+    // a page that is discarded (or moved to another frame) is not evicted: it is admitted to A1in again
+    policy.erase(0);
+    policy.insert(0, {"file", 0});
+    for (size_t i = 1; i < 8; i++) {
+        EXPECT_EQ(policy.victim(unpinned), i);
+        policy.evict(i);
+        policy.insert(i, {"file", 100 + i});
+    }
+    EXPECT_EQ(policy.victim(unpinned), 0);
+}
+
+TEST(ReplacementPolicyTest, LRU_K) {
+    db::LruKPolicy policy(2);
+    for (size_t i = 0; i < 4; i++) {
+        policy.insert(i, {"file", i});
+    }
+    policy.access(0);
+    policy.access(1);
+    // pages with a single access go first, least recently used first
+    EXPECT_EQ(policy.victim(unpinned), 2);
+    policy.erase(2);
+    EXPECT_EQ(policy.victim(unpinned), 3);
+    policy.erase(3);
+    // page 0 has the oldest second most recent access
+    EXPECT_EQ(policy.victim(unpinned), 0);
+    policy.access(0);
+    policy.access(0);
+    EXPECT_EQ(policy.victim(unpinned), 1);
+}
+
+static size_t rootReadsDuringScan(db::ReplacementPolicyType type) {
+    const char *index_name = "index.db";
+    const char *scan_name = "scan.db";
+    std::remove(index_name);
+    std::remove(scan_name);
+    db::Database &db = db::getDatabase();
+    db::BufferPool &bufferPool = db.getBufferPool();
+    db::TupleDesc td({db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE}, {"id", "name", "price"});
+    db.add(std::make_unique<db::BTreeFile>(index_name, td, 0));
+    db.add(std::make_unique<db::DbFile>(scan_name, db::TupleDesc()));
+    auto &index = db.get(index_name);
+    for (int i = 0; i < 2000; i++) {
+        index.insertTuple(db::Tuple({i, "apple", 1.0}));
+    }
+    bufferPool.setReplacementPolicy(type);
+
+    // interleave lookups with a scan
+    size_t scan_page = 0;
+    for (size_t round = 0; round < 10; round++) {
+        index.begin();
+        for (size_t i = 0; i < 10; i++) {
+            bufferPool.getPage({scan_name, scan_page++});
+        }
+    }
+    const auto &reads = index.getReads();
+    size_t warm = std::count(reads.begin(), reads.end(), 0);
+    for (size_t round = 0; round < 10; round++) {
+        index.begin();
+        for (size_t i = 0; i < 4 * db::DEFAULT_NUM_PAGES; i++) {
+            bufferPool.getPage({scan_name, scan_page++});
+        }
+    }
+    return std::count(reads.begin(), reads.end(), 0) - warm;
+}
+
+TEST(ReplacementPolicyTest, ScanLRU) {
+    EXPECT_EQ(rootReadsDuringScan(db::ReplacementPolicyType::LRU), 9);
+}
+
+TEST(ReplacementPolicyTest, ScanTWO_Q) {
+    EXPECT_EQ(rootReadsDuringScan(db::ReplacementPolicyType::TWO_Q), 0);
+}
+
+TEST(ReplacementPolicyTest, ScanLRU_K) {
+    EXPECT_EQ(rootReadsDuringScan(db::ReplacementPolicyType::LRU_K), 0);
+}
@@ -0,0 +1,150 @@
+#include <db/Database.hpp>
+#include <db/FreeSpaceMap.hpp>
+#include <db/HeapFile.hpp>
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <set>
+
+TEST(FreeSpaceMapTest, Find) {
+    db::FreeSpaceMap fsm(3);
+    EXPECT_EQ(fsm.size(), 3);
+    EXPECT_EQ(fsm.find(1), db::FreeSpaceMap::npos);
+    fsm.set(2, 5);
+    fsm.set(1, 3);
+    EXPECT_EQ(fsm.find(1), 1);
+    EXPECT_EQ(fsm.find(4), 2);
+    EXPECT_EQ(fsm.find(6), db::FreeSpaceMap::npos);
+
+    // the map grows past its initial size
+    fsm.set(100, 200);
+    EXPECT_EQ(fsm.size(), 101);
+    EXPECT_EQ(fsm.get(2), 5);
+    EXPECT_EQ(fsm.find(6), 100);
+    fsm.set(1, 0);
+    fsm.set(2, 0);
+    EXPECT_EQ(fsm.find(1), 100);
+    fsm.set(100, 0);
+    EXPECT_EQ(fsm.find(1), db::FreeSpaceMap::npos);
+
+    const char *name = "fsm";
+    fsm.set(50, 7);
+    fsm.save(name);
+    db::FreeSpaceMap loaded;
+    EXPECT_FALSE(loaded.load(name, 100));  // stale
+    EXPECT_TRUE(loaded.load(name, 101));
+    EXPECT_EQ(loaded.find(1), 50);
+    std::remove(name);
+    EXPECT_FALSE(loaded.load(name, 101));
+}
+
+TEST(HeapFileTest, FreeSpaceReuse) {
+    db::TupleDesc td({db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE}, {"id", "name", "price"});
+    constexpr int pages = 10;
+    for (db::PageFormat format: {db::PageFormat::FIXED, db::PageFormat::SLOTTED}) {
+        // pages of a removed file stay in the buffer pool, so each format gets its own file
+        std::string name = format == db::PageFormat::FIXED ? "heapfile" : "slottedfile";
+        std::remove(name.c_str());
+        db::DbFileOptions options;
+        options.format = format;
+        db::getDatabase().add(std::make_unique<db::HeapFile>(name, td, options));
+        auto &file = db::getDatabase().get(name);
+        std::string label(64, 'x');
+        int inserted = 0;
+        while (file.getNumPages() <= pages) {
+            file.insertTuple({{inserted++, label, 0.0}});
+        }
+        size_t numPages = file.getNumPages();
+
+        // delete every other tuple, then insert as many: the freed slots are reused
+        int deleted = 0;
+        for (auto it = file.begin(); it != file.end(); ++it) {
+            if (std::get<int>((*it).get_field(0)) % 2 == 0) {
+                file.deleteTuple(it);
+                deleted++;
+            }
+        }
+        for (int i = 0; i < deleted; i++) {
+            file.insertTuple({{-1, label, 0.0}});
+        }
+        EXPECT_EQ(file.getNumPages(), numPages);
+
+        // the map is saved with the file, so the free space is known when the file is opened again
+        for (auto it = file.begin(); it != file.end(); ++it) {
+            if (std::get<int>((*it).get_field(0)) == 1) {
+                file.deleteTuple(it);
+            }
+        }
+        db::getDatabase().remove(name);
+        db::getDatabase().add(std::make_unique<db::HeapFile>(name, td, options));
+        auto &reopened = db::getDatabase().get(name);
+        reopened.insertTuple({{-2, label, 0.0}});
+        EXPECT_EQ(reopened.getNumPages(), numPages);
+        auto it = reopened.begin();
+        EXPECT_EQ(std::get<int>((*it).get_field(0)), -1);
+        ++it;
+        EXPECT_EQ(std::get<int>((*it).get_field(0)), -2);
+        db::getDatabase().remove(name);
+    }
+}
+
+TEST(HeapFileTest, Vacuum) {
+    db::TupleDesc td({db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE}, {"id", "name", "price"});
+    for (db::PageFormat format: {db::PageFormat::FIXED, db::PageFormat::SLOTTED}) {
+        std::string name = format == db::PageFormat::FIXED ? "heapfile" : "slottedfile";
+        std::remove(name.c_str());
+        db::DbFileOptions options;
+        options.format = format;
+        db::getDatabase().add(std::make_unique<db::HeapFile>(name, td, options));
+        auto *file = &dynamic_cast<db::HeapFile &>(db::getDatabase().get(name));
+        std::string label(64, 'x');
+        int inserted = 0;
+        while (file->getNumPages() < 20) {
+            file->insertTuple({{inserted++, label, 0.0}});
+        }
+        if (format == db::PageFormat::SLOTTED) {
+            file->insertTuple({{inserted++, std::string(db::DEFAULT_PAGE_SIZE, 'y'), 0.0}});
+        }
+        std::multiset<int> kept;
+        for (auto it = file->begin(); it != file->end(); ++it) {
+            int id = std::get<int>((*it).get_field(0));
+            if (id % 4 == 0) {
+                kept.insert(id);
+            } else {
+                file->deleteTuple(it);
+            }
+        }
+        size_t numPages = file->getNumPages();
+
+        // the free space of the pages is recomputed when the map is missing
+        db::getDatabase().remove(name);
+        std::remove((name + ".fsm").c_str());
+        db::getDatabase().add(std::make_unique<db::HeapFile>(name, td, options));
+        file = &dynamic_cast<db::HeapFile &>(db::getDatabase().get(name));
+
+        EXPECT_EQ(file->vacuum(2), 2);
+        EXPECT_EQ(file->getNumPages(), numPages - 2);
+        size_t removed = 2;
+        while (size_t step = file->vacuum(2)) {
+            EXPECT_LE(step, 2);
+            removed += step;
+        }
+        EXPECT_EQ(file->getNumPages(), numPages - removed);
+        EXPECT_EQ(std::filesystem::file_size(name), file->getNumPages() * db::DEFAULT_PAGE_SIZE);
+        if (format == db::PageFormat::FIXED) {
+            EXPECT_EQ(file->getNumPages(), (kept.size() + 52) / 53);
+        } else {
+            EXPECT_LT(file->getNumPages(), numPages / 2);
+        }
+
+        std::multiset<int> found;
+        for (const auto &t: *file) {
+            found.insert(std::get<int>(t.get_field(0)));
+            if (std::get<int>(t.get_field(0)) == inserted - 1 && format == db::PageFormat::SLOTTED) {
+                EXPECT_EQ(std::get<std::string>(t.get_field(1)), std::string(db::DEFAULT_PAGE_SIZE, 'y'));
+            }
+        }
+        EXPECT_EQ(found, kept);
+        EXPECT_EQ(file->vacuum(), 0);
+        db::getDatabase().remove(name);
+    }
+}
@@ -1,7 +1,12 @@
+#include <db/BTreeFile.hpp>
 #include <db/Database.hpp>
 #include <db/HeapPage.hpp>
 #include <db/HeapFile.hpp>
+#include <db/PaxPage.hpp>
 #include <gtest/gtest.h>
+#include <cstring>
+#include <filesystem>
+#include <thread>
 
 TEST(HeapPageTest, EmptyPage) {
     db::Page page{};
@@ -156,12 +161,12 @@ TEST(HeapFileTest, InsertTuple) {
     auto &file = db::getDatabase().get(name);
     EXPECT_EQ(file.begin(), file.end());
     constexpr size_t capacity = 53;
-    for (int i = 0; i < capacity * 3; ++i) {
-        file.insertTuple({{i, "Hello", 3.14}});
+    for (size_t i = 0; i < capacity * 3; ++i) {
+        file.insertTuple({{static_cast<int>(i), "Hello", 3.14}});
     }
 
     auto it = file.begin();
-    for (int i = 0; i < capacity * 3; i += 2) {
+    for (size_t i = 0; i < capacity * 3; i += 2) {
         it.page = i / capacity;
         it.slot = i % capacity;
         file.deleteTuple(it);
@@ -184,17 +189,17 @@ TEST(HeapFileTest, EmptyPage) {
     db::getDatabase().add(std::make_unique<db::HeapFile>(name, td));
     auto &file = db::getDatabase().get(name);
     constexpr size_t capacity = 53;
-    for (int i = 0; i < capacity; ++i) {
-        file.insertTuple({{i, "Hello", 3.14}});
+    for (size_t i = 0; i < capacity; ++i) {
+        file.insertTuple({{static_cast<int>(i), "Hello", 3.14}});
         EXPECT_EQ(file.getNumPages(), 1);
     }
-    for (int i = capacity; i < capacity + capacity; ++i) {
-        file.insertTuple({{i, "Hello", 3.14}});
+    for (size_t i = capacity; i < capacity + capacity; ++i) {
+        file.insertTuple({{static_cast<int>(i), "Hello", 3.14}});
         EXPECT_EQ(file.getNumPages(), 2);
     }
 
     auto it = file.begin();
-    for (int i = 0; i < capacity; ++i) {
+    for (size_t i = 0; i < capacity; ++i) {
         it.slot = i;
         file.deleteTuple(it);
         EXPECT_EQ(file.getNumPages(), 2);
@@ -207,3 +212,694 @@ TEST(HeapFileTest, EmptyPage) {
         i++;
     }
 }
+
+TEST(HeapFileTest, ConcurrentScan) {
+    std::vector<db::type_t> types{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};
+    std::vector<std::string> names{"id", "name", "price"};
+    db::TupleDesc td(types, names);
+
+    const char *name = "heapfile";
+    std::remove(name);
+    db::getDatabase().add(std::make_unique<db::HeapFile>(name, td));
+    auto &file = db::getDatabase().get(name);
+    constexpr int size = 53 * 4 * db::DEFAULT_NUM_PAGES;
+    for (int i = 0; i < size; ++i) {
+        file.insertTuple({{i, "Hello", 3.14}});
+    }
+
+    constexpr size_t num_threads = 4;
+    std::vector<long> sums(num_threads);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; t++) {
+        threads.emplace_back([&file, &sums, t] {
+            for (const auto &tuple: file) {
+                sums[t] += std::get<int>(tuple.get_field(0));
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    for (const long &sum: sums) {
+        EXPECT_EQ(sum, long(size) * (size - 1) / 2);
+    }
+}
+
+TEST(HeapFileTest, ReadAhead) {
+    std::vector<db::type_t> types{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};
+    std::vector<std::string> names{"id", "name", "price"};
+    db::TupleDesc td(types, names);
+
+    const char *name = "heapfile";
+    std::remove(name);
+    db::getDatabase().add(std::make_unique<db::HeapFile>(name, td));
+    auto &file = db::getDatabase().get(name);
+    constexpr size_t capacity = 53;
+    constexpr size_t pages = 2 * db::DEFAULT_NUM_PAGES;
+    for (size_t i = 0; i < capacity * pages; ++i) {
+        file.insertTuple({{static_cast<int>(i), "Hello", 3.14}});
+    }
+    db::BufferPool &bufferPool = db::getDatabase().getBufferPool();
+    bufferPool.flushFile(name);
+    for (size_t page = 0; page < pages; page++) {
+        if (bufferPool.contains({name, page})) {
+            bufferPool.discardPage({name, page});
+        }
+    }
+    size_t reads = file.getReads().size();
+
+    auto it = file.begin();
+    while (it.page < db::READAHEAD_TRIGGER) {
+        ++it;
+    }
+    // the scan is sequential: the following pages are already in the buffer pool
+    EXPECT_TRUE(bufferPool.contains({name, it.page + 1}));
+    EXPECT_TRUE(bufferPool.contains({name, it.page + db::DEFAULT_NUM_PAGES / 4}));
+
+    int i = it.page * capacity;
+    for (; it != file.end(); ++it) {
+        EXPECT_EQ(std::get<int>((*it).get_field(0)), i);
+        i++;
+    }
+    EXPECT_EQ(i, capacity * pages);
+    // every page was read exactly once
+    EXPECT_EQ(file.getReads().size() - reads, pages);
+}
+
+TEST(HeapFileTest, ReadAheadInterleaved) {
+    std::vector<db::type_t> types{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};
+    std::vector<std::string> names{"id", "name", "price"};
+    db::TupleDesc td(types, names);
+
+    const char *name = "heapfile";
+    std::remove(name);
+    db::getDatabase().add(std::make_unique<db::HeapFile>(name, td));
+    auto &file = db::getDatabase().get(name);
+    constexpr size_t capacity = 53;
+    constexpr size_t pages = 2 * db::DEFAULT_NUM_PAGES;
+    for (size_t i = 0; i < capacity * pages; ++i) {
+        file.insertTuple({{static_cast<int>(i), "Hello", 3.14}});
+    }
+    db::BufferPool &bufferPool = db::getDatabase().getBufferPool();
+    bufferPool.flushFile(name);
+    for (size_t page = 0; page < pages; page++) {
+        if (bufferPool.contains({name, page})) {
+            bufferPool.discardPage({name, page});
+        }
+    }
+
+    // two scans entering the same pages in turn are both sequential
+    auto first = file.begin();
+    auto second = file.begin();
+    for (size_t page = 1; page <= db::READAHEAD_TRIGGER; page++) {
+        for (auto *it: {&first, &second}) {
+            while (it->page < page) {
+                ++*it;
+            }
+        }
+    }
+    EXPECT_TRUE(bufferPool.contains({name, db::READAHEAD_TRIGGER + db::DEFAULT_NUM_PAGES / 4}));
+    db::getDatabase().remove(name);
+}
+
+TEST(HeapFileTest, Mapped) {
+    std::vector<db::type_t> types{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};
+    std::vector<std::string> names{"id", "name", "price"};
+    db::TupleDesc td(types, names);
+
+    const char *name = "heapfile";
+    std::remove(name);
+    db::getDatabase().add(std::make_unique<db::HeapFile>(name, td));
+    constexpr size_t capacity = 53;
+    constexpr size_t pages = 10;
+    for (size_t i = 0; i < capacity * pages; ++i) {
+        db::getDatabase().get(name).insertTuple({{static_cast<int>(i), "Hello", 3.14}});
+    }
+    db::getDatabase().remove(name);
+
+    db::DbFileOptions options;
+    options.mmap = true;
+    db::getDatabase().add(std::make_unique<db::HeapFile>(name, td, options));
+    auto &file = db::getDatabase().get(name);
+    EXPECT_TRUE(file.isMapped());
+    EXPECT_EQ(file.getNumPages(), pages);
+    size_t i = 0;
+    for (const auto &t: file) {
+        EXPECT_EQ(std::get<int>(t.get_field(0)), static_cast<int>(i));
+        i++;
+    }
+    EXPECT_EQ(i, capacity * pages);
+    // the pages are read in place, not through the buffer pool
+    EXPECT_TRUE(file.getReads().empty());
+    EXPECT_THROW(file.insertTuple({{0, "Hello", 3.14}}), std::logic_error);
+
+    // a page appended by another writer is seen by the next scan
+    {
+        db::DbFile writer(name, td);
+        db::Page page{};
+        db::HeapPage hp(page, td);
+        hp.insertTuple({{-1, "Hello", 3.14}});
+        writer.writePage(page, pages);
+    }
+    i = 0;
+    for (const auto &t: file) {
+        EXPECT_EQ(std::get<int>(t.get_field(0)), i < capacity * pages ? static_cast<int>(i) : -1);
+        i++;
+    }
+    EXPECT_EQ(i, capacity * pages + 1);
+    EXPECT_EQ(file.getNumPages(), pages + 1);
+}
+
+TEST(HeapFileTest, TupleView) {
+    std::vector<db::type_t> types{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};
+    std::vector<std::string> names{"id", "name", "price"};
+    db::TupleDesc td(types, names);
+
+    const char *name = "heapfile";
+    std::remove(name);
+    db::getDatabase().add(std::make_unique<db::HeapFile>(name, td));
+    auto &file = db::getDatabase().get(name);
+    // a CHAR field that fills all CHAR_SIZE bytes has no terminating NUL
+    std::string full(db::CHAR_SIZE, 'x');
+    for (int i = 0; i < 100; ++i) {
+        file.insertTuple({{i, i % 2 ? "Hello" : full, i * 0.5}});
+    }
+
+    int i = 0;
+    for (auto it = file.begin(); it != file.end(); ++it) {
+        db::TupleView view = it.view();
+        EXPECT_EQ(view.get_int(0), i);
+        EXPECT_EQ(view.get_string_view(1), i % 2 ? "Hello" : full);
+        EXPECT_EQ(view.get_double(2), i * 0.5);
+        EXPECT_THROW(view.get_int(2), std::logic_error);
+        db::Tuple t = view.materialize();
+        EXPECT_TRUE(td.compatible(t));
+        EXPECT_EQ(std::get<std::string>(t.get_field(1)), i % 2 ? "Hello" : full);
+        i++;
+    }
+    EXPECT_EQ(i, 100);
+}
+
+TEST(SlottedPageTest, InsertDelete) {
+    db::Page page{};
+    db::TupleDesc td({db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE}, {"id", "name", "price"});
+    db::SlottedPage sp(page, td);
+    EXPECT_EQ(sp.begin(), sp.end());
+    EXPECT_FALSE(sp.isOverflow());
+
+    // a record takes 4 + 4 + 8 bytes, the string and a 4-byte slot
+    std::string name(12, 'a');
+    size_t capacity = (db::DEFAULT_PAGE_SIZE - db::SlottedPage::HEADER_SIZE) / (16 + name.size() + 4);
+    for (size_t i = 0; i < capacity; i++) {
+        EXPECT_TRUE(sp.insertTuple({{static_cast<int>(i), name, i * 0.5}}));
+    }
+    EXPECT_FALSE(sp.insertTuple({{0, name, 0.0}}));
+    EXPECT_EQ(sp.end(), capacity);
+    EXPECT_GT(capacity, db::DEFAULT_PAGE_SIZE / td.length() * 2);
+
+    db::Tuple t = sp.getTuple(7);
+    EXPECT_EQ(std::get<int>(t.get_field(0)), 7);
+    EXPECT_EQ(std::get<std::string>(t.get_field(1)), name);
+    EXPECT_EQ(std::get<double>(t.get_field(2)), 3.5);
+
+    // the space of deleted records is reused for a longer string once the page is compacted
+    for (size_t slot = 0; slot < 10; slot++) {
+        sp.deleteTuple(slot);
+    }
+    EXPECT_THROW(sp.deleteTuple(0), std::runtime_error);
+    EXPECT_EQ(sp.begin(), 10);
+    std::string longer(150, 'b');
+    EXPECT_TRUE(sp.insertTuple({{-1, longer, 0.0}}));
+    EXPECT_EQ(sp.begin(), 0);
+    EXPECT_EQ(std::get<std::string>(sp.getTuple(0).get_field(1)), longer);
+    EXPECT_EQ(std::get<std::string>(sp.getTuple(capacity - 1).get_field(1)), name);
+
+    // trailing empty slots are removed from the directory
+    sp.deleteTuple(capacity - 1);
+    EXPECT_EQ(sp.end(), capacity - 1);
+
+    db::Page overflow{};
+    db::SlottedPage op(overflow, td);
+    op.makeOverflow("Hello", 3);
+    EXPECT_TRUE(op.isOverflow());
+    EXPECT_EQ(op.begin(), op.end());
+    EXPECT_FALSE(op.insertTuple({{0, name, 0.0}}));
+    size_t next;
+    EXPECT_EQ(op.readOverflow(next), "Hello");
+    EXPECT_EQ(next, 3);
+    EXPECT_THROW(sp.readOverflow(next), std::runtime_error);
+}
+
+TEST(HeapFileTest, Slotted) {
+    std::vector<db::type_t> types{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};
+    std::vector<std::string> names{"id", "name", "price"};
+    db::TupleDesc td(types, names);
+
+    const char *name = "heapfile";
+    std::remove(name);
+    db::DbFileOptions options;
+    options.format = db::PageFormat::SLOTTED;
+    db::getDatabase().add(std::make_unique<db::HeapFile>(name, td, options));
+    auto &file = db::getDatabase().get(name);
+    // strings are neither padded nor truncated
+    constexpr int count = 1000;
+    for (int i = 0; i < count; ++i) {
+        file.insertTuple({{i, "label" + std::to_string(i), i * 0.5}});
+    }
+    // 1000 tuples take 19 pages with fixed-size slots
+    EXPECT_LE(file.getNumPages(), 7);
+
+    // long strings go to overflow pages
+    std::string huge(2 * db::DEFAULT_PAGE_SIZE, 'x');
+    auto label = [&](int i) { return i < count ? "label" + std::to_string(i) : huge; };
+    for (int i = count; i < count + 10; ++i) {
+        file.insertTuple({{i, huge, i * 0.5}});
+    }
+
+    int i = 0;
+    for (auto it = file.begin(); it != file.end(); ++it) {
+        db::TupleView view = it.view();
+        EXPECT_EQ(view.get_int(0), i);
+        EXPECT_EQ(view.get_string_view(1), label(i));
+        EXPECT_EQ(view.get_double(2), i * 0.5);
+        db::Tuple t = *it;
+        EXPECT_EQ(std::get<std::string>(t.get_field(1)), label(i));
+        i++;
+    }
+    EXPECT_EQ(i, count + 10);
+
+    // deleting a tuple zeroes its overflow pages, which are then skipped as empty pages
+    for (auto it = file.begin(); it != file.end(); ++it) {
+        if (std::get<int>((*it).get_field(0)) >= count) {
+            file.deleteTuple(it);
+        }
+    }
+    i = 0;
+    for (const auto &t: file) {
+        EXPECT_EQ(std::get<int>(t.get_field(0)), i);
+        i++;
+    }
+    EXPECT_EQ(i, count);
+    db::getDatabase().remove(name);
+}
+
+TEST(HeapFileTest, SlottedTooLarge) {
+    // Every string goes to an overflow page, but the references alone do not fit in a page
+    constexpr size_t fields = 600;
+    std::vector<db::type_t> types(fields, db::type_t::CHAR);
+    std::vector<std::string> names;
+    for (size_t i = 0; i < fields; ++i) {
+        names.push_back("s" + std::to_string(i));
+    }
+    db::TupleDesc td(types, names);
+
+    const char *name = "slottedfile";
+    std::remove(name);
+    std::remove((std::string(name) + ".fsm").c_str());
+    db::DbFileOptions options;
+    options.format = db::PageFormat::SLOTTED;
+    db::getDatabase().add(std::make_unique<db::HeapFile>(name, td, options));
+    auto &file = db::getDatabase().get(name);
+    EXPECT_THROW(file.insertTuple(db::Tuple(std::vector<db::field_t>(fields, std::string(20, 'x')))),
+                 std::length_error);
+    EXPECT_EQ(file.begin(), file.end());
+
+    // The overflow pages written for the tuple are freed
+    db::getDatabase().getBufferPool().flushFile(name);
+    db::Page page;
+    for (size_t i = 0; i < file.getNumPages(); ++i) {
+        file.readPage(page, i);
+        EXPECT_FALSE(db::SlottedPage(page, td).isOverflow());
+    }
+    db::getDatabase().remove(name);
+    std::remove(name);
+    std::remove((std::string(name) + ".fsm").c_str());
+}
+
+TEST(HeapPageTest, InsertHint) {
+    db::TupleDesc td({db::type_t::INT}, {"id"});
+    db::Page page{};
+    db::HeapPage hp(page, td);
+    // 1008 slots: the header spans 16 words, and the last one is partial
+    constexpr size_t capacity = db::DEFAULT_PAGE_SIZE * 8 / (db::INT_SIZE * 8 + 1);
+    EXPECT_EQ(hp.end(), capacity);
+    size_t hint = 0;
+    for (size_t i = 0; i < capacity; i++) {
+        EXPECT_TRUE(hp.insertTuple({{static_cast<int>(i)}}, hint));
+        EXPECT_EQ(hint, i + 1);
+    }
+    EXPECT_FALSE(hp.insertTuple({{-1}}, hint));
+    EXPECT_EQ(hint, capacity);
+
+    // slots freed in different words are found again, in order
+    const std::vector<size_t> freed{5, 63, 64, 700, capacity - 1};
+    for (size_t slot: freed) {
+        hp.deleteTuple(slot);
+    }
+    size_t count = 0;
+    for (size_t slot = hp.begin(); slot != hp.end(); hp.next(slot)) {
+        EXPECT_EQ(std::get<int>(hp.getTuple(slot).get_field(0)), slot);
+        count++;
+    }
+    EXPECT_EQ(count, capacity - 5);
+    hint = 0;
+    for (size_t slot: freed) {
+        EXPECT_TRUE(hp.insertTuple({{-1}}, hint));
+        EXPECT_EQ(hint, slot + 1);
+    }
+    EXPECT_FALSE(hp.insertTuple({{-1}}));
+}
+
+TEST(HeapFileTest, InsertBatch) {
+    std::vector<db::type_t> types{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};
+    std::vector<std::string> names{"id", "name", "price"};
+    db::TupleDesc td(types, names);
+    constexpr size_t capacity = 53;
+
+    const char *name = "heapfile";
+    std::remove(name);
+    db::getDatabase().add(std::make_unique<db::HeapFile>(name, td));
+    auto &file = dynamic_cast<db::HeapFile &>(db::getDatabase().get(name));
+    db::BufferPool &bufferPool = db::getDatabase().getBufferPool();
+
+    std::vector<db::Tuple> tuples;
+    for (int i = 0; i < 1000; ++i) {
+        tuples.push_back({{i, "Hello", i * 0.5}});
+    }
+    file.insertBatch(tuples);
+    // the empty first page is filled too, and the pages are written without going through the buffer pool
+    constexpr size_t pages = (1000 + capacity - 1) / capacity;
+    EXPECT_EQ(file.getNumPages(), pages);
+    EXPECT_EQ(file.getWrites().size(), pages);
+    for (size_t page = 0; page < pages; page++) {
+        EXPECT_FALSE(bufferPool.contains({file.getId(), page}));
+    }
+
+    // serialized tuples start on a new page
+    std::vector<uint8_t> data(500 * td.length());
+    for (int i = 0; i < 500; ++i) {
+        td.serialize(data.data() + i * td.length(), {{1000 + i, "World", 0.0}});
+    }
+    file.insertBatch(data.data(), 500);
+    EXPECT_EQ(file.getNumPages(), pages + (500 + capacity - 1) / capacity);
+    EXPECT_THROW(file.insertBatch(std::vector<db::Tuple>{{{0, 0, 0}}}), std::runtime_error);
+
+    int i = 0;
+    for (const auto &t: file) {
+        EXPECT_EQ(std::get<int>(t.get_field(0)), i);
+        EXPECT_EQ(std::get<std::string>(t.get_field(1)), i < 1000 ? "Hello" : "World");
+        i++;
+    }
+    EXPECT_EQ(i, 1500);
+    // single inserts fill the last page first
+    file.insertTuple({{1500, "Hello", 0.0}});
+    EXPECT_EQ(file.getNumPages(), pages + (500 + capacity - 1) / capacity);
+    db::getDatabase().remove(name);
+
+    // slotted pages, with a tuple whose string goes to overflow pages
+    const char *slotted = "slottedfile";
+    std::remove(slotted);
+    db::DbFileOptions options;
+    options.format = db::PageFormat::SLOTTED;
+    db::getDatabase().add(std::make_unique<db::HeapFile>(slotted, td, options));
+    auto &sfile = dynamic_cast<db::HeapFile &>(db::getDatabase().get(slotted));
+    std::string huge(db::DEFAULT_PAGE_SIZE, 'x');
+    tuples[500] = {{500, huge, 0.0}};
+    sfile.insertBatch(tuples);
+    i = 0;
+    for (const auto &t: sfile) {
+        EXPECT_EQ(std::get<int>(t.get_field(0)), i);
+        EXPECT_EQ(std::get<std::string>(t.get_field(1)), i == 500 ? huge : "Hello");
+        i++;
+    }
+    EXPECT_EQ(i, 1000);
+    db::getDatabase().remove(slotted);
+}
+
+TEST(PaxPageTest, InsertGet) {
+    db::TupleDesc td({db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE}, {"id", "name", "price"});
+    db::Page page{};
+    db::PaxPage pax(page, td);
+    size_t capacity = pax.end();
+    EXPECT_EQ(capacity, db::HeapPage(page, td).end());
+    for (size_t i = 0; i < capacity; i++) {
+        EXPECT_TRUE(pax.insertTuple({{static_cast<int>(i), "name" + std::to_string(i), i * 0.5}}));
+    }
+    EXPECT_FALSE(pax.insertTuple({{0, "", 0.0}}));
+    pax.deleteTuple(3);
+    EXPECT_EQ(pax.freeSlots(), 1);
+
+    // the values of a field are contiguous
+    for (size_t slot = 0; slot < capacity; slot++) {
+        int id;
+        std::memcpy(&id, pax.column(0) + slot * db::INT_SIZE, db::INT_SIZE);
+        EXPECT_EQ(id, slot);
+        double price;
+        std::memcpy(&price, pax.column(2) + slot * db::DOUBLE_SIZE, db::DOUBLE_SIZE);
+        EXPECT_EQ(price, slot * 0.5);
+    }
+    db::Tuple t = pax.getTuple(4);
+    EXPECT_EQ(t.get_field(0), db::field_t(4));
+    EXPECT_EQ(t.get_field(1), db::field_t("name4"));
+    EXPECT_EQ(t.get_field(2), db::field_t(2.0));
+    EXPECT_THROW(pax.getTuple(3), std::runtime_error);
+
+    // serialized tuples are transposed
+    std::vector<uint8_t> data(2 * td.length());
+    td.serialize(data.data(), {{7, "a", 1.0}});
+    td.serialize(data.data() + td.length(), {{8, "b", 2.0}});
+    EXPECT_THROW(pax.fill(data.data(), 2), std::logic_error);
+    db::Page other{};
+    db::PaxPage filled(other, td);
+    EXPECT_EQ(filled.fill(data.data(), 2), 2);
+    EXPECT_EQ(filled.getTuple(1).get_field(1), db::field_t("b"));
+    EXPECT_EQ(filled.freeSlots(), capacity - 2);
+}
+
+TEST(HeapFileTest, Pax) {
+    db::TupleDesc td({db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE}, {"id", "name", "price"});
+    const char *name = "paxfile";
+    std::remove(name);
+    db::DbFileOptions options;
+    options.format = db::PageFormat::PAX;
+    db::getDatabase().add(std::make_unique<db::HeapFile>(name, td, options));
+    auto &file = dynamic_cast<db::HeapFile &>(db::getDatabase().get(name));
+    for (int i = 0; i < 200; i++) {
+        file.insertTuple({{i, "Hello", i * 0.5}});
+    }
+    std::vector<uint8_t> data(100 * td.length());
+    for (int i = 0; i < 100; i++) {
+        td.serialize(data.data() + i * td.length(), {{200 + i, "World", i * 0.5}});
+    }
+    file.insertBatch(data.data(), 100);
+    EXPECT_EQ(file.getNumPages(), 4 + 2);
+
+    int i = 0;
+    for (auto it = file.begin(); it != file.end(); ++it, ++i) {
+        EXPECT_EQ((*it).get_field(0), db::field_t(i));
+        db::TupleView view = it.view();
+        EXPECT_EQ(view.get_int(0), i);
+        EXPECT_EQ(view.get_string_view(1), i < 200 ? "Hello" : "World");
+        EXPECT_EQ(view.get_double(2), (i < 200 ? i : i - 200) * 0.5);
+    }
+    EXPECT_EQ(i, 300);
+
+    // deleted slots are reused, and the file is compacted like a file of PageFormat::FIXED
+    for (auto it = file.begin(); it != file.end(); ++it) {
+        if (std::get<int>((*it).get_field(0)) % 3 != 0) {
+            file.deleteTuple(it);
+        }
+    }
+    EXPECT_EQ(file.vacuum(), 4);
+    int sum = 0;
+    size_t count = 0;
+    file.scan([&](const db::TupleView &t) {
+        sum += t.get_int(0);
+        count++;
+    });
+    EXPECT_EQ(count, 100);
+    EXPECT_EQ(sum, 3 * (99 * 100 / 2));
+
+    // a scan of some fields only reads those
+    double total = 0;
+    sum = 0;
+    count = 0;
+    file.scan({0, 2}, [&](const db::TupleView &t) {
+        sum += t.get_int(0);
+        total += t.get_double(2);
+        count++;
+    });
+    EXPECT_EQ(count, 100);
+    EXPECT_EQ(sum, 3 * (99 * 100 / 2));
+    double expected = 0;
+    for (int id = 0; id < 300; id += 3) {
+        expected += (id < 200 ? id : id - 200) * 0.5;
+    }
+    EXPECT_EQ(total, expected);
+    db::getDatabase().remove(name);
+}
+
+TEST(HeapFileTest, Compressed) {
+    db::TupleDesc td({db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE}, {"id", "name", "price"});
+    const char *name = "compressedheapfile";
+    std::remove(name);
+    std::remove((std::string(name) + ".fsm").c_str());
+    db::DbFileOptions options;
+    options.compressed = true;
+    std::vector<db::Tuple> tuples;
+    for (int i = 0; i < 5000; i++) {
+        tuples.push_back({{i, "name" + std::to_string(i % 100), i * 0.25}});
+    }
+    db::getDatabase().add(std::make_unique<db::HeapFile>(name, td, options));
+    auto &file = dynamic_cast<db::HeapFile &>(db::getDatabase().get(name));
+    file.insertBatch(tuples);
+    // pages written through the buffer pool are compressed when they are flushed
+    file.insertTuple({{5000, "last", 0.0}});
+    size_t numPages = file.getNumPages();
+    db::getDatabase().remove(name);
+    EXPECT_LT(std::filesystem::file_size(name), numPages * db::DEFAULT_PAGE_SIZE / 3);
+
+    // the pages of the removed file are still in the buffer pool: evict them to read the file again
+    db::BufferPool &bufferPool = db::getDatabase().getBufferPool();
+    db::getDatabase().add(std::make_unique<db::HeapFile>(name, td, options));
+    auto &reopened = db::getDatabase().get(name);
+    for (size_t page = 0; page < numPages; page++) {
+        if (bufferPool.contains({reopened.getId(), page})) {
+            bufferPool.discardPage({reopened.getId(), page});
+        }
+    }
+    EXPECT_EQ(reopened.getNumPages(), numPages);
+    int i = 0;
+    for (const auto &t: reopened) {
+        EXPECT_EQ(std::get<int>(t.get_field(0)), i);
+        EXPECT_EQ(std::get<std::string>(t.get_field(1)), i < 5000 ? "name" + std::to_string(i % 100) : "last");
+        i++;
+    }
+    EXPECT_EQ(i, 5001);
+    db::getDatabase().remove(name);
+    std::remove(name);
+    std::remove((std::string(name) + ".fsm").c_str());
+}
+
+TEST(HeapFileTest, SecondaryIndex) {
+    std::vector<db::type_t> types{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};
+    std::vector<std::string> names{"id", "name", "price"};
+    db::TupleDesc td(types, names);
+
+    for (db::PageFormat format: {db::PageFormat::FIXED, db::PageFormat::SLOTTED}) {
+        std::string name = format == db::PageFormat::FIXED ? "heapfile" : "slottedfile";
+        std::string by_name = name + ".name.idx";
+        std::string by_price = name + ".price.idx";
+        std::remove(name.c_str());
+        std::remove(by_name.c_str());
+        std::remove(by_price.c_str());
+        db::DbFileOptions options;
+        options.format = format;
+        db::getDatabase().add(std::make_unique<db::HeapFile>(name, td, options));
+        auto &file = dynamic_cast<db::HeapFile &>(db::getDatabase().get(name));
+        auto label = [](int i) { return "label" + std::to_string(i % 97); };
+
+        // An index built from the tuples of the file, and one maintained from the start
+        constexpr int count = 3000;
+        for (int i = 0; i < count / 2; ++i) {
+            file.insertTuple({{i, label(i), (i % 10) * 0.5}});
+        }
+        db::BTreeFile &name_index = file.createIndex(by_name, {"name"});
+        db::BTreeFile &price_index = file.createIndex(by_price, {"price", "id"});
+        EXPECT_THROW(file.createIndex(name + ".bad.idx", {"missing"}), std::out_of_range);
+        // The name of an open file is rejected before the index is loaded, which would overwrite the pages of the file
+        EXPECT_THROW(file.createIndex(by_name, {"id"}), std::logic_error);
+        EXPECT_THROW(file.createIndex(name, {"id"}), std::logic_error);
+        EXPECT_EQ(file.getIndexes().size(), 2);
+        {
+            int i = 0;
+            for (const auto &t: file) {
+                EXPECT_EQ(std::get<int>(t.get_field(0)), i);
+                i++;
+            }
+            EXPECT_EQ(i, count / 2);
+            EXPECT_NE(name_index.find({db::field_t{label(3)}, 0, 3}), name_index.end());
+        }
+        ASSERT_EQ(file.getIndexes().size(), 2);
+        EXPECT_EQ(file.getIndexes()[1].fields, (std::vector<size_t>{2, 0}));
+        for (int i = count / 2; i < count; ++i) {
+            file.insertTuple({{i, label(i), (i % 10) * 0.5}});
+        }
+        std::vector<db::Tuple> batch;
+        for (int i = count; i < count + 500; ++i) {
+            batch.push_back({{i, label(i), (i % 10) * 0.5}});
+        }
+        file.insertBatch(batch);
+        // Delete most tuples from the start of the file, so that vacuum moves the last ones
+        for (auto it = file.begin(); it != file.end(); ++it) {
+            int id = std::get<int>((*it).get_field(0));
+            if (id < count - 200 || id % 3 == 0) {
+                file.deleteTuple(it);
+            }
+        }
+        EXPECT_GT(file.vacuum(), 0);
+
+        // The indexes have one entry per tuple, at its position
+        size_t tuples = 0;
+        for (auto it = file.begin(); it != file.end(); ++it) {
+            db::Tuple t = *it;
+            int page = static_cast<int>(it.page);
+            int slot = static_cast<int>(it.slot);
+            EXPECT_NE(name_index.find({t.get_field(1), page, slot}), name_index.end());
+            EXPECT_NE(price_index.find({t.get_field(2), t.get_field(0), page, slot}), price_index.end());
+            tuples++;
+        }
+        size_t entries = 0;
+        for (auto it = name_index.begin(); it != name_index.end(); ++it) {
+            entries++;
+        }
+        EXPECT_EQ(entries, tuples);
+        entries = 0;
+        for (auto it = price_index.begin(); it != price_index.end(); ++it) {
+            entries++;
+        }
+        EXPECT_EQ(entries, tuples);
+
+        // The tuples with a key are found through the index
+        size_t found = 0;
+        for (const auto &entry: name_index.range({label(5)}, {label(5)})) {
+            db::Iterator it(file, std::get<int>(entry.get_field(1)), std::get<int>(entry.get_field(2)));
+            EXPECT_EQ(std::get<std::string>((*it).get_field(1)), label(5));
+            found++;
+        }
+        EXPECT_GT(found, 0);
+
+        // A tuple missing from one index is not removed from any
+        {
+            db::Iterator it = file.begin();
+            db::Tuple t = *it;
+            int page = static_cast<int>(it.page);
+            int slot = static_cast<int>(it.slot);
+            db::Tuple entry({t.get_field(2), t.get_field(0), page, slot});
+            price_index.deleteTuple(price_index.find({t.get_field(2), t.get_field(0), page, slot}));
+            EXPECT_THROW(file.deleteTuple(it), std::logic_error);
+            EXPECT_NE(name_index.find({t.get_field(1), page, slot}), name_index.end());
+            price_index.insertTuple(entry);
+        }
+
+        // A dropped index is no longer maintained
+        auto countKey = [](const db::BTreeFile &index, const db::field_t &key) {
+            size_t n = 0;
+            for (auto it = index.lowerBound({key}); it != index.upperBound({key}); ++it) {
+                n++;
+            }
+            return n;
+        };
+        size_t by_name_before = countKey(name_index, label(0));
+        size_t by_price_before = countKey(price_index, 0.0);
+        file.dropIndex(by_price);
+        EXPECT_THROW(file.dropIndex(by_price), std::invalid_argument);
+        file.insertTuple({{-1, label(0), 0.0}});
+        EXPECT_EQ(countKey(name_index, label(0)), by_name_before + 1);
+        EXPECT_EQ(countKey(price_index, 0.0), by_price_before);
+        file.dropIndex(by_name);
+        db::getDatabase().remove(by_name);
+        db::getDatabase().remove(by_price);
+        db::getDatabase().remove(name);
+    }
+}
@@ -0,0 +1,349 @@
+#include <db/Checksum.hpp>
+#include <db/Database.hpp>
+#include <db/DbFile.hpp>
+#include <db/HeapFile.hpp>
+#include <db/IoEngine.hpp>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <fcntl.h>
+#include <unistd.h>
+
+static void roundTrip(db::IoEngine &engine) {
+    const char *name = "iofile";
+    std::remove(name);
+    int fd = open(name, O_RDWR | O_CREAT, 0644);
+    ASSERT_NE(fd, -1);
+
+    constexpr size_t pages = 3 * db::UringIoEngine::QUEUE_DEPTH;
+    std::vector<db::Page> out(pages);
+    std::vector<db::IoRequest> writes;
+    for (size_t i = 0; i < pages; i++) {
+        out[i].fill(static_cast<uint8_t>(i));
+        writes.push_back({fd, out[i].data(), db::DEFAULT_PAGE_SIZE, static_cast<off_t>(i * db::DEFAULT_PAGE_SIZE), true});
+    }
+    // submit in reverse order: the requests are not adjacent and cannot be merged
+    std::reverse(writes.begin(), writes.end());
+    engine.submit(writes);
+
+    // the last two pages are past the end of the file and read as zeros
+    std::vector<db::Page> in(pages + 2);
+    std::vector<db::IoRequest> reads;
+    for (size_t i = 0; i < in.size(); i++) {
+        in[i].fill(0xff);
+        reads.push_back({fd, in[i].data(), db::DEFAULT_PAGE_SIZE, static_cast<off_t>(i * db::DEFAULT_PAGE_SIZE), false});
+    }
+    engine.submit(reads);
+    for (size_t i = 0; i < pages; i++) {
+        EXPECT_EQ(in[i], out[i]);
+    }
+    EXPECT_EQ(in[pages], db::Page{});
+    EXPECT_EQ(in[pages + 1], db::Page{});
+    close(fd);
+    std::remove(name);
+}
+
+TEST(IoEngineTest, Sync) {
+    db::SyncIoEngine engine;
+    roundTrip(engine);
+}
+
+TEST(IoEngineTest, Uring) {
+    auto engine = db::makeIoEngine(db::IoEngineType::IO_URING);
+    EXPECT_EQ(engine->type(), db::UringIoEngine::supported() ? db::IoEngineType::IO_URING : db::IoEngineType::SYNC);
+    roundTrip(*engine);
+}
+
+TEST(IoEngineTest, Errors) {
+    db::Page page{};
+    for (auto type: {db::IoEngineType::SYNC, db::IoEngineType::IO_URING}) {
+        auto engine = db::makeIoEngine(type);
+        EXPECT_THROW(engine->submit({{-1, page.data(), db::DEFAULT_PAGE_SIZE, 0, false}}), std::runtime_error);
+
+        int fd = open("/dev/null", O_RDONLY);
+        ASSERT_NE(fd, -1);
+        EXPECT_THROW(engine->submit({{fd, page.data(), db::DEFAULT_PAGE_SIZE, 0, true}}), std::runtime_error);
+        close(fd);
+    }
+}
+
+TEST(IoEngineTest, DirectFile) {
+    db::TupleDesc td({db::type_t::INT}, {"id"});
+    const char *name = "directfile";
+    std::remove(name);
+    {
+        db::DbFile file(name, td, {db::IoEngineType::IO_URING, true});
+        // an unaligned page goes through a bounce buffer when the file uses O_DIRECT
+        std::vector<uint8_t> buffer(2 * db::DEFAULT_PAGE_SIZE);
+        auto *page = reinterpret_cast<db::Page *>(buffer.data() + 1);
+        page->fill(42);
+        file.writePage(*page, 3);
+        db::Page expected;
+        expected.fill(42);
+        db::Page read{};
+        file.readPages({{3, &read}, {0, page}});
+        EXPECT_EQ(read, expected);
+        EXPECT_EQ(*page, db::Page{});
+        EXPECT_EQ(file.getReads(), std::vector<size_t>({3, 0}));
+        EXPECT_EQ(file.getWrites(), std::vector<size_t>({3}));
+    }
+    db::DbFile file(name, td);
+    EXPECT_EQ(file.getNumPages(), 4);
+    std::remove(name);
+}
+
+TEST(ChecksumTest, Crc32c) {
+    const std::string check = "123456789";
+    const auto *data = reinterpret_cast<const uint8_t *>(check.data());
+    EXPECT_EQ(db::crc32c(data, check.size()), 0xe3069283);
+    // a buffer can be checksummed in parts
+    EXPECT_EQ(db::crc32c(data + 4, 5, db::crc32c(data, 4)), 0xe3069283);
+    EXPECT_EQ(db::crc32c(data, 0), 0);
+    std::vector<uint8_t> zeros(32);
+    EXPECT_EQ(db::crc32c(zeros.data(), zeros.size()), 0x8a9136aa);
+
+    // long buffers are checksummed in parallel streams
+    std::vector<uint8_t> page(3 * db::DEFAULT_PAGE_SIZE + 5);
+    for (size_t i = 0; i < page.size(); i++) {
+        page[i] = static_cast<uint8_t>(i * 31 + 7);
+    }
+    uint32_t crc = 0;
+    for (size_t i = 0; i < page.size(); i += 100) {
+        crc = db::crc32c(page.data() + i, std::min<size_t>(100, page.size() - i), crc);
+    }
+    EXPECT_EQ(db::crc32c(page.data(), page.size()), crc);
+}
+
+TEST(DbFileTest, Checksums) {
+    db::TupleDesc td({db::type_t::INT}, {"id"});
+    const char *name = "checksumfile";
+    std::string crc_name = std::string(name) + ".crc";
+    std::remove(name);
+    std::remove(crc_name.c_str());
+    db::DbFileOptions options;
+    options.checksums = true;
+    db::Page page;
+    page.fill(7);
+    {
+        db::DbFile file(name, td, options);
+        EXPECT_TRUE(file.hasChecksums());
+        file.writePage(page, 0);
+        db::Page other;
+        other.fill(8);
+        db::Page empty{};
+        file.writePages({{1, &other}, {2, &other}, {3, &empty}});
+        db::Page read{};
+        file.readPage(read, 0);
+        EXPECT_EQ(read, page);
+        // a page that was never written has no checksum
+        file.readPage(read, 10);
+        EXPECT_EQ(read, db::Page{});
+    }
+
+    // flip a byte of page 1, and tear page 2 by truncating the file in its middle
+    int fd = open(name, O_RDWR);
+    ASSERT_NE(fd, -1);
+    uint8_t byte = 9;
+    EXPECT_EQ(pwrite(fd, &byte, 1, db::DEFAULT_PAGE_SIZE + 100), 1);
+    EXPECT_EQ(ftruncate(fd, 2 * db::DEFAULT_PAGE_SIZE + db::DEFAULT_PAGE_SIZE / 2), 0);
+    close(fd);
+
+    db::DbFile file(name, td, options);
+    db::Page read{};
+    file.readPage(read, 0);
+    EXPECT_EQ(read, page);
+    EXPECT_THROW(file.readPage(read, 1), std::runtime_error);
+    EXPECT_THROW(file.readPages({{0, &read}, {2, &read}}), std::runtime_error);
+    // the checksums are off unless requested
+    db::DbFile unchecked(name, td);
+    EXPECT_FALSE(unchecked.hasChecksums());
+    unchecked.readPage(read, 1);
+    // the checksums of truncated pages are removed
+    file.truncate(1);
+    file.writePage(page, 1);
+    file.readPage(read, 1);
+    EXPECT_EQ(read, page);
+    std::remove(name);
+    std::remove(crc_name.c_str());
+}
+
+TEST(DbFileTest, ChecksumsRecreated) {
+    db::TupleDesc td({db::type_t::INT}, {"id"});
+    const char *name = "checksumfile.recreated";
+    std::string crc_name = std::string(name) + ".crc";
+    std::remove(name);
+    std::remove(crc_name.c_str());
+    db::DbFileOptions options;
+    options.checksums = true;
+    db::Page page;
+    page.fill(7);
+    {
+        db::DbFile file(name, td, options);
+        file.writePages({{0, &page}, {1, &page}, {2, &page}});
+    }
+
+    // the data file is created again, but its checksum file is left behind
+    std::remove(name);
+    {
+        db::DbFile file(name, td, options);
+        db::Page read;
+        file.readPage(read, 0);
+        EXPECT_EQ(read, db::Page{});
+        db::Page other;
+        other.fill(8);
+        file.writePage(other, 0);
+        file.readPage(read, 0);
+        EXPECT_EQ(read, other);
+        file.readPage(read, 1);
+        EXPECT_EQ(read, db::Page{});
+    }
+    // the stale checksums were removed from the checksum file too
+    EXPECT_EQ(std::filesystem::file_size(crc_name), sizeof(uint32_t));
+    {
+        db::DbFile file(name, td, options);
+        db::Page read;
+        file.readPage(read, 1);
+        EXPECT_EQ(read, db::Page{});
+    }
+
+    // heap pages written through the buffer pool are read back from the new file
+    std::remove(name);
+    {
+        db::DbFile file(name, td, options);
+        file.writePages({{0, &page}, {1, &page}, {2, &page}, {3, &page}});
+    }
+    std::remove(name);
+    db::getDatabase().add(std::make_unique<db::HeapFile>(name, td, options));
+    auto &heap = db::getDatabase().get(name);
+    for (int i = 0; i < 3000; ++i) {
+        heap.insertTuple({{i}});
+    }
+    db::getDatabase().getBufferPool().flushFile(name);
+    db::getDatabase().getBufferPool().discardPage({heap.getId(), 0});
+    int i = 0;
+    for (const auto &t: heap) {
+        EXPECT_EQ(std::get<int>(t.get_field(0)), i);
+        i++;
+    }
+    EXPECT_EQ(i, 3000);
+    db::getDatabase().remove(name);
+    std::remove(name);
+    std::remove(crc_name.c_str());
+    std::remove((std::string(name) + ".fsm").c_str());
+}
+
+TEST(CompressionTest, Lz4) {
+    std::mt19937 gen(42);
+    std::vector<std::vector<uint8_t>> inputs;
+    inputs.emplace_back();
+    inputs.emplace_back(13, 0);
+    inputs.emplace_back(db::CompressedPages::GROUP_SIZE, 0);
+    std::vector<uint8_t> random(db::DEFAULT_PAGE_SIZE);
+    for (uint8_t &byte: random) {
+        byte = static_cast<uint8_t>(gen());
+    }
+    inputs.push_back(random);
+    // tuples with short strings padded with zeros, and repeated patterns longer than 15 bytes
+    std::vector<uint8_t> tuples(db::CompressedPages::GROUP_SIZE);
+    for (size_t i = 0; i + 76 <= tuples.size(); i += 76) {
+        int id = static_cast<int>(i);
+        std::memcpy(&tuples[i], &id, sizeof(id));
+        std::string name = "name" + std::to_string(gen() % 1000);
+        std::memcpy(&tuples[i + 4], name.data(), name.size());
+    }
+    inputs.push_back(tuples);
+
+    for (const auto &input: inputs) {
+        std::vector<uint8_t> compressed(db::lz4Bound(input.size()));
+        size_t length = db::lz4Compress(input.data(), input.size(), compressed.data());
+        EXPECT_LE(length, db::lz4Bound(input.size()));
+        std::vector<uint8_t> output(input.size());
+        db::lz4Decompress(compressed.data(), length, output.data(), output.size());
+        EXPECT_EQ(output, input);
+        if (input.size() == db::CompressedPages::GROUP_SIZE) {
+            EXPECT_LT(length, input.size() / 4);
+        }
+        // a truncated block or a wrong length is detected
+        if (length > 1) {
+            EXPECT_THROW(db::lz4Decompress(compressed.data(), length - 1, output.data(), output.size()),
+                         std::runtime_error);
+        }
+        output.push_back(0);
+        EXPECT_THROW(db::lz4Decompress(compressed.data(), length, output.data(), output.size()), std::runtime_error);
+    }
+}
+
+TEST(DbFileTest, Compressed) {
+    db::TupleDesc td({db::type_t::INT}, {"id"});
+    const char *name = "compressedfile";
+    std::remove(name);
+    db::DbFileOptions options;
+    options.compressed = true;
+    auto page = [](size_t id) {
+        db::Page page{};
+        for (size_t i = 0; i < 64; i++) {
+            page[i * 7] = static_cast<uint8_t>(id + i);
+        }
+        return page;
+    };
+    constexpr size_t pages = 2 * db::CompressedPages::GROUP_PAGES + 3;
+    std::vector<db::Page> written;
+    for (size_t id = 0; id < pages; id++) {
+        written.push_back(page(id));
+    }
+    {
+        db::DbFile file(name, td, options);
+        EXPECT_TRUE(file.isCompressed());
+        std::vector<std::pair<size_t, const db::Page *>> batch;
+        for (size_t id = 0; id < pages; id++) {
+            batch.emplace_back(id, &written[id]);
+        }
+        file.writePages(batch);
+        // a single page rewrites its group
+        written[5] = page(100);
+        file.writePage(written[5], 5);
+        db::Page read{};
+        for (size_t id = 0; id < pages; id++) {
+            file.readPage(read, id);
+            EXPECT_EQ(read, written[id]);
+        }
+        file.readPage(read, pages);
+        EXPECT_EQ(read, db::Page{});
+    }
+    EXPECT_LT(std::filesystem::file_size(name), pages * db::DEFAULT_PAGE_SIZE / 4);
+    db::DbFileOptions mapped = options;
+    mapped.mmap = true;
+    EXPECT_THROW(db::DbFile(name, td, mapped), std::invalid_argument);
+
+    for (bool index: {true, false}) {
+        if (!index) {
+            // without the index (e.g. after a crash), the blocks are scanned
+            std::filesystem::resize_file(name, std::filesystem::file_size(name) - 1);
+        }
+        db::DbFile file(name, td, options);
+        EXPECT_EQ(file.getNumPages(), pages);
+        std::vector<db::Page> read(pages);
+        std::vector<std::pair<size_t, db::Page *>> batch;
+        for (size_t id = 0; id < pages; id++) {
+            batch.emplace_back(id, &read[id]);
+        }
+        file.readPages(batch);
+        EXPECT_EQ(read, written);
+    }
+
+    {
+        db::DbFile file(name, td, options);
+        file.truncate(db::CompressedPages::GROUP_PAGES + 2);
+        db::Page read{};
+        file.readPage(read, db::CompressedPages::GROUP_PAGES + 2);
+        EXPECT_EQ(read, db::Page{});
+        file.readPage(read, db::CompressedPages::GROUP_PAGES + 1);
+        EXPECT_EQ(read, written[db::CompressedPages::GROUP_PAGES + 1]);
+    }
+    db::DbFile file(name, td, options);
+    EXPECT_EQ(file.getNumPages(), db::CompressedPages::GROUP_PAGES + 2);
+    std::remove(name);
+}
@@ -1,6 +1,9 @@
 #include <db/BTreeFile.hpp>
 #include <db/Database.hpp>
+#include <db/HeapFile.hpp>
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
 
 TEST(BTreeTest, Empty) {
     const char *name = "test.db";
@@ -102,3 +105,426 @@ TEST(BTreeTest, RandomAccess) {
 //    EXPECT_LE(file.getWrites().size(), 47142);
     EXPECT_NEAR(file.getWrites().size(), 45000, 10000);
 }
+
+TEST(BTreeTest, SmallBufferPool) {
+    const char *name = "test.db";
+    std::remove(name);
+    // splitting the root keeps 7 pages pinned at the same time
+    db::getDatabase().getBufferPool().resize(7);
+    db::TupleDesc td({db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE}, {"id", "name", "price"});
+    db::getDatabase().add(std::make_unique<db::BTreeFile>(name, td, 0));
+    auto &file = db::getDatabase().get(name);
+    for (int i = 0; i < 100000; i++) {
+        int k = i % 2 ? 100000 - i : i;
+        db::Tuple t{{k, "apple", 1.0}};
+        file.insertTuple(t);
+    }
+    int i = 0;
+    for (const auto &t: file) {
+        EXPECT_EQ(std::get<int>(t.get_field(0)), i);
+        i++;
+    }
+    EXPECT_EQ(i, 100000);
+}
+
+TEST(BTreeTest, Mapped) {
+    const char *name = "test.db";
+    std::remove(name);
+    db::TupleDesc td({db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE}, {"id", "name", "price"});
+    db::getDatabase().add(std::make_unique<db::BTreeFile>(name, td, 0));
+    for (int i = 10000; i-- > 0;) {
+        db::getDatabase().get(name).insertTuple({{i, "apple", 1.0}});
+    }
+    db::getDatabase().remove(name);
+
+    db::DbFileOptions options;
+    options.mmap = true;
+    db::getDatabase().add(std::make_unique<db::BTreeFile>(name, td, 0, options));
+    auto &file = db::getDatabase().get(name);
+    int i = 0;
+    for (const auto &t: file) {
+        EXPECT_EQ(std::get<int>(t.get_field(0)), i);
+        i++;
+    }
+    EXPECT_EQ(i, 10000);
+    EXPECT_TRUE(file.getReads().empty());
+    EXPECT_THROW(file.insertTuple({{0, "apple", 1.0}}), std::logic_error);
+}
+
+TEST(BTreeTest, Find) {
+    const char *name = "test.db";
+    std::remove(name);
+    db::TupleDesc td({db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE}, {"id", "name", "price"});
+    db::getDatabase().add(std::make_unique<db::BTreeFile>(name, td, 0));
+    auto &file = dynamic_cast<db::BTreeFile &>(db::getDatabase().get(name));
+    EXPECT_EQ(file.find(0), file.end());
+    EXPECT_EQ(file.lowerBound(0), file.end());
+
+    // Even keys only, inserted out of order
+    const int n = 100000;
+    for (int i = 0; i < n; i++) {
+        int k = i % 2 ? n - i : i;
+        file.insertTuple({{2 * k, "apple", 1.0}});
+    }
+
+    for (int k = 0; k < 2 * n; k += 997) {
+        size_t reads = file.getReads().size();
+        auto it = file.find(k);
+        // One page per level of the tree, instead of a scan of the leaves
+        EXPECT_LE(file.getReads().size() - reads, 4);
+        if (k % 2) {
+            EXPECT_EQ(it, file.end());
+            EXPECT_EQ(std::get<int>((*file.lowerBound(k)).get_field(0)), k + 1);
+        } else {
+            ASSERT_NE(it, file.end());
+            EXPECT_EQ(std::get<int>((*it).get_field(0)), k);
+            EXPECT_EQ(std::get<int>((*file.upperBound(k)).get_field(0)), k + 2);
+        }
+    }
+    EXPECT_EQ(file.find(-1), file.end());
+    EXPECT_EQ(file.find(2 * n), file.end());
+    EXPECT_EQ(file.lowerBound(2 * n - 1), file.end());
+    EXPECT_EQ(std::get<int>((*file.lowerBound(-5)).get_field(0)), 0);
+
+    auto collect = [&](int lo, int hi) {
+        std::vector<int> keys;
+        for (const auto &t: file.range(lo, hi)) {
+            keys.push_back(std::get<int>(t.get_field(0)));
+        }
+        return keys;
+    };
+    EXPECT_EQ(collect(11, 20), (std::vector<int>{12, 14, 16, 18, 20}));
+    EXPECT_EQ(collect(2 * n - 9, 3 * n), (std::vector<int>{2 * n - 8, 2 * n - 6, 2 * n - 4, 2 * n - 2}));
+    EXPECT_EQ(collect(-10, 2), (std::vector<int>{0, 2}));
+    EXPECT_TRUE(collect(5, 4).empty());
+    EXPECT_TRUE(collect(7, 7).empty());
+    EXPECT_EQ(collect(0, 2 * n).size(), n);
+
+    // Replacing the first tuple of a leaf (its key was copied to an index page) keeps a single copy of it
+    auto it = file.lowerBound(n);
+    while (it.slot != 0) {
+        ++it;
+    }
+    int key = std::get<int>((*it).get_field(0));
+    file.insertTuple({{key, "pear", 2.0}});
+    EXPECT_EQ(std::get<std::string>((*file.find(key)).get_field(1)), "pear");
+    EXPECT_EQ(collect(key, key).size(), 1);
+}
+
+TEST(BTreeTest, BulkLoad) {
+    const char *in_name = "bulkfile";
+    const char *name = "test.db";
+    std::remove(in_name);
+    std::remove((std::string(in_name) + ".fsm").c_str());
+    std::remove(name);
+    db::TupleDesc td({db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE}, {"id", "name", "price"});
+    db::getDatabase().add(std::make_unique<db::HeapFile>(in_name, td));
+    auto &in = dynamic_cast<db::HeapFile &>(db::getDatabase().get(in_name));
+
+    // Enough tuples for more than one sorted run, with every (even) key twice: the second copy must win
+    const int n = 600000;
+    std::vector<int> keys(2 * n);
+    for (int i = 0; i < 2 * n; i++) {
+        keys[i] = 2 * (i % n);
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(42));
+    std::vector<int> seen(2 * n);
+    std::vector<db::Tuple> tuples;
+    for (int k: keys) {
+        tuples.push_back({{k, seen[k]++ ? "second" : "first", k * 0.5}});
+    }
+    in.insertBatch(tuples);
+    ASSERT_GT(in.getNumPages() * db::DEFAULT_PAGE_SIZE, db::BULK_RUN_BYTES);
+
+    db::getDatabase().add(std::make_unique<db::BTreeFile>(name, td, 0));
+    auto &file = dynamic_cast<db::BTreeFile &>(db::getDatabase().get(name));
+    file.bulkLoad(in);
+    EXPECT_THROW(file.bulkLoad(in), std::logic_error);
+
+    // Every page is written once, in order, and the root last
+    const auto &writes = file.getWrites();
+    ASSERT_EQ(writes.size(), file.getNumPages());
+    for (size_t i = 0; i + 1 < writes.size(); i++) {
+        EXPECT_EQ(writes[i], i + 1);
+    }
+    EXPECT_EQ(writes.back(), 0);
+
+    int i = 0;
+    for (const auto &t: file) {
+        EXPECT_EQ(std::get<int>(t.get_field(0)), 2 * i);
+        EXPECT_EQ(std::get<std::string>(t.get_field(1)), "second");
+        i++;
+    }
+    EXPECT_EQ(i, n);
+    EXPECT_EQ(std::get<double>((*file.find(24690)).get_field(2)), 24690 * 0.5);
+    db::getDatabase().remove(in_name);
+
+    // Sorted input is streamed; half-full pages take inserts without splits
+    const char *copy_name = "test_copy.db";
+    std::remove(copy_name);
+    db::getDatabase().add(std::make_unique<db::BTreeFile>(copy_name, td, 0));
+    auto &copy = dynamic_cast<db::BTreeFile &>(db::getDatabase().get(copy_name));
+    EXPECT_THROW(copy.bulkLoad(file, 0), std::invalid_argument);
+    copy.bulkLoad(file, 0.5);
+    EXPECT_GT(copy.getNumPages(), file.getNumPages() * 19 / 10);
+    size_t pages = copy.getNumPages();
+    for (int k = 0; k < 1000; k++) {
+        copy.insertTuple({{2 * 599 * k + 1, "third", 0.0}});
+    }
+    EXPECT_EQ(copy.getNumPages(), pages);
+    i = 0;
+    int prev = -1;
+    for (const auto &t: copy) {
+        EXPECT_GT(std::get<int>(t.get_field(0)), prev);
+        prev = std::get<int>(t.get_field(0));
+        i++;
+    }
+    EXPECT_EQ(i, n + 1000);
+    EXPECT_EQ(std::get<std::string>((*copy.find(2 * 599 * 999 + 1)).get_field(1)), "third");
+    db::getDatabase().remove(copy_name);
+}
+
+TEST(BTreeTest, BulkLoadSortedPrefix) {
+    const char *in_name = "bulkfile";
+    const char *name = "test.db";
+    std::remove(in_name);
+    std::remove((std::string(in_name) + ".fsm").c_str());
+    std::remove(name);
+    db::TupleDesc td({db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE}, {"id", "name", "price"});
+    db::getDatabase().add(std::make_unique<db::HeapFile>(in_name, td));
+    auto &in = dynamic_cast<db::HeapFile &>(db::getDatabase().get(in_name));
+
+    // A sorted prefix long enough for its leaves to be written, followed by keys out of order: the odd keys, and
+    // a second copy of some even keys of the prefix, which must win
+    const int n = 50000;
+    std::vector<db::Tuple> tuples;
+    for (int k = 0; k < 2 * n; k += 2) {
+        tuples.push_back({{k, "first", 0.0}});
+    }
+    for (int k = 2 * n - 1; k > 0; k -= 2) {
+        tuples.push_back({{k, "odd", 0.0}});
+        if (k % 7 == 1) {
+            tuples.push_back({{k - 1, "second", 0.0}});
+        }
+    }
+    in.insertBatch(tuples);
+
+    db::getDatabase().add(std::make_unique<db::BTreeFile>(name, td, 0));
+    auto &file = dynamic_cast<db::BTreeFile &>(db::getDatabase().get(name));
+    file.bulkLoad(in);
+    int i = 0;
+    for (const auto &t: file) {
+        int k = std::get<int>(t.get_field(0));
+        EXPECT_EQ(k, i);
+        std::string expected = k % 2 ? "odd" : (k + 1) % 7 == 1 ? "second" : "first";
+        EXPECT_EQ(std::get<std::string>(t.get_field(1)), expected);
+        i++;
+    }
+    EXPECT_EQ(i, 2 * n);
+    EXPECT_NE(file.find(2 * n - 1), file.end());
+    db::getDatabase().remove(in_name);
+    db::getDatabase().remove(name);
+}
+
+TEST(BTreeTest, Delete) {
+    const char *name = "test.db";
+    std::remove(name);
+    db::TupleDesc td({db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE}, {"id", "name", "price"});
+    db::getDatabase().add(std::make_unique<db::BTreeFile>(name, td, 0));
+    auto &file = dynamic_cast<db::BTreeFile &>(db::getDatabase().get(name));
+    const int n = 200000;
+    for (int i = 0; i < n; i++) {
+        int k = i % 2 ? n - i : i;
+        file.insertTuple({{k, "apple", 1.0}});
+    }
+    size_t pages = file.getNumPages();
+
+    // Keep one key in ten, deleting from both ends towards the middle
+    for (int i = 0; i < n; i++) {
+        int k = i % 2 ? n - 1 - i / 2 : i / 2;
+        if (k % 10 != 0) {
+            auto it = file.find(k);
+            ASSERT_NE(it, file.end());
+            file.deleteTuple(it);
+            EXPECT_EQ(file.find(k), file.end());
+        }
+    }
+    int i = 0;
+    size_t leaves = 0;
+    size_t page = SIZE_MAX;
+    for (auto it = file.begin(); it != file.end(); ++it) {
+        EXPECT_EQ(std::get<int>((*it).get_field(0)), 10 * i);
+        leaves += it.page != page;
+        page = it.page;
+        i++;
+    }
+    EXPECT_EQ(i, n / 10);
+    // Merged leaves are at least half full
+    EXPECT_LE(leaves, n / 10 / 26 + 1);
+    EXPECT_EQ(std::get<int>((*file.lowerBound(11)).get_field(0)), 20);
+
+    // Delete while scanning, continuing from the key of the deleted tuple
+    for (auto it = file.begin(); it != file.end();) {
+        int k = std::get<int>((*it).get_field(0));
+        file.deleteTuple(it);
+        auto next = file.lowerBound(k);
+        it.page = next.page;
+        it.slot = next.slot;
+    }
+    EXPECT_EQ(file.begin(), file.end());
+    EXPECT_EQ(file.find(0), file.end());
+    EXPECT_THROW(file.deleteTuple(file.begin()), std::out_of_range);
+
+    // The freed pages are reused
+    for (i = 0; i < n; i++) {
+        int k = i % 2 ? n - i : i;
+        file.insertTuple({{k, "pear", 2.0}});
+    }
+    EXPECT_EQ(file.getNumPages(), pages);
+    i = 0;
+    for (const auto &t: file) {
+        EXPECT_EQ(std::get<int>(t.get_field(0)), i);
+        EXPECT_EQ(std::get<std::string>(t.get_field(1)), "pear");
+        i++;
+    }
+    EXPECT_EQ(i, n);
+}
+
+TEST(BTreeTest, DeleteInvalid) {
+    const char *name = "test.db";
+    std::remove(name);
+    db::TupleDesc td({db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE}, {"id", "name", "price"});
+    db::getDatabase().add(std::make_unique<db::BTreeFile>(name, td, 0));
+    auto &file = dynamic_cast<db::BTreeFile &>(db::getDatabase().get(name));
+    const int n = 60000;
+    for (int i = 0; i < n; i++) {
+        file.insertTuple({{i, "apple", 1.0}});
+    }
+    auto count = [&] {
+        int c = 0;
+        for (auto it = file.begin(); it != file.end(); ++it) {
+            EXPECT_EQ(std::get<int>((*it).get_field(0)), c);
+            c++;
+        }
+        return c;
+    };
+    // The pages that are not leaves are index pages
+    std::vector<bool> leaves(file.getNumPages());
+    for (auto it = file.begin(); it != file.end(); ++it) {
+        leaves[it.page] = true;
+    }
+    size_t index_page = std::find(leaves.begin() + 1, leaves.end(), false) - leaves.begin();
+    ASSERT_LT(index_page, file.getNumPages());
+
+    // Invalid iterators are rejected before the tree is changed
+    db::Iterator it = file.find(100);
+    EXPECT_THROW(file.deleteTuple({file, it.page, 1000}), std::out_of_range);
+    EXPECT_THROW(file.deleteTuple({file, index_page, 0}), std::logic_error);
+    EXPECT_THROW(file.deleteTuple({file, file.getNumPages(), 0}), std::logic_error);
+    EXPECT_EQ(count(), n);
+
+    // An iterator to a leaf freed by merges
+    db::Iterator stale = file.find(n - 1);
+    for (int i = n / 2; i < n; i++) {
+        file.deleteTuple(file.find(i));
+    }
+    EXPECT_THROW(file.deleteTuple(stale), std::logic_error);
+    EXPECT_EQ(count(), n / 2);
+    db::getDatabase().remove(name);
+}
+
+TEST(BTreeTest, CompositeKey) {
+    const char *name = "test.db";
+    std::remove(name);
+    db::TupleDesc td({db::type_t::CHAR, db::type_t::DOUBLE, db::type_t::INT}, {"name", "price", "id"});
+    db::getDatabase().add(std::make_unique<db::BTreeFile>(name, td, std::vector<size_t>{0, 2}));
+    auto &file = dynamic_cast<db::BTreeFile &>(db::getDatabase().get(name));
+    EXPECT_EQ(file.find({"apple", 0}), file.end());
+
+    // 500 names with 400 ids each, inserted out of order
+    const int names = 500;
+    const int ids = 400;
+    auto nameOf = [](int i) { return "name" + std::to_string(i); };
+    std::vector<std::pair<int, int>> keys;
+    for (int n = 0; n < names; n++) {
+        for (int id = 0; id < ids; id++) {
+            keys.emplace_back(n, id - ids / 2);
+        }
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(7));
+    for (auto [n, id]: keys) {
+        file.insertTuple({{nameOf(n), id * 0.5, id}});
+    }
+    // Replacing a tuple
+    file.insertTuple({{nameOf(7), 100.0, 3}});
+
+    // Tuples are in the order of the names as strings, then of the ids
+    std::vector<std::string> sorted;
+    for (int n = 0; n < names; n++) {
+        sorted.push_back(nameOf(n));
+    }
+    std::sort(sorted.begin(), sorted.end());
+    size_t i = 0;
+    for (const auto &t: file) {
+        EXPECT_EQ(std::get<std::string>(t.get_field(0)), sorted[i / ids]);
+        EXPECT_EQ(std::get<int>(t.get_field(2)), int(i % ids) - ids / 2);
+        i++;
+    }
+    EXPECT_EQ(i, names * ids);
+
+    auto it = file.find({nameOf(7), 3});
+    ASSERT_NE(it, file.end());
+    EXPECT_EQ(std::get<double>((*it).get_field(1)), 100.0);
+    EXPECT_EQ(file.find({nameOf(7), ids}), file.end());
+    EXPECT_EQ(file.find({"name", 0}), file.end());
+    EXPECT_THROW(file.find({nameOf(7)}), std::invalid_argument);
+    EXPECT_THROW(file.find({7, 7}), std::invalid_argument);
+
+    // A range over a prefix of the key
+    size_t count = 0;
+    for (const auto &t: file.range({nameOf(42)}, {nameOf(42)})) {
+        EXPECT_EQ(std::get<std::string>(t.get_field(0)), nameOf(42));
+        count++;
+    }
+    EXPECT_EQ(count, ids);
+    count = 0;
+    for (const auto &t: file.range({nameOf(42), -5}, {nameOf(42), 4})) {
+        EXPECT_EQ(std::get<int>(t.get_field(2)), int(count) - 5);
+        count++;
+    }
+    EXPECT_EQ(count, 10);
+
+    // Deletes keep the order
+    for (int id = -ids / 2; id < ids / 2; id += 2) {
+        file.deleteTuple(file.find({nameOf(42), id}));
+    }
+    count = 0;
+    for (const auto &t: file.range({nameOf(42)}, {nameOf(42)})) {
+        EXPECT_EQ(std::get<int>(t.get_field(2)) % 2 != 0, true);
+        count++;
+    }
+    EXPECT_EQ(count, ids / 2);
+}
+
+TEST(BTreeTest, DoubleKey) {
+    const char *name = "test.db";
+    std::remove(name);
+    db::TupleDesc td({db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE}, {"id", "name", "price"});
+    db::getDatabase().add(std::make_unique<db::BTreeFile>(name, td, 2));
+    auto &file = dynamic_cast<db::BTreeFile &>(db::getDatabase().get(name));
+    const int n = 50000;
+    for (int i = 0; i < n; i++) {
+        int k = i % 2 ? n - i : i;
+        file.insertTuple({{k, "apple", (k - n / 2) * 0.25}});
+    }
+    int i = 0;
+    for (const auto &t: file) {
+        EXPECT_EQ(std::get<double>(t.get_field(2)), (i - n / 2) * 0.25);
+        i++;
+    }
+    EXPECT_EQ(i, n);
+    EXPECT_EQ(std::get<int>((*file.find({db::field_t{-100.25}})).get_field(0)), n / 2 - 401);
+    EXPECT_EQ(std::get<int>((*file.lowerBound({db::field_t{-100.3}})).get_field(0)), n / 2 - 401);
+    EXPECT_EQ(file.find({db::field_t{-100.3}}), file.end());
+    EXPECT_THROW(file.find(1), std::invalid_argument);
+}
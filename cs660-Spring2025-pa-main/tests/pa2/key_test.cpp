@@ -0,0 +1,66 @@
+#include <db/KeyDesc.hpp>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+static std::vector<uint8_t> encode(const db::KeyDesc &key, const std::vector<db::field_t> &values) {
+    std::vector<uint8_t> encoded(key.length());
+    key.encode(encoded.data(), values);
+    return encoded;
+}
+
+TEST(KeyDescTest, Order) {
+    db::TupleDesc td({db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE}, {"id", "name", "price"});
+
+    // Encoded keys sort in the order of the values
+    db::KeyDesc ints(td, {0});
+    EXPECT_EQ(ints.length(), sizeof(int));
+    std::vector<int> int_values{std::numeric_limits<int>::min(), -1000, -1, 0, 1, 255, 256, 1000,
+                                std::numeric_limits<int>::max()};
+    for (size_t i = 1; i < int_values.size(); i++) {
+        EXPECT_LT(encode(ints, {int_values[i - 1]}), encode(ints, {int_values[i]}));
+    }
+
+    db::KeyDesc doubles(td, {2});
+    std::vector<double> double_values{-std::numeric_limits<double>::infinity(), -1e300, -2.5, -1e-300, 0.0, 1e-300,
+                                      0.5, 2.5, 1e300, std::numeric_limits<double>::infinity()};
+    for (size_t i = 1; i < double_values.size(); i++) {
+        EXPECT_LT(encode(doubles, {double_values[i - 1]}), encode(doubles, {double_values[i]}));
+    }
+    EXPECT_EQ(encode(doubles, {-0.0}), encode(doubles, {0.0}));
+
+    db::KeyDesc strings(td, {1});
+    EXPECT_EQ(strings.length(), db::CHAR_SIZE);
+    std::vector<std::string> string_values{"", "a", "ab", "abc", "b", "ba", std::string(db::CHAR_SIZE, 'z')};
+    for (size_t i = 1; i < string_values.size(); i++) {
+        EXPECT_LT(encode(strings, {string_values[i - 1]}), encode(strings, {string_values[i]}));
+    }
+
+    // Composite keys sort by their first field, then by the next ones
+    db::KeyDesc composite(td, {1, 0});
+    EXPECT_EQ(composite.length(), db::CHAR_SIZE + sizeof(int));
+    EXPECT_LT(encode(composite, {"a", 5}), encode(composite, {"a", 6}));
+    EXPECT_LT(encode(composite, {"a", 6}), encode(composite, {"b", -6}));
+    // A prefix padded with 0x00 or 0xff is the smallest or largest key that starts with it
+    std::vector<uint8_t> low(composite.length());
+    std::vector<uint8_t> high(composite.length());
+    composite.encode(low.data(), {"a"}, 0x00);
+    composite.encode(high.data(), {"a"}, 0xff);
+    EXPECT_LE(low, encode(composite, {"a", std::numeric_limits<int>::min()}));
+    EXPECT_GE(high, encode(composite, {"a", std::numeric_limits<int>::max()}));
+    EXPECT_LT(high, encode(composite, {"a ", std::numeric_limits<int>::min()}));
+
+    // Keys of serialized tuples and of values are the same
+    std::vector<uint8_t> tuple(td.length());
+    td.serialize(tuple.data(), {{-42, "pear", -1.5}});
+    std::vector<uint8_t> key(composite.length());
+    composite.encode(key.data(), tuple.data());
+    EXPECT_EQ(key, encode(composite, {"pear", -42}));
+
+    EXPECT_THROW(db::KeyDesc(td, {}), std::invalid_argument);
+    EXPECT_THROW(db::KeyDesc(td, {3}), std::invalid_argument);
+    EXPECT_THROW(db::KeyDesc(td, {1, 1, 1, 1, 1}), std::invalid_argument);
+    EXPECT_THROW(encode(ints, {1.0}), std::invalid_argument);
+    EXPECT_THROW(encode(ints, {1, 2}), std::invalid_argument);
+}
@@ -2,6 +2,7 @@
 #include <db/HeapFile.hpp>
 #include <db/Query.hpp>
 #include <gtest/gtest.h>
+#include <map>
 #include <random>
 
 TEST(AggregateTest, Min) {
@@ -270,3 +271,33 @@ TEST(AggregateTest, Grouped) {
     ++it;
     EXPECT_EQ(it, out.end());
 }
+
+TEST(AggregateTest, Pax) {
+    db::TupleDesc td1({db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE}, {"id", "name", "price"});
+    db::TupleDesc td2({db::type_t::CHAR, db::type_t::INT}, {"name", "result"});
+
+    const char *in_name = "paxfile.in";
+    const char *out_name = "paxfile.out";
+    std::remove(in_name);
+    std::remove(out_name);
+    db::DbFileOptions options;
+    options.format = db::PageFormat::PAX;
+    db::getDatabase().add(std::make_unique<db::HeapFile>(in_name, td1, options));
+    db::getDatabase().add(std::make_unique<db::HeapFile>(out_name, td2, options));
+    auto &in = db::getDatabase().get(in_name);
+    auto &out = db::getDatabase().get(out_name);
+
+    std::map<std::string, int> expected;
+    for (int i = 0; i < 1000; i++) {
+        std::string group = "group" + std::to_string(i % 7);
+        expected[group] += i;
+        in.insertTuple({{i, group, 3.14}});
+    }
+
+    db::aggregate(in, out, {"name", db::AggregateOp::SUM, "id"});
+    std::map<std::string, int> sums;
+    for (const auto &t: out) {
+        sums[std::get<std::string>(t.get_field(0))] = std::get<int>(t.get_field(1));
+    }
+    EXPECT_EQ(sums, expected);
+}
@@ -2,6 +2,9 @@
 #include <db/HeapFile.hpp>
 #include <db/Query.hpp>
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <numeric>
+#include <random>
 
 TEST(FilterTest, All) {
     std::vector<db::type_t> types{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};
@@ -85,3 +88,75 @@ TEST(FilterTest, None) {
 
     EXPECT_EQ(out.begin(), out.end());
 }
+
+TEST(FilterTest, Index) {
+    std::vector<db::type_t> types{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};
+    std::vector<std::string> names{"id", "name", "price"};
+    db::TupleDesc td(types, names);
+
+    const char *in_name = "heapfile.in";
+    std::remove(in_name);
+    std::remove("heapfile.in.id");
+    std::remove("heapfile.in.name");
+    db::getDatabase().add(std::make_unique<db::HeapFile>(in_name, td));
+    auto &in = dynamic_cast<db::HeapFile &>(db::getDatabase().get(in_name));
+    constexpr int count = 20000;
+    std::vector<int> ids(count);
+    std::iota(ids.begin(), ids.end(), 0);
+    std::shuffle(ids.begin(), ids.end(), std::mt19937(42));
+    auto label = [](int id) { return "name" + std::to_string(id % 500); };
+    for (int id: ids) {
+        in.insertTuple({{id, label(id), id * 0.5}});
+    }
+    in.createIndex("heapfile.in.id", {"id"});
+    in.createIndex("heapfile.in.name", {"name"});
+
+    // The output is in the order of the file, whether the index is used or not
+    int run = 0;
+    auto check = [&](const std::vector<db::FilterPredicate> &preds, auto pass) {
+        std::string out_name = "heapfile.out" + std::to_string(run++);
+        std::remove(out_name.c_str());
+        db::getDatabase().add(std::make_unique<db::HeapFile>(out_name, td));
+        auto &out = db::getDatabase().get(out_name);
+        db::filter(in, out, preds);
+        auto it = out.begin();
+        size_t expected = 0;
+        for (int id: ids) {
+            if (!pass(id)) {
+                continue;
+            }
+            ASSERT_NE(it, out.end());
+            EXPECT_EQ(std::get<int>((*it).get_field(0)), id);
+            ++it;
+            expected++;
+        }
+        EXPECT_EQ(it, out.end());
+        EXPECT_GT(expected, 0);
+        db::getDatabase().remove(out_name);
+    };
+    check({{"id", db::PredicateOp::EQ, 1234}}, [](int id) { return id == 1234; });
+    check({{"id", db::PredicateOp::GT, 100}, {"id", db::PredicateOp::LE, 150}, {"id", db::PredicateOp::GE, 90}},
+          [](int id) { return id > 100 && id <= 150; });
+    check({{"name", db::PredicateOp::EQ, std::string("name7")}, {"id", db::PredicateOp::NE, 7}},
+          [&](int id) { return label(id) == "name7" && id != 7; });
+    check({{"price", db::PredicateOp::LT, 10.0}}, [](int id) { return id < 20; });
+    // Not selective: the file is scanned
+    check({{"id", db::PredicateOp::GE, 100}}, [](int id) { return id >= 100; });
+
+    // Deleted tuples are removed from the indexes
+    for (auto it = in.begin(); it != in.end(); ++it) {
+        if (std::get<int>((*it).get_field(0)) % 2 == 0) {
+            in.deleteTuple(it);
+        }
+    }
+    check({{"id", db::PredicateOp::GE, 1000}, {"id", db::PredicateOp::LT, 1100}},
+          [](int id) { return id >= 1000 && id < 1100 && id % 2 != 0; });
+
+    // An empty range
+    std::string out_name = "heapfile.out";
+    std::remove(out_name.c_str());
+    db::getDatabase().add(std::make_unique<db::HeapFile>(out_name, td));
+    auto &out = db::getDatabase().get(out_name);
+    db::filter(in, out, {{"id", db::PredicateOp::GT, 50}, {"id", db::PredicateOp::LT, 40}});
+    EXPECT_EQ(out.begin(), out.end());
+}
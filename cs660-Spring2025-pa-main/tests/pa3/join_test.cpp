@@ -3,6 +3,7 @@
 #include <db/Query.hpp>
 #include <gtest/gtest.h>
 #include <random>
+#include <unordered_set>
 
 TEST(JoinTest, Small) {
     std::vector<db::type_t> types1{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};
@@ -158,3 +159,37 @@ TEST(JoinTest, Large) {
     }
     EXPECT_EQ(i, expected);
 }
+
+TEST(JoinTest, Self) {
+    std::vector<db::type_t> types1{db::type_t::INT, db::type_t::INT};
+    std::vector<std::string> names1{"id", "value"};
+    db::TupleDesc td1(types1, names1);
+
+    std::vector<db::type_t> types2{db::type_t::INT, db::type_t::INT, db::type_t::INT};
+    std::vector<std::string> names2{"id", "value", "other"};
+    db::TupleDesc td2(types2, names2);
+
+    const char *in_name = "self.in";
+    const char *out_name = "heapfile.self";
+    std::remove(in_name);
+    std::remove(out_name);
+    db::getDatabase().add(std::make_unique<db::HeapFile>(in_name, td1));
+    db::getDatabase().add(std::make_unique<db::HeapFile>(out_name, td2));
+    auto &in = db::getDatabase().get(in_name);
+    auto &out = db::getDatabase().get(out_name);
+
+    // Several pages on both sides: the same pages are scanned by the outer and the inner scan
+    const int n = 2000;
+    for (int i = 0; i < n; i++) {
+        in.insertTuple({{i, i % 7}});
+    }
+
+    db::join(in, in, out, {"id", db::PredicateOp::EQ, "id"});
+    int count = 0;
+    for (auto it = out.begin(); it != out.end(); ++it) {
+        db::Tuple t = out.getTuple(it);
+        EXPECT_EQ(std::get<int>(t.get_field(1)), std::get<int>(t.get_field(2)));
+        ++count;
+    }
+    EXPECT_EQ(count, n);
+}